@@ -0,0 +1,82 @@
+import matplotlib.pyplot as plt
+import seaborn as sns
+import pandas as pd
+import os
+import sys
+
+# Set the style for a scientific paper
+sns.set_theme(style="whitegrid", context="paper")
+
+plt.rcParams.update({
+    "figure.figsize": (3.4, 1.7),
+    "font.family": "serif",
+    "font.serif": ["Times New Roman"],
+    "font.size": 8,
+    "axes.labelsize": 8,
+    "legend.fontsize": 8,
+    "xtick.labelsize": 8,
+    "ytick.labelsize": 8,
+})
+
+def main():
+    # CSVs of precision_sweep, in the given directory or next to this script
+    script_dir = os.path.dirname(os.path.abspath(__file__))
+    data_dir = sys.argv[1] if len(sys.argv) > 1 else script_dir
+
+    recall_path = os.path.join(data_dir, "recall_bitlen.csv")
+    time_path = os.path.join(data_dir, "time_bitlen.csv")
+
+    try:
+        df_recall = pd.read_csv(recall_path)
+        df_time = pd.read_csv(time_path)
+    except FileNotFoundError as e:
+        print(f"Error: {e}")
+        return
+
+    # Same columns as recall.csv and akprag.csv, plus the score bitlen
+    df_time["k"] = 2 ** df_time["k_pow2"]
+
+    fig, (ax1, ax2) = plt.subplots(1, 2)
+
+    # Plot 1: Recall vs bitlen, 1 line per k', aggregated over queries
+    sns.lineplot(
+        data=df_recall,
+        x="bitlen",
+        y="recall",
+        hue="k",
+        ax=ax1,
+        marker="+",
+        errorbar="sd",
+        linewidth=1,
+        palette="viridis",
+    )
+    ax1.set_ylabel("Recall")
+    ax1.set_ylim(top=1.01)
+    ax1.set_xlabel("Score Bits")
+    ax1.legend(title="$k'$")
+
+    # Plot 2: Server time vs bitlen
+    sns.lineplot(
+        data=df_time,
+        x="bitlen",
+        y="time_ms",
+        hue="k",
+        ax=ax2,
+        marker="+",
+        errorbar="sd",
+        linewidth=1,
+        palette="viridis",
+    )
+    ax2.set_ylabel("Server Time (ms)")
+    ax2.set_xlabel("Score Bits")
+    if ax2.get_legend():
+        ax2.get_legend().remove()
+
+    plt.tight_layout(pad=0)
+
+    output_filename = os.path.join(data_dir, "precision_figure.pdf")
+    plt.savefig(output_filename, dpi=300)
+    print(f"Plot saved to: {output_filename}")
+
+if __name__ == "__main__":
+    main()
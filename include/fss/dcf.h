@@ -6,16 +6,37 @@
 
 #pragma once
 
+#include <stddef.h>
 #include <fss/prelude.h>
 #include <fss/group.h>
 #include <fss/prg.h>
 
 #define kDcfCwLen (kLambda * 2 + 1)
+// A frontier node is its seed with `t` in the MSB, then its accumulated value
+#define kDcfFrontierNodeLen (kLambda * 2)
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/**
+ * Keys of the same bitlen in the structure-of-arrays layout, so that the level-i correction words of all keys are contiguous.
+ * Allocated by users like @ref Key.
+ */
+typedef struct {
+  /**
+   * Correction words whose len = @ref kDcfCwLen * `bitlen` * `n`.
+   * Level i of key j is at (i * `n` + j) * @ref kDcfCwLen.
+   */
+  uint8_t *cws;
+  /**
+   * Last correction words whose len = lambda * `n`. Key j is at j * lambda.
+   */
+  uint8_t *cw_np1s;
+  int n;
+  int bitlen;
+} KeyBatch;
+
 /**
  * DCF keygen.
  * @param k Output allocated already. See @ref Key for allocation and no need to init.
@@ -26,6 +47,19 @@ extern "C" {
  */
 FSS_CUDA_HOST_DEVICE void dcf_gen(Key k, CmpFunc cf, uint8_t *sbuf);
 
+/**
+ * DCF keygen of `n` keys at once, e.g., the 2 keys of an interval comparison.
+ * The keys go through the tree in lockstep: each level expands the seeds of both parties of all keys with 1 @ref prg_n() call,
+ * so AES kernels have 2 * `n` seeds in flight.
+ * @param ks Output allocated already, the same as @ref dcf_gen() of each key
+ * @param cfs `n` comparison functions whose `alpha` have the same bitlen
+ * @param sbuf Buffer whose len >= `n` * (10 * lambda + 2).
+ * `s0s` of key j as input is stored at 2 * lambda bytes from `j` * 2 * lambda.
+ * No need to init other bytes.
+ * @param n Number of keys
+ */
+void dcf_gen_n(const Key *ks, const CmpFunc *cfs, uint8_t *sbuf, int n);
+
 /**
  * DCF eval at 1 input point.
  * @param sbuf Buffer whose len >= 6 * lambda.
@@ -40,8 +74,74 @@ FSS_CUDA_HOST_DEVICE void dcf_gen(Key k, CmpFunc cf, uint8_t *sbuf);
  */
 FSS_CUDA_HOST_DEVICE void dcf_eval(uint8_t *sbuf, uint8_t b, Key k, Bits x);
 
+/**
+ * DCF eval at `n` input points with 1 key.
+ * Each tree level expands the seeds of all points with 1 @ref prg_n() call, so wide AES kernels get enough independent blocks.
+ * @param sbuf Buffer whose len >= `n` * (6 * lambda + 1).
+ * `s0s[b]` as input is stored at first lambda bytes.
+ * Output of the j-th point is stored at lambda bytes from `j` * lambda.
+ * Output is the same as @ref dcf_eval().
+ * No need to init other bytes.
+ * @param b Party bit, 0/1
+ * @param k Gen by @ref dcf_gen()
+ * @param xs Evaluated input points of the same bitlen
+ * @param n Number of input points
+ */
+void dcf_eval_batch(uint8_t *sbuf, uint8_t b, Key k, const Bits *xs, int n);
+
+/**
+ * Convert keys to @ref KeyBatch.
+ * @param kb Output allocated already with `n` and `bitlen` set
+ * @param ks `kb.n` keys gen by @ref dcf_gen() with `alpha` bitlen = `kb.bitlen`
+ */
+void dcf_key_batch_from_keys(KeyBatch kb, const Key *ks);
+
+/**
+ * DCF eval of `kb.n` keys at 1 input point.
+ * The keys go through the tree in lockstep: each level expands the seeds of all keys with 1 @ref prg_n() call,
+ * which only computes the children on the side of the input bit, and reads the level's correction words as 1 contiguous stream.
+ * @param sbuf Buffer whose len >= `kb.n` * (6 * lambda + 1).
+ * `s0s[b]` of key j as input is stored at lambda bytes from `j` * lambda.
+ * Output of key j is stored at lambda bytes from `j` * lambda, the same as @ref dcf_eval() of the key.
+ * No need to init other bytes.
+ * @param b Party bit, 0/1
+ * @param kb Converted by @ref dcf_key_batch_from_keys()
+ * @param x Evaluated input point whose bitlen = `kb.bitlen`
+ */
+void dcf_eval_multikey(uint8_t *sbuf, uint8_t b, KeyBatch kb, Bits x);
+
+/**
+ * Precompute the 2 ^ `depth` nodes at `depth` of the tree of 1 key, so that @ref dcf_eval_frontier() skips the top levels.
+ * This is the memory/time tradeoff of repeated eval with the same key: the table takes 2 ^ `depth` * @ref kDcfFrontierNodeLen bytes,
+ * costs about 2 ^ `depth` node expansions to build, and saves `depth` levels per eval.
+ * Built on the same thread pool as @ref dcf_eval_full_domain().
+ * @param frontier Output whose len >= 2 ^ `depth` * @ref kDcfFrontierNodeLen.
+ * `s0s[b]` as input is stored at first lambda bytes.
+ * No need to init other bytes.
+ * Node `j` is the one whose path is the `depth` bits of `j`, MSB first.
+ * @param b Party bit, 0/1
+ * @param k Gen by @ref dcf_gen()
+ * @param depth Depth of the frontier, <= bitlen of `alpha`
+ */
+void dcf_frontier_build(uint8_t *frontier, uint8_t b, Key k, int depth);
+
+/**
+ * DCF eval at 1 input point starting from a frontier node, with the same output as @ref dcf_eval().
+ * @param sbuf Buffer whose len >= 6 * lambda.
+ * No need to init.
+ * Output is stored at first lambda bytes.
+ * @param b Party bit, 0/1
+ * @param k Gen by @ref dcf_gen()
+ * @param frontier Built by @ref dcf_frontier_build() with the same `b` and `k`
+ * @param depth Depth of `frontier`
+ * @param x Evaluated input point
+ */
+void dcf_eval_frontier(uint8_t *sbuf, uint8_t b, Key k, const uint8_t *frontier, int depth, Bits x);
+
 /**
  * DCF full domain eval i.e. eval at all input points.
+ * Runs on a thread pool of `omp_get_max_threads()` threads, shared by the full domain evals of DPF and half-tree DCF.
+ * Concurrent calls are safe and take turns on the pool level by level.
  * @param sbuf Buffer whose len >= 2 ^ `x_bitlen` * lambda.
  * `s0s[b]` as input is stored at first lambda bytes.
  * Output is contiguously stored at each lambda bytes of `sbuf`.
@@ -54,6 +154,39 @@ FSS_CUDA_HOST_DEVICE void dcf_eval(uint8_t *sbuf, uint8_t b, Key k, Bits x);
  */
 void dcf_eval_full_domain(uint8_t *sbuf, uint8_t b, Key k, int x_bitlen);
 
+/**
+ * Len of `sbuf` of @ref dcf_eval_full_domain_u64().
+ * It depends on the thread num of the pool, i.e., `omp_get_max_threads()`, and the grain of @ref dcf_full_domain_set_grain().
+ * With the default grain, it is about (2 ^ 12 * thread num + 2 ^ (`x_bitlen` - 11)) * lambda for large domains.
+ * @param x_bitlen Bitlen of input points
+ */
+size_t dcf_full_domain_u64_sbuf_len(int x_bitlen);
+
+/**
+ * DCF full domain eval with dense 8-byte outputs, i.e., half the output size of @ref dcf_eval_full_domain().
+ * Only for groups whose elements are in the low 8 bytes, e.g., `u64` and `z2_64`.
+ * Subtrees are evaluated in per-thread scratch that stays in cache and then compacted to `ys`.
+ * @param ys Output whose len = 2 ^ `x_bitlen`. `ys[x]` is the output at `x` as a little-endian group value.
+ * @param sbuf Scratch whose len >= @ref dcf_full_domain_u64_sbuf_len() of `x_bitlen`.
+ * `s0s[b]` as input is stored at first lambda bytes.
+ * No need to init other bytes.
+ * @param b Party bit, 0/1
+ * @param k Gen by @ref dcf_gen()
+ * @param x_bitlen Bitlen of input points, >= 1
+ */
+void dcf_eval_full_domain_u64(uint64_t *ys, uint8_t *sbuf, uint8_t b, Key k, int x_bitlen);
+
+/**
+ * Set the max height of subtrees that @ref dcf_eval_full_domain() runs as 1 task on its thread pool,
+ * which is also the grain of @ref dpf_eval_full_domain() and @ref dcf_ht_eval_full_domain().
+ * It is raised to the height of the breadth-first blocks of each eval, e.g., 4 for DCF.
+ * Larger grain means less scheduling overhead but coarser load balance.
+ * The top levels are expanded until there are at least 4 tasks per thread if the domain allows.
+ * The pool has `omp_get_max_threads()` threads.
+ * @param grain_bitlen Default `full_domain_grain_bitlen` of @ref tune_get() if set, otherwise 12
+ */
+void dcf_full_domain_set_grain(int grain_bitlen);
+
 #ifdef __cplusplus
 }
 #endif
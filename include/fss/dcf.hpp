@@ -0,0 +1,362 @@
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @file dcf.hpp
+ *
+ * Header-only DCF specialised at compile time on bitlen, lambda, group and PRG.
+ * Level loops are fully unrolled and group/PRG ops are inlined, while key layout and outputs are the same as @ref dcf.h.
+ * So with `Lambda` = kLambda and the same PRG state, keys from @ref dcf_gen() can be evaluated by @ref fss::Dcf::eval() and vice versa.
+ *
+ * Eval only expands the 2 PRG blocks of the taken child, rather than all 4 blocks like @ref dcf_eval().
+ *
+ * Requires AES-NI, i.e., compile with `-maes`.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <immintrin.h>
+#include <fss/prelude.h>
+
+#ifndef __AES__
+  #error "fss/dcf.hpp requires AES-NI. Compile with -maes."
+#endif
+
+namespace fss {
+
+/**
+ * Field mod 2^64 - 59. Same as `src/dcf/group/u64.c`.
+ * Elements are stored in the low 8 bytes of lambda bytes and the other bytes are 0.
+ */
+struct U64Group {
+  using Elem = uint64_t;
+  static constexpr uint64_t kPrime = 18446744073709551557ull;
+
+  static inline Elem load(__m128i block) {
+    uint64_t v = (uint64_t)_mm_cvtsi128_si64(block);
+    return v >= kPrime ? v - kPrime : v;
+  }
+
+  static inline Elem load(const uint8_t *bytes) {
+    uint64_t v;
+    std::memcpy(&v, bytes, 8);
+    return v >= kPrime ? v - kPrime : v;
+  }
+
+  static inline void store(uint8_t *bytes, Elem val, int len) {
+    std::memcpy(bytes, &val, 8);
+    std::memset(bytes + 8, 0, len - 8);
+  }
+
+  static inline Elem zero() {
+    return 0;
+  }
+
+  static inline Elem add(Elem val, Elem rhs) {
+    return val >= kPrime - rhs ? val + rhs - kPrime : val + rhs;
+  }
+
+  static inline Elem neg(Elem val) {
+    return val == 0 ? 0 : kPrime - val;
+  }
+};
+
+/**
+ * AES-128 Matyas-Meyer-Oseas PRG. Same as `src/dcf/prg/aes128_mmo.c`.
+ * Block `i` of the output = AES(key[i], seed) xor seed, where each 16B chunk of a seed uses its own key.
+ */
+template <int Lambda, int Blocks>
+struct Aes128Mmo {
+  static_assert(Lambda % 16 == 0, "Lambda must be a multiple of 16");
+  static constexpr int kChunks = Lambda / 16;
+  struct Seed {
+    __m128i c[kChunks];
+    __m128i &operator[](int j) {
+      return c[j];
+    }
+    const __m128i &operator[](int j) const {
+      return c[j];
+    }
+  };
+
+  alignas(16) static inline __m128i round_keys[Blocks][kChunks][11];
+
+  /**
+   * Same as @ref prg_init(). `state` len >= `Blocks` * `Lambda`.
+   */
+  static void init(const uint8_t *state) {
+    for (int i = 0; i < Blocks; i++) {
+      for (int j = 0; j < kChunks; j++) {
+        expand_key(round_keys[i][j], state + i * Lambda + j * 16);
+      }
+    }
+  }
+
+  /**
+   * Only compute block `i` of the output
+   */
+  [[gnu::always_inline]] static inline Seed block(int i, const Seed &seed) {
+    Seed out;
+    for (int j = 0; j < kChunks; j++) {
+      out[j] = _mm_xor_si128(encrypt(round_keys[i][j], seed[j]), seed[j]);
+    }
+    return out;
+  }
+
+private:
+  [[gnu::always_inline]] static inline __m128i encrypt(const __m128i *rk, __m128i x) {
+    x = _mm_xor_si128(x, rk[0]);
+    for (int r = 1; r < 10; r++) {
+      x = _mm_aesenc_si128(x, rk[r]);
+    }
+    return _mm_aesenclast_si128(x, rk[10]);
+  }
+
+  static inline __m128i expand_key_step(__m128i key, __m128i assist) {
+    assist = _mm_shuffle_epi32(assist, 0xff);
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    return _mm_xor_si128(key, assist);
+  }
+
+  static void expand_key(__m128i *rk, const uint8_t *key) {
+    rk[0] = _mm_loadu_si128((const __m128i *)key);
+    rk[1] = expand_key_step(rk[0], _mm_aeskeygenassist_si128(rk[0], 0x01));
+    rk[2] = expand_key_step(rk[1], _mm_aeskeygenassist_si128(rk[1], 0x02));
+    rk[3] = expand_key_step(rk[2], _mm_aeskeygenassist_si128(rk[2], 0x04));
+    rk[4] = expand_key_step(rk[3], _mm_aeskeygenassist_si128(rk[3], 0x08));
+    rk[5] = expand_key_step(rk[4], _mm_aeskeygenassist_si128(rk[4], 0x10));
+    rk[6] = expand_key_step(rk[5], _mm_aeskeygenassist_si128(rk[5], 0x20));
+    rk[7] = expand_key_step(rk[6], _mm_aeskeygenassist_si128(rk[6], 0x40));
+    rk[8] = expand_key_step(rk[7], _mm_aeskeygenassist_si128(rk[7], 0x80));
+    rk[9] = expand_key_step(rk[8], _mm_aeskeygenassist_si128(rk[8], 0x1b));
+    rk[10] = expand_key_step(rk[9], _mm_aeskeygenassist_si128(rk[9], 0x36));
+  }
+};
+
+/**
+ * DCF with everything known at compile time.
+ * @tparam Bitlen Bitlen of input points
+ * @tparam Lambda Byte len of seeds and group elements, like kLambda
+ * @tparam Group Like @ref U64Group
+ * @tparam Prg Like @ref Aes128Mmo. Must have >= 4 blocks.
+ */
+template <int Bitlen, int Lambda, class Group, class Prg>
+class Dcf {
+public:
+  static_assert(Bitlen > 0, "Bitlen must be > 0");
+  static_assert(Lambda >= 16 && Lambda % 16 == 0, "Lambda must be a multiple of 16");
+
+  /**
+   * Same as @ref kDcfCwLen
+   */
+  static constexpr size_t kCwLen = Lambda * 2 + 1;
+  /**
+   * Len of `Key.cws`
+   */
+  static constexpr size_t kCwsLen = kCwLen * Bitlen;
+  /**
+   * Len of a serialized key, i.e., `Key.cws` + `Key.cw_np1`
+   */
+  static constexpr size_t kKeyLen = kCwsLen + Lambda;
+  static constexpr int kBytelen = (Bitlen + 7) / 8;
+
+  using Seed = typename Prg::Seed;
+  using Elem = typename Group::Elem;
+
+  /**
+   * Same as @ref dcf_gen() but `s0s` is input only
+   */
+  static void gen(Key k, CmpFunc cf, const uint8_t *s0s) {
+    GenState st;
+    st.s0 = load_seed(s0s);
+    st.s1 = load_seed(s0s + Lambda);
+    st.t0 = 0;
+    st.t1 = 1;
+    st.v = Group::zero();
+    gen_levels(st, k, cf, std::make_index_sequence<Bitlen>{});
+
+    Elem cw_np1 = Group::add(Group::load(st.s1[0]), Group::neg(Group::load(st.s0[0])));
+    cw_np1 = Group::add(cw_np1, Group::neg(st.v));
+    if (st.t1) cw_np1 = Group::neg(cw_np1);
+    Group::store(k.cw_np1, cw_np1, Lambda);
+  }
+
+  /**
+   * Same as @ref dcf_eval()
+   * @param out Output whose len = `Lambda`
+   * @param s0 `s0s[b]` whose len = `Lambda`
+   * @param x Little-endian bytes whose len >= @ref kBytelen
+   */
+  static void eval(uint8_t *out, uint8_t b, Key k, const uint8_t *s0, const uint8_t *x) {
+    EvalState st;
+    st.s = load_seed(s0);
+    st.t = b;
+    st.v = Group::zero();
+    eval_levels(st, b, k, x, std::make_index_sequence<Bitlen>{});
+
+    Elem y = Group::load(st.s[0]);
+    if (st.t) y = Group::add(y, Group::load(k.cw_np1));
+    if (b) y = Group::neg(y);
+    Group::store(out, Group::add(st.v, y), Lambda);
+  }
+
+  /**
+   * @ref eval() with the input as an integer
+   */
+  static void eval(uint8_t *out, uint8_t b, Key k, const uint8_t *s0, uint64_t x) {
+    static_assert(Bitlen <= 64, "Bitlen must be <= 64 to use integer inputs");
+    uint8_t x_bytes[8];
+    std::memcpy(x_bytes, &x, 8);
+    eval(out, b, k, s0, x_bytes);
+  }
+
+private:
+  struct EvalState {
+    Seed s;
+    uint8_t t;
+    Elem v;
+  };
+
+  struct GenState {
+    Seed s0, s1;
+    uint8_t t0, t1;
+    Elem v;
+  };
+
+  static inline Seed load_seed(const uint8_t *bytes) {
+    Seed s;
+    for (int j = 0; j < Prg::kChunks; j++) {
+      s[j] = _mm_loadu_si128((const __m128i *)(bytes + j * 16));
+    }
+    s[Prg::kChunks - 1] = _mm_and_si128(s[Prg::kChunks - 1], msb_mask());
+    return s;
+  }
+
+  static inline void store_seed(uint8_t *bytes, const Seed &s) {
+    for (int j = 0; j < Prg::kChunks; j++) {
+      _mm_storeu_si128((__m128i *)(bytes + j * 16), s[j]);
+    }
+  }
+
+  static inline __m128i msb_mask() {
+    return _mm_set_epi64x(0x7fffffffffffffffll, -1ll);
+  }
+
+  // Load the 1bit t from MSB and clear it, like load_st() in dcf.c
+  [[gnu::always_inline]] static inline uint8_t load_t(Seed &s) {
+    __m128i &last = s[Prg::kChunks - 1];
+    uint8_t t = (uint8_t)((_mm_movemask_epi8(last) >> 15) & 1);
+    last = _mm_and_si128(last, msb_mask());
+    return t;
+  }
+
+  [[gnu::always_inline]] static inline Seed xor_seed(const Seed &a, const Seed &b) {
+    Seed out;
+    for (int j = 0; j < Prg::kChunks; j++) {
+      out[j] = _mm_xor_si128(a[j], b[j]);
+    }
+    return out;
+  }
+
+  // Return a if mask = 0 or a xor b if mask = 1
+  [[gnu::always_inline]] static inline Seed xor_seed_if(const Seed &a, const Seed &b, uint8_t mask) {
+    __m128i m = _mm_set1_epi8((char)-(int8_t)mask);
+    Seed out;
+    for (int j = 0; j < Prg::kChunks; j++) {
+      out[j] = _mm_xor_si128(a[j], _mm_and_si128(b[j], m));
+    }
+    return out;
+  }
+
+  // Actually get MSB first
+  template <int I>
+  [[gnu::always_inline]] static inline uint8_t get_bit(const uint8_t *bytes) {
+    constexpr int kPos = Bitlen - I - 1;
+    return (bytes[kPos / 8] >> (kPos % 8)) & 1;
+  }
+
+  template <size_t... I>
+  [[gnu::always_inline]] static inline void eval_levels(
+    EvalState &st, uint8_t b, const Key &k, const uint8_t *x, std::index_sequence<I...>) {
+    (eval_level<I>(st, b, k, x), ...);
+  }
+
+  template <int I>
+  [[gnu::always_inline]] static inline void eval_level(EvalState &st, uint8_t b, const Key &k, const uint8_t *x) {
+    const uint8_t *cw = k.cws + I * kCwLen;
+    uint8_t x_i = get_bit<I>(x);
+
+    Seed sx = Prg::block(2 * x_i, st.s);
+    Seed vx = Prg::block(2 * x_i + 1, st.s);
+    uint8_t tx = load_t(sx);
+
+    uint8_t t_cw = x_i ? cw[Lambda * 2] & 1 : cw[Lambda * 2] >> 1;
+    sx = xor_seed_if(sx, load_seed(cw), st.t);
+    tx ^= t_cw & st.t;
+
+    Elem v_delta = Group::load(vx[0]);
+    if (st.t) v_delta = Group::add(v_delta, Group::load(cw + Lambda));
+    if (b) v_delta = Group::neg(v_delta);
+    st.v = Group::add(st.v, v_delta);
+
+    st.s = sx;
+    st.t = tx;
+  }
+
+  template <size_t... I>
+  static inline void gen_levels(GenState &st, const Key &k, const CmpFunc &cf, std::index_sequence<I...>) {
+    (gen_level<I>(st, k, cf), ...);
+  }
+
+  template <int I>
+  [[gnu::always_inline]] static inline void gen_level(GenState &st, const Key &k, const CmpFunc &cf) {
+    uint8_t *cw = k.cws + I * kCwLen;
+    uint8_t alpha_i = get_bit<I>(cf.point.alpha.bytes);
+
+    Seed s0l = Prg::block(0, st.s0), v0l = Prg::block(1, st.s0);
+    Seed s0r = Prg::block(2, st.s0), v0r = Prg::block(3, st.s0);
+    Seed s1l = Prg::block(0, st.s1), v1l = Prg::block(1, st.s1);
+    Seed s1r = Prg::block(2, st.s1), v1r = Prg::block(3, st.s1);
+    uint8_t t0l = load_t(s0l), t0r = load_t(s0r);
+    uint8_t t1l = load_t(s1l), t1r = load_t(s1r);
+
+    Seed s_cw = alpha_i ? xor_seed(s0l, s1l) : xor_seed(s0r, s1r);
+    store_seed(cw, s_cw);
+
+    Elem v0_lose = Group::load(alpha_i ? v0l[0] : v0r[0]);
+    Elem v1_lose = Group::load(alpha_i ? v1l[0] : v1r[0]);
+    Elem v0_keep = Group::load(alpha_i ? v0r[0] : v0l[0]);
+    Elem v1_keep = Group::load(alpha_i ? v1r[0] : v1l[0]);
+
+    Elem v_cw = Group::add(v1_lose, Group::neg(v0_lose));
+    v_cw = Group::add(v_cw, Group::neg(st.v));
+    if (st.t1) v_cw = Group::neg(v_cw);
+    bool lose_lt = cf.bound == kLtAlpha ? alpha_i : !alpha_i;
+    if (lose_lt) {
+      Elem beta = Group::load(cf.point.beta);
+      v_cw = Group::add(v_cw, st.t1 ? Group::neg(beta) : beta);
+    }
+    Group::store(cw + Lambda, v_cw, Lambda);
+
+    st.v = Group::add(st.v, Group::neg(v1_keep));
+    st.v = Group::add(st.v, v0_keep);
+    st.v = Group::add(st.v, st.t1 ? Group::neg(v_cw) : v_cw);
+
+    uint8_t tl_cw = t0l ^ t1l ^ alpha_i ^ 1;
+    uint8_t tr_cw = t0r ^ t1r ^ alpha_i;
+    cw[Lambda * 2] = tl_cw << 1 | tr_cw;
+
+    uint8_t t_cw_keep = alpha_i ? tr_cw : tl_cw;
+    st.s0 = xor_seed_if(alpha_i ? s0r : s0l, s_cw, st.t0);
+    st.s1 = xor_seed_if(alpha_i ? s1r : s1l, s_cw, st.t1);
+    st.t0 = (alpha_i ? t0r : t0l) ^ (st.t0 & t_cw_keep);
+    st.t1 = (alpha_i ? t1r : t1l) ^ (st.t1 & t_cw_keep);
+  }
+};
+
+}  // namespace fss
@@ -0,0 +1,63 @@
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @file dcf_bool.h
+ *
+ * DCF whose output group is GF(2), i.e., outputs are XOR-shared bits.
+ *
+ * Each tree node expands to 2 blocks rather than 4 because the 1bit value of a child fits in its seed block:
+ * for lambda bytes of a child, bit lambda * 8 - 1 is `t`, bit lambda * 8 - 2 is `v`, and the other bits are the seed.
+ * A correction word is the seed correction with `v` correction at bit lambda * 8 - 2, then a byte of `tl` `tr`.
+ * The last correction word only uses bit 0 of `cw_np1`.
+ */
+
+#pragma once
+
+#include <fss/prelude.h>
+#include <fss/prg.h>
+
+#define kDcfBoolCwLen (kLambda + 1)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Boolean DCF keygen.
+ * @param k Output allocated already. `cws` len = @ref kDcfBoolCwLen * `alpha` bitlen and `cw_np1` len = 1.
+ * @param cf `beta` only uses bit 0
+ * @param sbuf Buffer whose len >= 6 * lambda.
+ * `s0s` as input is stored at first 2 * lambda bytes.
+ * No need to init other bytes.
+ */
+void dcf_bool_gen(Key k, CmpFunc cf, uint8_t *sbuf);
+
+/**
+ * Boolean DCF eval at 1 input point.
+ * @param sbuf Buffer whose len >= 3 * lambda.
+ * `s0s[b]` as input is stored at first lambda bytes.
+ * No need to init other bytes.
+ * @param b Party bit, 0/1
+ * @param k Gen by @ref dcf_bool_gen()
+ * @param x Evaluated input point
+ * @return Share of the output bit
+ */
+uint8_t dcf_bool_eval(uint8_t *sbuf, uint8_t b, Key k, Bits x);
+
+/**
+ * Boolean DCF eval at `n` input points with 1 key.
+ * Each tree level expands the seeds of all points with 1 @ref prg_n() call.
+ * @param ys Output whose len = (`n` + 63) / 64. Bit `j` % 64 of `ys[j / 64]` is the share of the j-th point. Unused bits are 0.
+ * @param sbuf Buffer whose len >= `n` * (3 * lambda + 2).
+ * `s0s[b]` as input is stored at first lambda bytes.
+ * No need to init other bytes.
+ * @param b Party bit, 0/1
+ * @param k Gen by @ref dcf_bool_gen()
+ * @param xs Evaluated input points of the same bitlen
+ * @param n Number of input points
+ */
+void dcf_bool_eval_batch(uint64_t *ys, uint8_t *sbuf, uint8_t b, Key k, const Bits *xs, int n);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,64 @@
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @file dcf_ht.h
+ *
+ * Half-tree DCF, whose node expansion is 1 correlation-robust hash rather than a length-doubling PRG.
+ *
+ * The 2 parties' seeds differ by a global offset Δ on the path of `alpha` and are equal off the path, and MSB(Δ) = 1, so `t` is the seed MSB.
+ * The MSB of the root seed of party `b` is overwritten with `b`.
+ * With H(s) = π(σ(s)) xor σ(s), where π is the fixed-key AES of @ref prg() block 0 and σ(l || r) = (l xor r || l) per 16B chunk,
+ * the children of a node are s_L = H(s) xor t * CW and s_R = s_L xor s.
+ * The value of a node is block 1 of @ref prg() on the same σ(s), so eval expands 2 AES blocks per level rather than 4.
+ *
+ * A correction word is the seed correction CW then the value correction, each lambda bytes.
+ */
+
+#pragma once
+
+#include <fss/prelude.h>
+#include <fss/group.h>
+#include <fss/prg.h>
+
+#define kDcfHtCwLen (kLambda * 2)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Half-tree DCF keygen.
+ * @param k Output allocated already. `cws` len = @ref kDcfHtCwLen * `alpha` bitlen and `cw_np1` len = lambda.
+ * @param cf
+ * @param sbuf Buffer whose len >= 7 * lambda.
+ * `s0s` as input is stored at first 2 * lambda bytes.
+ * No need to init other bytes.
+ */
+void dcf_ht_gen(Key k, CmpFunc cf, uint8_t *sbuf);
+
+/**
+ * Half-tree DCF eval at 1 input point.
+ * @param sbuf Buffer whose len >= 4 * lambda.
+ * `s0s[b]` as input is stored at first lambda bytes.
+ * Output is stored at first lambda bytes, the same as @ref dcf_eval().
+ * No need to init other bytes.
+ * @param b Party bit, 0/1
+ * @param k Gen by @ref dcf_ht_gen()
+ * @param x Evaluated input point
+ */
+void dcf_ht_eval(uint8_t *sbuf, uint8_t b, Key k, Bits x);
+
+/**
+ * Half-tree DCF full domain eval, on the same thread pool and with the same grain as @ref dcf_eval_full_domain().
+ * @param sbuf Buffer whose len >= 2 ^ `x_bitlen` * lambda and `x_bitlen` >= 1.
+ * `s0s[b]` as input is stored at first lambda bytes.
+ * Output is contiguously stored at each lambda bytes of `sbuf`.
+ * @param b Party bit, 0/1
+ * @param k Gen by @ref dcf_ht_gen()
+ * @param x_bitlen Bitlen of input points
+ */
+void dcf_ht_eval_full_domain(uint8_t *sbuf, uint8_t b, Key k, int x_bitlen);
+
+#ifdef __cplusplus
+}
+#endif
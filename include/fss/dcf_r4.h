@@ -0,0 +1,60 @@
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @file dcf_r4.h
+ *
+ * Radix-4 DCF, whose tree consumes 2 input bits per level, so a 64-bit comparison takes 32 dependent PRG steps.
+ *
+ * A node expands to 4 children by calling @ref prg() with 4 * lambda output on the seed and on the seed with its MSB set,
+ * which give the seeds and values of children 0, 1 and 2, 3 respectively.
+ * Eval only needs the call of the child it goes to, so it runs 1 call per 2 bits.
+ * Each child has its own seed and value correction, so a correction word is
+ * 4 seed corrections, then 4 value corrections, each lambda bytes, then a byte whose bit `c` is `t` correction of child `c`.
+ * Odd bitlens are padded with a 0 bit above the MSB.
+ */
+
+#pragma once
+
+#include <fss/prelude.h>
+#include <fss/group.h>
+#include <fss/prg.h>
+
+#define kDcfR4CwLen (kLambda * 8 + 1)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Number of radix-4 levels, i.e., correction words, for a bitlen.
+ */
+static inline int dcf_r4_level_num(int bitlen) {
+  return (bitlen + 1) / 2;
+}
+
+/**
+ * Radix-4 DCF keygen.
+ * @param k Output allocated already.
+ * `cws` len = @ref kDcfR4CwLen * @ref dcf_r4_level_num() of `alpha` bitlen and `cw_np1` len = lambda.
+ * @param cf
+ * @param sbuf Buffer whose len >= 20 * lambda.
+ * `s0s` as input is stored at first 2 * lambda bytes.
+ * No need to init other bytes.
+ */
+void dcf_r4_gen(Key k, CmpFunc cf, uint8_t *sbuf);
+
+/**
+ * Radix-4 DCF eval at 1 input point.
+ * @param sbuf Buffer whose len >= 7 * lambda.
+ * `s0s[b]` as input is stored at first lambda bytes.
+ * Output is stored at first lambda bytes, the same as @ref dcf_eval().
+ * No need to init other bytes.
+ * @param b Party bit, 0/1
+ * @param k Gen by @ref dcf_r4_gen()
+ * @param x Evaluated input point
+ */
+void dcf_r4_eval(uint8_t *sbuf, uint8_t b, Key k, Bits x);
+
+#ifdef __cplusplus
+}
+#endif
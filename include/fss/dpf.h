@@ -0,0 +1,61 @@
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @file dpf.h
+ */
+
+#pragma once
+
+#include <fss/prelude.h>
+#include <fss/group.h>
+#include <fss/prg.h>
+
+#define kDpfCwLen (kLambda + 1)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * DPF keygen.
+ * @param k Output allocated already. See @ref Key for allocation and no need to init.
+ * `cws` len = @ref kDpfCwLen * `alpha` bitlen.
+ * @param pf
+ * @param sbuf Buffer whose len >= 6 * lambda.
+ * `s0s` as input is stored at first 2 * lambda bytes.
+ * No need to init other bytes.
+ */
+FSS_CUDA_HOST_DEVICE void dpf_gen(Key k, PointFunc pf, uint8_t *sbuf);
+
+/**
+ * DPF eval at 1 input point.
+ * @param sbuf Buffer whose len >= 3 * lambda.
+ * `s0s[b]` as input is stored at first lambda bytes.
+ * Output is stored at first lambda bytes.
+ * Output is little-endian and viewed as a group element.
+ * Output's MSB is always 0. See @ref group.h for details.
+ * No need to init other bytes.
+ * @param b Party bit, 0/1
+ * @param k Gen by @ref dpf_gen()
+ * @param x Evaluated input point. Like `alpha` of @ref PointFunc.
+ */
+FSS_CUDA_HOST_DEVICE void dpf_eval(uint8_t *sbuf, uint8_t b, Key k, Bits x);
+
+/**
+ * DPF full domain eval i.e. eval at all input points.
+ * Runs on the same thread pool and with the same grain as @ref dcf_eval_full_domain() without allocation.
+ * @param sbuf Buffer whose len >= 2 ^ `x_bitlen` * lambda.
+ * `s0s[b]` as input is stored at first lambda bytes.
+ * Output is contiguously stored at each lambda bytes of `sbuf`.
+ * Output is little-endian and viewed as a group element.
+ * Output's MSB is always 0. See @ref group.h for details.
+ * No need to init other bytes.
+ * @param b Party bit, 0/1
+ * @param k Gen by @ref dpf_gen()
+ * @param x_bitlen Bitlen of input points, resulting in 2 ^ `x_bitlen` input points in total
+ */
+void dpf_eval_full_domain(uint8_t *sbuf, uint8_t b, Key k, int x_bitlen);
+
+#ifdef __cplusplus
+}
+#endif
@@ -40,6 +40,11 @@ FSS_CUDA_HOST_DEVICE void group_neg(uint8_t *val);
  */
 FSS_CUDA_HOST_DEVICE void group_zero(uint8_t *val);
 
+/**
+ * Name of the group implementation, e.g., `u64` for the field mod 2^64 - 59 and `z2_64` for the ring Z_2^64. For logs.
+ */
+const char *group_name();
+
 #ifdef __cplusplus
 }
 #endif
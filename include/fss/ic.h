@@ -0,0 +1,73 @@
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @file ic.h
+ *
+ * Interval containment over masked inputs with 1 DCF key per comparison.
+ *
+ * Inputs x in [0, n) are opened masked as x' = x + r mod n, with the mask r fixed across comparisons.
+ * For a threshold c in [0, n), let t = r + c mod n. Then:
+ *
+ *     [x >= c] = 1 - [x' < t] + [x' < r] - [t < r]
+ *
+ * where [t < r] is the wrap bit of r + c.
+ * The base term [x' < r] only depends on the mask, so its key is gen once and its eval is reused by all comparisons on the same input.
+ * Each comparison only needs the key of [x' < t] with payload -1 and the constant 1 - [t < r] shared by the dealer.
+ * The two-sided [lo <= x < hi] is the difference of 2 comparisons, where the base terms cancel.
+ */
+
+#pragma once
+
+#include <fss/dcf.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Gen the base key of [x' < r] with payload 1.
+ * @param k Output allocated already. Same as @ref dcf_gen().
+ * @param r Mask of inputs. Its bitlen is the bitlen of inputs.
+ * @param sbuf Same as @ref dcf_gen()
+ */
+void ic_gen_base(Key k, Bits r, uint8_t *sbuf);
+
+/**
+ * Gen the key of [x >= c].
+ * @param k Output allocated already. Same as @ref dcf_gen().
+ * @param w Output group element 1 - [t < r], which the dealer secret-shares to 2 parties
+ * @param r Mask of inputs, < `n`
+ * @param c Threshold, < `n`
+ * @param n Modulus of inputs, <= 2 ^ `bitlen`
+ * @param bitlen Bitlen of inputs, <= 64
+ * @param sbuf Same as @ref dcf_gen()
+ */
+void ic_gen_ge(Key k, uint8_t *w, uint64_t r, uint64_t c, uint64_t n, int bitlen, uint8_t *sbuf);
+
+/**
+ * Eval the base key at a masked input. Same as @ref dcf_eval().
+ * The output is reused by @ref ic_eval_ge() of all comparisons on the same input.
+ */
+void ic_eval_base(uint8_t *sbuf, uint8_t b, Key k, Bits x);
+
+/**
+ * Eval [x >= c] at a masked input.
+ * @param sbuf Same as @ref dcf_eval(). Output is the share of [x >= c] as a group element.
+ * @param b Party bit, 0/1
+ * @param k Gen by @ref ic_gen_ge()
+ * @param x Masked input x'
+ * @param y_base Output of @ref ic_eval_base() at the same `x` by the same party
+ * @param w Share of `w` of @ref ic_gen_ge() of the party
+ */
+void ic_eval_ge(uint8_t *sbuf, uint8_t b, Key k, Bits x, const uint8_t *y_base, const uint8_t *w);
+
+/**
+ * @ref ic_eval_ge() starting from a frontier of `k` built by @ref dcf_frontier_build().
+ * The base key can use @ref dcf_eval_frontier() directly.
+ */
+void ic_eval_ge_frontier(
+  uint8_t *sbuf, uint8_t b, Key k, const uint8_t *frontier, int depth, Bits x, const uint8_t *y_base, const uint8_t *w);
+
+#ifdef __cplusplus
+}
+#endif
@@ -22,6 +22,16 @@ extern "C" {
  */
 FSS_CUDA_HOST_DEVICE void prg(uint8_t *out, int out_len, const uint8_t *seed);
 
+/**
+ * PRG on multiple seeds at once, so that implementations can keep multiple blocks in flight.
+ * Same output as calling @ref prg() on each seed.
+ * @param out Output whose len = `n` * `out_len`. Output of seed i is at `out` + i * `out_len`.
+ * @param out_len Output len per seed. See @ref prg().
+ * @param seeds Input whose len = `n` * lambda
+ * @param n Num of seeds
+ */
+void prg_n(uint8_t *out, int out_len, const uint8_t *seeds, int n);
+
 /**
  * Init PRG.
  * Same state and seed give same output.
@@ -38,6 +48,11 @@ void prg_init(const uint8_t *state, int state_len);
  */
 void prg_free();
 
+/**
+ * Name of the implementation in use, e.g., the CPU kernel picked by @ref prg_init(). For logs.
+ */
+const char *prg_name();
+
 #ifdef __cplusplus
 }
 #endif
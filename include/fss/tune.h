@@ -0,0 +1,106 @@
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @file tune.h
+ *
+ * Per-host configuration of the eval loops, chosen by the `tune` tool from micro-benchmarks on the host.
+ *
+ * The configuration is a text file of `key = value` lines, where `#` starts a comment and absent keys keep their defaults.
+ * The library loads the file named by the `FSS_TUNE_FILE` environment variable and applies it by @ref tune_apply()
+ * when the program starts, i.e., before `main()`. Without the variable, nothing is applied.
+ */
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Name of the environment variable of the configuration file
+ */
+#define kTuneFileEnv "FSS_TUNE_FILE"
+
+/**
+ * Max `eval_batch`, so that per-batch inputs fit on the stack
+ */
+#define kTuneMaxEvalBatch 1024
+
+typedef struct {
+  /**
+   * OpenMP thread num of the eval loops, or 0 to keep `omp_get_max_threads()`
+   */
+  int thread_num;
+  /**
+   * Input points per chunk of the `schedule(runtime)` eval loops, or 0 for the static schedule.
+   * See @ref tune_set_schedule().
+   */
+  int chunk;
+  /**
+   * Input points per @ref dcf_eval_batch() call, or 1 for per-point @ref dcf_eval(). <= @ref kTuneMaxEvalBatch.
+   */
+  int eval_batch;
+  /**
+   * Grain of @ref dcf_full_domain_set_grain(), or 0 for the library default
+   */
+  int full_domain_grain_bitlen;
+  /**
+   * Depth of @ref dcf_frontier_build() for repeated eval with 1 key, or 0 for plain eval.
+   * Frontier eval is per point, i.e., ignores `eval_batch`.
+   */
+  int frontier_depth;
+} TuneConfig;
+
+/**
+ * Defaults, i.e., the behavior without a configuration file
+ */
+void tune_default(TuneConfig *cfg);
+
+/**
+ * Read `path` over the current values of `cfg`.
+ * @return 0, or -1 if the file cannot be read or has an unknown key or invalid value, when `cfg` is partly updated
+ */
+int tune_load(TuneConfig *cfg, const char *path);
+
+/**
+ * Write `cfg` to `path`, replacing any file there.
+ * @param comment Lines written as comments before the values, or NULL
+ * @return 0, or -1 if the file cannot be written
+ */
+int tune_save(const TuneConfig *cfg, const char *path, const char *comment);
+
+/**
+ * The configuration of the process, loaded once from `FSS_TUNE_FILE` if set, otherwise the defaults.
+ * A broken file is reported to stderr and falls back to the defaults.
+ * Thread-safe.
+ */
+const TuneConfig *tune_get();
+
+/**
+ * Set the OpenMP runtime schedule for a loop whose iteration evals `points_per_iter` points, e.g., `eval_batch`,
+ * so that a chunk still has about `chunk` points.
+ */
+void tune_set_schedule(const TuneConfig *cfg, int points_per_iter);
+
+/**
+ * Set the OpenMP thread num, the runtime schedule of per-point loops, and the grain of @ref dcf_full_domain_set_grain(), from `cfg`.
+ * Call it before the OpenMP parallel regions and thread pool it affects.
+ */
+void tune_apply(const TuneConfig *cfg);
+
+/**
+ * Whether @ref tune_get() is from a file, i.e., the library has applied it at start.
+ * @return 1 if the configuration is from a file, otherwise 0
+ */
+int tune_from_file();
+
+/**
+ * @ref tune_apply() of @ref tune_get(), e.g., to apply the defaults or restore the file after changing OpenMP settings.
+ * The library already applies a file at start.
+ * @return @ref tune_from_file()
+ */
+int tune_init();
+
+#ifdef __cplusplus
+}
+#endif
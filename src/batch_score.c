@@ -0,0 +1,145 @@
+// For real-time extensions
+#define _POSIX_C_SOURCE 199309L
+
+// Batched scoring of Q queries against N docs in 1 blocked pass vs Q passes of 1 query each, for Q = 1..64.
+// Usage: batch_score_benchmark
+
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <omp.h>
+#include "rand.h"
+#include "score.h"
+
+#define kSeed 114514
+#define kN 16384
+#define kDim 1024
+#define kMaxQ 64
+
+typedef unsigned __int128 uint128_t;
+
+static inline double get_time() {
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1.0e-9;
+}
+
+static uint64_t add_mod_p(uint64_t a, uint64_t b) {
+  return (uint64_t)(((uint128_t)a + b) % kRngFieldPrime);
+}
+
+static uint64_t sub_mod_p(uint64_t a, uint64_t b) {
+  return (uint64_t)(((uint128_t)a + kRngFieldPrime - b) % kRngFieldPrime);
+}
+
+static uint64_t mul_mod_p(uint64_t a, uint64_t b) {
+  return (uint64_t)(((uint128_t)a * b) % kRngFieldPrime);
+}
+
+static void *alloc_u64(size_t n) {
+  void *p = malloc(n * sizeof(uint64_t));
+  assert(p != NULL);
+  return p;
+}
+
+// Both parties' shares of small, odd-sized batches open to A B^T
+static void check(Rng *rng) {
+  enum { q_num = 5, n = 37, dim = 19 };
+  uint64_t a[q_num * dim], bm[n * dim], x[q_num * dim], y[n * dim], z[q_num * n];
+  uint64_t x0[q_num * dim], y0[n * dim], z0[q_num * n], x1[q_num * dim], y1[n * dim], z1[q_num * n];
+  uint64_t e[q_num * dim], f[n * dim], out0[q_num * n], out1[q_num * n];
+  rng_fill_field(rng, a, q_num * dim);
+  rng_fill_field(rng, bm, n * dim);
+  rng_fill_field(rng, x, q_num * dim);
+  rng_fill_field(rng, y, n * dim);
+  rng_fill_field(rng, x0, q_num * dim);
+  rng_fill_field(rng, y0, n * dim);
+  rng_fill_field(rng, z0, q_num * n);
+  for (int i = 0; i < q_num * dim; i++) {
+    x1[i] = sub_mod_p(x[i], x0[i]);
+    e[i] = sub_mod_p(a[i], x[i]);
+  }
+  for (int i = 0; i < n * dim; i++) {
+    y1[i] = sub_mod_p(y[i], y0[i]);
+    f[i] = sub_mod_p(bm[i], y[i]);
+  }
+  for (int q = 0; q < q_num; q++) {
+    for (int j = 0; j < n; j++) {
+      uint64_t s = 0;
+      for (int k = 0; k < dim; k++) {
+        s = add_mod_p(s, mul_mod_p(x[q * dim + k], y[j * dim + k]));
+      }
+      z[q * n + j] = s;
+      z1[q * n + j] = sub_mod_p(s, z0[q * n + j]);
+    }
+  }
+
+  score_batch(out0, 0, e, f, x0, y0, z0, q_num, n, dim);
+  score_batch(out1, 1, e, f, x1, y1, z1, q_num, n, dim);
+  for (int q = 0; q < q_num; q++) {
+    for (int j = 0; j < n; j++) {
+      uint64_t s = 0;
+      for (int k = 0; k < dim; k++) {
+        s = add_mod_p(s, mul_mod_p(a[q * dim + k], bm[j * dim + k]));
+      }
+      assert(add_mod_p(out0[q * n + j], out1[q * n + j]) == s);
+      (void)s;
+    }
+  }
+  (void)z;
+}
+
+int main() {
+  uint64_t seed[2] = {kSeed, 0};
+  Rng rng;
+  rng_init(&rng, (uint8_t *)seed, 0);
+  printf("OpenMP thread num: %d\n", omp_get_max_threads());
+  printf("N (Docs): %d\n", kN);
+  printf("Dim: %d\n", kDim);
+  printf("Tile: %d x %d, block: %d docs\n", kScoreTileQ, kScoreTileN, kScoreBlockN);
+  check(&rng);
+
+  // Party 0's view. The doc side is Y_0 and F, 2 matrices of N x dim.
+  uint64_t *y0 = alloc_u64((size_t)kN * kDim);
+  uint64_t *f = alloc_u64((size_t)kN * kDim);
+  uint64_t *e = alloc_u64((size_t)kMaxQ * kDim);
+  uint64_t *x0 = alloc_u64((size_t)kMaxQ * kDim);
+  uint64_t *z0 = alloc_u64((size_t)kMaxQ * kN);
+  uint64_t *out = alloc_u64((size_t)kMaxQ * kN);
+  rng_fill_field(&rng, y0, (size_t)kN * kDim);
+  rng_fill_field(&rng, f, (size_t)kN * kDim);
+  rng_fill_field(&rng, e, (size_t)kMaxQ * kDim);
+  rng_fill_field(&rng, x0, (size_t)kMaxQ * kDim);
+  rng_fill_field(&rng, z0, (size_t)kMaxQ * kN);
+  double doc_gib = 2.0 * kN * kDim * sizeof(uint64_t) / (1 << 30);
+  printf("Doc side (GiB): %lf\n", doc_gib);
+
+  // Scores per second, and GiB/s of the doc side read from memory, i.e., once per pass
+  printf("q,batched_ms,repeated_ms,batched_mscore_s,repeated_mscore_s,batched_doc_gib_s,repeated_doc_gib_s\n");
+  for (int q_num = 1; q_num <= kMaxQ; q_num *= 2) {
+    double t = get_time();
+    score_batch(out, 0, e, f, x0, y0, z0, q_num, kN, kDim);
+    double t_batched = get_time() - t;
+
+    t = get_time();
+    for (int q = 0; q < q_num; q++) {
+      score_batch(out + (size_t)q * kN, 0, e + (size_t)q * kDim, f, x0 + (size_t)q * kDim, y0, z0 + (size_t)q * kN, 1,
+        kN, kDim);
+    }
+    double t_repeated = get_time() - t;
+
+    double scores = (double)q_num * kN;
+    printf("%d,%lf,%lf,%lf,%lf,%lf,%lf\n", q_num, t_batched * 1e3, t_repeated * 1e3, scores / t_batched * 1e-6,
+      scores / t_repeated * 1e-6, doc_gib / t_batched, doc_gib * q_num / t_repeated);
+  }
+
+  free(y0);
+  free(f);
+  free(e);
+  free(x0);
+  free(z0);
+  free(out);
+  return 0;
+}
@@ -9,14 +9,22 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <fss/dcf.h>
+#include <fss/ic.h>
 #include <fss/group.h>
+#include <fss/tune.h>
 #include <omp.h>
+#include "perf.h"
+#include "rand.h"
+#include "workspace.h"
 
 #define kPrime 18446744073709551557ull
 #define kSeed 114514
 #define kAlphaBitlen 64
 #define kAlphaBytelen 8
 #define kN 1048576
+// One-sided comparisons sharing 1 mask, like the binary search steps of retrieval.c
+#define kIcStep 13
+#define kIcN (kN / 8)
 
 // Use __int128 for easier modular arithmetic mod p where p ~ 2^64
 typedef unsigned __int128 uint128_t;
@@ -27,19 +35,14 @@ static inline double get_time() {
   return ts.tv_sec + ts.tv_nsec * 1.0e-9;
 }
 
+static Rng gRng;
+
 static void gen_rand_bytes(uint8_t *buf, size_t len) {
-  for (size_t i = 0; i < len; i++) {
-    buf[i] = rand() & 0xFF;
-  }
+  rng_fill_bytes(&gRng, buf, len);
 }
 
 static uint64_t get_rand_field() {
-    uint64_t r;
-    uint8_t buf[8];
-    gen_rand_bytes(buf, 8);
-    memcpy(&r, buf, 8);
-    if (r >= kPrime) return r - kPrime;
-    return r;
+    return rng_field(&gRng);
 }
 
 static uint64_t add_mod_p(uint64_t a, uint64_t b) {
@@ -63,7 +66,8 @@ static uint64_t group_to_u64(const uint8_t *g) {
 }
 
 int main() {
-  srand(kSeed);
+  uint64_t seed[2] = {kSeed, 0};
+  rng_init(&gRng, (uint8_t *)seed, 0);
   printf("Cmp Protocol Benchmark\n");
   printf("Lambda (B): %d\n", kLambda);
 
@@ -72,6 +76,13 @@ int main() {
   gen_rand_bytes(keys, 4 * kLambda);
   prg_init(keys, 4 * kLambda);
   free(keys);
+  printf("PRG kernel: %s\n", prg_name());
+
+  // Eval loops as tuned for this host by the tune tool, if any, which the library has applied at start
+  int tuned = tune_from_file();
+  const TuneConfig *tune = tune_get();
+  printf("Tune: %s, threads %d, eval batch %d, chunk %d\n", tuned ? getenv(kTuneFileEnv) : "defaults",
+    omp_get_max_threads(), tune->eval_batch, tune->chunk);
 
   int iter_num = kN;
 
@@ -83,6 +94,8 @@ int main() {
 
   uint8_t *sbuf_l = (uint8_t*)malloc(kLambda * 10);
   uint8_t *sbuf_r = (uint8_t*)malloc(kLambda * 10);
+  // L and R keys are generated together, see dcf_gen_n
+  uint8_t *sbuf_gen = (uint8_t*)malloc(2 * (kLambda * 10 + 2));
 
   int gen_iter_num = 1;
 
@@ -110,11 +123,11 @@ int main() {
         CmpFunc cf_r = {{alpha_r, pr}, kLtAlpha};
 
         // Seeds for this iter (simulating random)
-        gen_rand_bytes(sbuf_l, 2*kLambda);
-        gen_rand_bytes(sbuf_r, 2*kLambda);
+        gen_rand_bytes(sbuf_gen, 4*kLambda);
 
-        dcf_gen(key_l, cf_l, sbuf_l);
-        dcf_gen(key_r, cf_r, sbuf_r);
+        Key keys_lr[2] = {key_l, key_r};
+        CmpFunc cfs_lr[2] = {cf_l, cf_r};
+        dcf_gen_n(keys_lr, cfs_lr, sbuf_gen, 2);
 
         uint64_t w = (xl_p > xr_p) ? 1 : 0;
         uint64_t w0 = get_rand_field();
@@ -156,51 +169,131 @@ int main() {
   uint64_t w0 = get_rand_field();
 
   // Pre-generate random inputs and allocate thread-local buffers
-  int thread_num = omp_get_max_threads();
-  uint8_t *sbufs_l = (uint8_t *)malloc(kLambda * 10 * thread_num);
-  uint8_t *sbufs_r = (uint8_t *)malloc(kLambda * 10 * thread_num);
+  // The l and r buffers of a thread are its 2 halves, each for 1 batch of points
+  int batch = tune->eval_batch;
+  size_t half_len = batch == 1 ? kLambda * 10 : (size_t)batch * (6 * kLambda + 1);
+  Workspace ws;
+  ws_open(&ws, half_len * 2);
   uint64_t *xs_eval = (uint64_t *)malloc(iter_num * sizeof(uint64_t));
-  if (!sbufs_l || !sbufs_r || !xs_eval) {
+  if (!xs_eval) {
       perror("malloc failed");
       return 1;
   }
 
-  for (int i = 0; i < iter_num; i++) {
-      xs_eval[i] = get_rand_field();
-  }
+  rng_fill_field(&gRng, xs_eval, iter_num);
 
+  PerfCounters pc;
+  perf_open(&pc);
+  perf_reset(&pc);
+  perf_start(&pc);
   t = get_time();
-#pragma omp parallel for
-  for (int i=0; i < iter_num; i++) {
+  int batch_num = (iter_num + batch - 1) / batch;
+  tune_set_schedule(tune, batch);
+#pragma omp parallel for schedule(runtime)
+  for (int j=0; j < batch_num; j++) {
      int tid = omp_get_thread_num();
-     uint8_t *sbuf_l_local = sbufs_l + tid * kLambda * 10;
-     uint8_t *sbuf_r_local = sbufs_r + tid * kLambda * 10;
-
-     uint64_t x = xs_eval[i];
-     uint64_t z = add_mod_p(x, r);
-     Bits z_bits = {(uint8_t*)&z, kAlphaBitlen};
+     uint8_t *sbuf_l_local = ws_get(&ws, tid);
+     uint8_t *sbuf_r_local = sbuf_l_local + half_len;
+
+     int lo = j * batch;
+     int m = lo + batch < iter_num ? batch : iter_num - lo;
+     uint64_t zs[m];
+     Bits z_bits[m];
+     for (int i = 0; i < m; i++) {
+         zs[i] = add_mod_p(xs_eval[lo + i], r);
+         z_bits[i].bytes = (uint8_t*)&zs[i];
+         z_bits[i].bitlen = kAlphaBitlen;
+     }
 
      // Simulating P0 Eval
      memcpy(sbuf_l_local, s0s_l, kLambda); // Reset seed for P0
      memcpy(sbuf_r_local, s0s_r, kLambda); // Reset seed for P0
 
-     dcf_eval(sbuf_l_local, 0, key_l, z_bits);
-     dcf_eval(sbuf_r_local, 0, key_r, z_bits);
+     if (batch == 1) {
+         dcf_eval(sbuf_l_local, 0, key_l, z_bits[0]);
+         dcf_eval(sbuf_r_local, 0, key_r, z_bits[0]);
+     } else {
+         dcf_eval_batch(sbuf_l_local, 0, key_l, z_bits, m);
+         dcf_eval_batch(sbuf_r_local, 0, key_r, z_bits, m);
+     }
+
+     for (int i = 0; i < m; i++) {
+         uint64_t y_l = group_to_u64(sbuf_l_local + i * kLambda);
+         uint64_t y_r = group_to_u64(sbuf_r_local + i * kLambda);
+         uint64_t res = add_mod_p(add_mod_p(y_l, y_r), w0);
+         (void)res;
+     }
+  }
+  double t_elapsed = get_time() - t;
+  double t_eval_2key = t_elapsed;
+  perf_stop(&pc);
+  printf("Cmp.Eval (one party) time (all) (ms/op): %lf\n", t_elapsed * 1e3);
+  // 2 DCF evals per Cmp.Eval
+  perf_report(&pc, "dcf_eval", 2.0 * iter_num);
+
+  // One-sided Cmp [x >= c] with 1 key per comparison, where the base key of the fixed mask r is evaluated once per input
+  printf("Benchmarking IC.Eval (%d comparisons per input)...\n", kIcStep);
+  Key key_base;
+  key_base.cw_np1 = (uint8_t*)malloc(kLambda); key_base.cws = (uint8_t*)malloc(kDcfCwLen * kAlphaBitlen);
+  Key keys_ge[kIcStep];
+  uint8_t s0s_ge[kIcStep][2*kLambda];
+  uint8_t w0s[kIcStep][kLambda];
+  uint8_t s0s_base[2*kLambda]; gen_rand_bytes(s0s_base, 2*kLambda);
+  Bits r_bits = {(uint8_t*)&r, kAlphaBitlen};
+  memcpy(sbuf_l, s0s_base, 2*kLambda);
+  ic_gen_base(key_base, r_bits, sbuf_l);
+  t = get_time();
+  for (int s = 0; s < kIcStep; s++) {
+      keys_ge[s].cw_np1 = (uint8_t*)malloc(kLambda); keys_ge[s].cws = (uint8_t*)malloc(kDcfCwLen * kAlphaBitlen);
+      gen_rand_bytes(s0s_ge[s], 2*kLambda);
+      memcpy(sbuf_l, s0s_ge[s], 2*kLambda);
+      uint8_t w_ge[kLambda];
+      ic_gen_ge(keys_ge[s], w_ge, r, get_rand_field(), kPrime, kAlphaBitlen, sbuf_l);
+      // Share w, where party 0 gets w0
+      u64_to_group(w0s[s], get_rand_field());
+  }
+  printf("IC.Gen time (us/op): %lf\n", (get_time() - t) / kIcStep * 1e6);
+
+  perf_reset(&pc);
+  perf_start(&pc);
+  t = get_time();
+  tune_set_schedule(tune, 1);
+#pragma omp parallel for schedule(runtime)
+  for (int i=0; i < kIcN; i++) {
+     int tid = omp_get_thread_num();
+     uint8_t *sbuf_local = ws_get(&ws, tid);
+
+     uint64_t z = add_mod_p(xs_eval[i], r);
+     Bits z_bits = {(uint8_t*)&z, kAlphaBitlen};
+
+     memcpy(sbuf_local, s0s_base, kLambda);
+     ic_eval_base(sbuf_local, 0, key_base, z_bits);
+     uint8_t y_base[kLambda];
+     memcpy(y_base, sbuf_local, kLambda);
 
-     uint64_t y_l = group_to_u64(sbuf_l_local);
-     uint64_t y_r = group_to_u64(sbuf_r_local);
-     uint64_t res = add_mod_p(add_mod_p(y_l, y_r), w0);
-     (void)res;
+     for (int s = 0; s < kIcStep; s++) {
+         memcpy(sbuf_local, s0s_ge[s], kLambda);
+         ic_eval_ge(sbuf_local, 0, keys_ge[s], z_bits, y_base, w0s[s]);
+     }
+  }
+  t_elapsed = get_time() - t;
+  perf_stop(&pc);
+  printf("IC.Eval (one party) time (us/comparison): %lf\n", t_elapsed / ((double)kIcN * kIcStep) * 1e6);
+  printf("Cmp.Eval (one party) time (us/comparison): %lf\n", t_eval_2key / iter_num * 1e6);
+  perf_report(&pc, "dcf_eval", (double)kIcN * (kIcStep + 1));
+  perf_close(&pc);
+
+  for (int s = 0; s < kIcStep; s++) {
+      free(keys_ge[s].cw_np1); free(keys_ge[s].cws);
   }
-  printf("Cmp.Eval (one party) time (all) (ms/op): %lf\n", (get_time() - t) * 1e3);
+  free(key_base.cw_np1); free(key_base.cws);
 
-  free(sbufs_l);
-  free(sbufs_r);
+  ws_close(&ws);
   free(xs_eval);
 
   free(key_l.cw_np1); free(key_l.cws);
   free(key_r.cw_np1); free(key_r.cws);
-  free(sbuf_l); free(sbuf_r);
+  free(sbuf_l); free(sbuf_r); free(sbuf_gen);
 
   return 0;
 }
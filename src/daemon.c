@@ -0,0 +1,276 @@
+// SPDX-License-Identifier: Apache-2.0
+
+// For sigaction() and nanosleep()
+#define _POSIX_C_SOURCE 199309L
+
+#include "daemon.h"
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <fss/dcf.h>
+#include <fss/ic.h>
+#include <fss/group.h>
+#include "rand.h"
+#include "shard.h"
+
+// Buckets of latency in [2^i, 2^(i + 1)) us
+#define kHistBucketNum 40
+
+static inline double get_time() {
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1.0e-9;
+}
+
+static volatile sig_atomic_t gStop = 0;
+
+static void on_stop(int sig) {
+  (void)sig;
+  gStop = 1;
+}
+
+static int fill_addr(struct sockaddr_un *addr, const char *path) {
+  memset(addr, 0, sizeof(*addr));
+  addr->sun_family = AF_UNIX;
+  if (strlen(path) >= sizeof(addr->sun_path)) {
+    fprintf(stderr, "Daemon socket path too long: %s\n", path);
+    return -1;
+  }
+  strcpy(addr->sun_path, path);
+  return 0;
+}
+
+static int alloc_keys(Key *key_base, Key *key_ge) {
+  key_base->cw_np1 = (uint8_t *)malloc(kLambda);
+  key_base->cws = (uint8_t *)malloc(kDcfCwLen * kShardBitlen);
+  key_ge->cw_np1 = (uint8_t *)malloc(kLambda);
+  key_ge->cws = (uint8_t *)malloc(kDcfCwLen * kShardBitlen);
+  return key_base->cw_np1 != NULL && key_base->cws != NULL && key_ge->cw_np1 != NULL && key_ge->cws != NULL ? 0 : -1;
+}
+
+static void free_keys(Key *key_base, Key *key_ge) {
+  free(key_base->cw_np1);
+  free(key_base->cws);
+  free(key_ge->cw_np1);
+  free(key_ge->cws);
+}
+
+int daemon_serve(const char *path, const uint8_t *doc_seed, size_t n, double t_start) {
+  struct sockaddr_un addr;
+  if (fill_addr(&addr, path) != 0) return -1;
+
+  double t = get_time();
+  ShardState st;
+  if (shard_load(&st, doc_seed, 0, n) != 0) return -1;
+  double t_load = get_time() - t;
+
+  // Warm-up scoring and round with a throwaway mask and base key
+  t = get_time();
+  {
+    Key key_base, key_ge;
+    uint8_t sbuf_gen[kLambda * 10], s_base[2 * kLambda];
+    if (alloc_keys(&key_base, &key_ge) != 0) {
+      shard_unload(&st);
+      return -1;
+    }
+    Rng rng;
+    rng_init(&rng, NULL, 0);
+    uint64_t r = rng_field(&rng);
+    Bits r_bits = {(uint8_t *)&r, kShardBitlen};
+    shard_score(&st, r, 0);
+    // Gen overwrites its seeds
+    rng_fill_bytes(&rng, s_base, 2 * kLambda);
+    memcpy(sbuf_gen, s_base, 2 * kLambda);
+    ic_gen_base(key_base, r_bits, sbuf_gen);
+    uint8_t sum[kLambda];
+    shard_eval(&st, kShardOpBase, key_base, s_base, NULL, sum);
+    free_keys(&key_base, &key_ge);
+  }
+  double t_warm = get_time() - t;
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    perror("Daemon socket failed");
+    shard_unload(&st);
+    return -1;
+  }
+  unlink(path);
+  if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, 16) != 0) {
+    perror("Daemon bind failed");
+    close(fd);
+    shard_unload(&st);
+    return -1;
+  }
+
+  // Without SA_RESTART, so that a signal breaks accept()
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = on_stop;
+  sigemptyset(&sa.sa_mask);
+  sigaction(SIGINT, &sa, NULL);
+  sigaction(SIGTERM, &sa, NULL);
+
+  printf("Daemon ready on %s: %zu docs, startup %lf ms (load %lf ms, warm-up %lf ms)\n", path, n,
+    (get_time() - t_start) * 1e3, t_load * 1e3, t_warm * 1e3);
+  fflush(stdout);
+
+  int ret = 0;
+  int session_num = 0;
+  while (!gStop) {
+    int conn = accept(fd, NULL, NULL);
+    if (conn < 0) {
+      if (errno == EINTR) continue;
+      perror("Daemon accept failed");
+      ret = -1;
+      break;
+    }
+    t = get_time();
+    if (shard_serve_conn(&st, conn) != 0) fprintf(stderr, "Daemon session %d broken\n", session_num);
+    close(conn);
+    printf("Session %d: %lf ms\n", session_num++, (get_time() - t) * 1e3);
+    fflush(stdout);
+  }
+
+  close(fd);
+  unlink(path);
+  shard_unload(&st);
+  return ret;
+}
+
+static int cmp_double(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+// Percentiles and a log2 histogram of `n` latencies in seconds, which are sorted in place
+static void report_latencies(const char *name, double *latencies, int n) {
+  if (n == 0) return;
+  qsort(latencies, n, sizeof(double), cmp_double);
+  printf("%s latency (ms): p50 %lf, p90 %lf, p99 %lf, max %lf\n", name, latencies[(n * 50 + 99) / 100 - 1] * 1e3,
+    latencies[(n * 90 + 99) / 100 - 1] * 1e3, latencies[(n * 99 + 99) / 100 - 1] * 1e3, latencies[n - 1] * 1e3);
+
+  int hist[kHistBucketNum] = {0};
+  for (int i = 0; i < n; i++) {
+    int bucket = 0;
+    while (bucket + 1 < kHistBucketNum && latencies[i] * 1e6 >= (double)(1ULL << (bucket + 1))) bucket++;
+    hist[bucket]++;
+  }
+  for (int i = 0; i < kHistBucketNum; i++) {
+    if (hist[i] == 0) continue;
+    printf("  [%lf, %lf) ms: %d\n", (double)(1ULL << i) * 1e-3, (double)(1ULL << (i + 1)) * 1e-3, hist[i]);
+  }
+}
+
+// Connect, retrying while the daemon starts up
+static int connect_retry(const char *path) {
+  struct sockaddr_un addr;
+  if (fill_addr(&addr, path) != 0) return -1;
+  struct timespec wait = {0, 10 * 1000 * 1000};
+  for (int i = 0; i < 6000; i++) {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+      perror("Client socket failed");
+      return -1;
+    }
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) return fd;
+    close(fd);
+    if (errno != ENOENT && errno != ECONNREFUSED) break;
+    nanosleep(&wait, NULL);
+  }
+  perror("Client connect failed");
+  return -1;
+}
+
+int daemon_query(const char *path, int query_num, int step_num, const uint8_t *user_seed, const uint8_t *doc_seed,
+  size_t n, double t_start) {
+  Key key_base, key_ge;
+  // Gen overwrites its seeds, so the seeds s0 and s1 of each key are kept aside
+  uint8_t sbuf_gen[kLambda * 10], s_base[2 * kLambda], s_ge[2 * kLambda];
+  double *latencies = (double *)malloc(sizeof(double) * query_num);
+  if (latencies == NULL || alloc_keys(&key_base, &key_ge) != 0) {
+    free(latencies);
+    return -1;
+  }
+
+  int fd = connect_retry(path);
+  ShardCluster c;
+  if (fd < 0 || shard_attach(&c, fd) != 0) {
+    if (fd >= 0) close(fd);
+    free_keys(&key_base, &key_ge);
+    free(latencies);
+    return -1;
+  }
+  double t_connect = get_time() - t_start;
+
+  Rng rng;
+  rng_init(&rng, user_seed, 0);
+  int ret = 0;
+  double t_first = 0, t_check = 0;
+  for (int q = 0; q < query_num && ret == 0; q++) {
+    double t = get_time();
+    uint64_t r = rng_field(&rng);
+    // Shares of the mask for the 2 parties' opens of the scores
+    uint64_t r_0 = rng_field(&rng);
+    uint64_t r_1 = r >= r_0 ? r - r_0 : r + (kRngFieldPrime - r_0);
+    ret = shard_round_score(&c, r_0, r_1);
+    Bits r_bits = {(uint8_t *)&r, kShardBitlen};
+    rng_fill_bytes(&rng, s_base, 2 * kLambda);
+    memcpy(sbuf_gen, s_base, 2 * kLambda);
+    ic_gen_base(key_base, r_bits, sbuf_gen);
+    if (ret == 0) ret = shard_round(&c, kShardOpBase, key_base, s_base, NULL, NULL);
+
+    for (int s = 0; s < step_num && ret == 0; s++) {
+      // User Gen (Simulated), as in retrieval.c
+      uint64_t threshold = rng_field(&rng);
+      uint8_t w[kLambda], w0[kLambda], count[kLambda];
+      rng_fill_bytes(&rng, s_ge, 2 * kLambda);
+      memcpy(sbuf_gen, s_ge, 2 * kLambda);
+      ic_gen_ge(key_ge, w, r, threshold, kRngFieldPrime, kShardBitlen, sbuf_gen);
+      group_zero(w0);
+      uint64_t w0_u64 = rng_field(&rng);
+      memcpy(w0, &w0_u64, sizeof(w0_u64));
+      ret = shard_round(&c, kShardOpGe, key_ge, s_ge, w0, count);
+
+      // Open the 1st count with party 1's share, out of the timing, which fails if the daemon's docs are not those of
+      // `doc_seed` and `n`
+      if (ret == 0 && q == 0 && s == 0) {
+        double t_check_start = get_time();
+        uint8_t w1[kLambda], count_1[kLambda];
+        memcpy(w1, w0, kLambda);
+        group_neg(w1);
+        group_add(w1, w);
+        shard_count_1(count_1, doc_seed, n, r, key_base, s_base, key_ge, s_ge, w1);
+        group_add(count_1, count);
+        uint64_t opened;
+        memcpy(&opened, count_1, sizeof(opened));
+        uint64_t plain = shard_plain_count(doc_seed, n, threshold);
+        printf("Check: count %lu of %zu docs, plain %lu\n", (unsigned long)opened, n, (unsigned long)plain);
+        if (opened != plain) {
+          fprintf(stderr, "Daemon count check failed\n");
+          ret = -1;
+        }
+        t_check = get_time() - t_check_start;
+        t += t_check;
+      }
+    }
+    latencies[q] = get_time() - t;
+    if (q == 0) t_first = get_time() - t_start - t_check;
+  }
+  shard_close(&c);
+
+  if (ret == 0) {
+    printf("Connected after %lf ms, first query done after %lf ms\n", t_connect * 1e3, t_first * 1e3);
+    printf("First query latency: %lf ms\n", latencies[0] * 1e3);
+    // Steady state excludes the first query
+    report_latencies("Steady-state", latencies + 1, query_num - 1);
+  }
+  free_keys(&key_base, &key_ge);
+  free(latencies);
+  return ret;
+}
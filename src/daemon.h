@@ -0,0 +1,37 @@
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @file daemon.h
+ *
+ * Long-lived retrieval server, as party 0 of retrieval.c, and a client that measures it.
+ *
+ * The daemon is dealt the embedding shares and triples of all docs once with @ref shard_load(), runs 1 warm-up scoring
+ * and round so that its OpenMP threads, buffers and PRG are hot, then serves queries on a Unix-domain socket until SIGINT
+ * or SIGTERM. A connection is 1 session of any number of queries, in the round protocol of shard.h:
+ * 1 @ref kShardOpScore round, 1 @ref kShardOpBase round, then 1 @ref kShardOpGe round per binary search step.
+ * Connections are served 1 at a time, each with all threads. A signal stops the daemon after the current session.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Serve on `path`, replacing any file there, until a signal. @ref prg_init() must be called already.
+ * @param t_start Time of process start, to report the startup time
+ * @return 0, or -1 if the docs cannot be loaded or the socket cannot be bound
+ */
+int daemon_serve(const char *path, const uint8_t *doc_seed, size_t n, double t_start);
+
+/**
+ * Run `query_num` queries of `step_num` steps on the daemon at `path` and report their latencies.
+ * Wait up to 60 s for the daemon to listen, so both can be started together to measure startup-to-first-query.
+ * The 1st count is opened with party 1's share and checked against the plain count of docs `[0, n)` of `doc_seed`,
+ * which must be those of the daemon.
+ * @ref prg_init() must be called already, with the same keys as the daemon.
+ * @param t_start Time of process start, to report the time to the first query
+ * @return 0, or -1 if the daemon cannot be reached, fails or returns a wrong count
+ */
+int daemon_query(const char *path, int query_num, int step_num, const uint8_t *user_seed, const uint8_t *doc_seed,
+  size_t n, double t_start);
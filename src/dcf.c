@@ -7,12 +7,22 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <fss/dcf.h>
+#include <fss/dcf_bool.h>
+#include <fss/dcf_r4.h>
 #include <omp.h>
+#include "perf.h"
+#include "rand.h"
+#include "workspace.h"
 
 #define kSeed 114514
 #define kAlphaBitlen 64
 #define kAlphaBytelen 8
 #define kN 100000
+// Divides kN
+#define kBatchN 16
+// Keys evaluated at 1 point, in batches of kMultikeyBatchN that divides kMultikeyN
+#define kMultikeyN 16384
+#define kMultikeyBatchN 64
 
 static inline double get_time() {
   struct timespec ts;
@@ -20,10 +30,10 @@ static inline double get_time() {
   return ts.tv_sec + ts.tv_nsec * 1.0e-9;
 }
 
+static Rng gRng;
+
 static void gen_rand_bytes(uint8_t *buf, size_t len) {
-  for (size_t i = 0; i < len; i++) {
-    buf[i] = rand() & 0xFF;
-  }
+  rng_fill_bytes(&gRng, buf, len);
 }
 
 // Get int from little-endian kAlphaBitlen bits
@@ -41,7 +51,8 @@ static uint64_t get_alpha_int_le(uint8_t *alpha) {
 int main() {
   assert((kAlphaBitlen + 7) / 8 == kAlphaBytelen);
   assert(kAlphaBytelen <= 8);
-  srand(kSeed);
+  uint64_t seed[2] = {kSeed, 0};
+  rng_init(&gRng, (uint8_t *)seed, 0);
   double t;
   int iter_num;
   printf("OpenMP thread num: %d\n", omp_get_max_threads());
@@ -54,6 +65,8 @@ int main() {
   gen_rand_bytes(keys, 4 * kLambda);
   prg_init(keys, 4 * kLambda);
   free(keys);
+  printf("PRG kernel: %s\n", prg_name());
+  printf("Group: %s\n", group_name());
 
   // Sample s0s
   uint8_t *s0s = (uint8_t *)malloc(kLambda * 2);
@@ -86,45 +99,309 @@ int main() {
   k.cws = (uint8_t *)malloc(kDcfCwLen * kAlphaBitlen);
   assert(k.cws != NULL);
 
+  PerfCounters pc;
+  perf_open(&pc);
+
   // DCF gen
   iter_num = 100000;
+  perf_reset(&pc);
+  perf_start(&pc);
   t = get_time();
   for (int i = 0; i < iter_num; i++) {
     memcpy(sbuf, s0s, kLambda * 2);
     dcf_gen(k, cf, sbuf);
   }
+  perf_stop(&pc);
   printf("dcf_gen (us): %lf\n", (get_time() - t) / iter_num * 1e6);
+  perf_report(&pc, "dcf_gen", iter_num);
+
+  // 2 keys in lockstep, e.g., the 2 keys of an interval comparison
+  uint8_t *sbuf_n = (uint8_t *)malloc(2 * (kLambda * 10 + 2));
+  assert(sbuf_n != NULL);
+  Key ks_n[2];
+  for (int j = 0; j < 2; j++) {
+    ks_n[j].cw_np1 = (uint8_t *)malloc(kLambda);
+    ks_n[j].cws = (uint8_t *)malloc(kDcfCwLen * kAlphaBitlen);
+    assert(ks_n[j].cw_np1 != NULL && ks_n[j].cws != NULL);
+  }
+  CmpFunc cfs_n[2] = {cf, cf};
+  t = get_time();
+  for (int i = 0; i < iter_num; i++) {
+    memcpy(sbuf_n, s0s, kLambda * 2);
+    memcpy(sbuf_n + kLambda * 2, s0s, kLambda * 2);
+    dcf_gen_n(ks_n, cfs_n, sbuf_n, 2);
+  }
+  printf("dcf_gen_n of 2 keys (us/key): %lf\n", (get_time() - t) / iter_num / 2 * 1e6);
+  for (int j = 0; j < 2; j++) {
+    free(ks_n[j].cw_np1);
+    free(ks_n[j].cws);
+  }
+  free(sbuf_n);
 
   free(sbuf);
 
-  int thread_num = omp_get_max_threads();
-  uint8_t *sbufs = (uint8_t *)malloc(kLambda * 6 * thread_num);
-  assert(sbufs != NULL);
+  Workspace ws;
+  ws_open(&ws, kLambda * 6);
 
   uint64_t *xs = (uint64_t *)malloc(kN * sizeof(uint64_t));
   assert(xs != NULL);
-  for (int i = 0; i < kN; i++) {
-    gen_rand_bytes((uint8_t *)&xs[i], 8);
-  }
+  gen_rand_bytes((uint8_t *)xs, kN * sizeof(uint64_t));
 
   // DCF eval
+  perf_reset(&pc);
+  perf_start(&pc);
   t = get_time();
 #pragma omp parallel for
   for (int i = 0; i < kN; i++) {
     int tid = omp_get_thread_num();
-    uint8_t *sbuf = sbufs + tid * kLambda * 6;
+    uint8_t *sbuf = ws_get(&ws, tid);
 
     memcpy(sbuf, s0s, kLambda);
     Bits x_bits = {(uint8_t *)&xs[i], kAlphaBitlen};
     dcf_eval(sbuf, 0, k, x_bits);
   }
   double t_elapsed = get_time() - t;
+  perf_stop(&pc);
   printf("dcf_eval (us): %lf\n", t_elapsed / kN * 1e6);
+  perf_report(&pc, "dcf_eval", kN);
+
+  ws_close(&ws);
+
+  // DCF batched eval, kBatchN points per call
+  Bits *xs_bits = (Bits *)malloc(kN * sizeof(Bits));
+  assert(xs_bits != NULL);
+  for (int i = 0; i < kN; i++) {
+    xs_bits[i].bytes = (uint8_t *)&xs[i];
+    xs_bits[i].bitlen = kAlphaBitlen;
+  }
+  size_t batch_sbuf_len = kBatchN * (kLambda * 6 + 1);
+  ws_open(&ws, batch_sbuf_len);
+
+  perf_reset(&pc);
+  perf_start(&pc);
+  t = get_time();
+#pragma omp parallel for
+  for (int i = 0; i < kN / kBatchN; i++) {
+    int tid = omp_get_thread_num();
+    uint8_t *sbuf = ws_get(&ws, tid);
+
+    memcpy(sbuf, s0s, kLambda);
+    dcf_eval_batch(sbuf, 0, k, xs_bits + i * kBatchN, kBatchN);
+  }
+  t_elapsed = get_time() - t;
+  perf_stop(&pc);
+  printf("dcf_eval_batch (us): %lf\n", t_elapsed / kN * 1e6);
+  perf_report(&pc, "dcf_eval_batch", kN);
+
+  ws_close(&ws);
+
+  // Many keys at 1 point, each key separately vs key batches in lockstep
+  Key *mks = (Key *)malloc(kMultikeyN * sizeof(Key));
+  assert(mks != NULL);
+  uint8_t *mk_cws = (uint8_t *)malloc((size_t)kDcfCwLen * kAlphaBitlen * kMultikeyN);
+  assert(mk_cws != NULL);
+  uint8_t *mk_cw_np1s = (uint8_t *)malloc((size_t)kLambda * kMultikeyN);
+  assert(mk_cw_np1s != NULL);
+  sbuf = (uint8_t *)malloc(kLambda * 10);
+  assert(sbuf != NULL);
+  for (int j = 0; j < kMultikeyN; j++) {
+    mks[j].cws = mk_cws + (size_t)j * kDcfCwLen * kAlphaBitlen;
+    mks[j].cw_np1 = mk_cw_np1s + j * kLambda;
+    uint8_t mk_alpha[kAlphaBytelen];
+    gen_rand_bytes(mk_alpha, kAlphaBytelen);
+    CmpFunc mk_cf = {{{mk_alpha, kAlphaBitlen}, beta}, kLtAlpha};
+    memcpy(sbuf, s0s, kLambda * 2);
+    dcf_gen(mks[j], mk_cf, sbuf);
+  }
+  free(sbuf);
+  Bits x0_bits = {(uint8_t *)&xs[0], kAlphaBitlen};
+
+  ws_open(&ws, kLambda * 6);
+  perf_reset(&pc);
+  perf_start(&pc);
+  t = get_time();
+#pragma omp parallel for
+  for (int j = 0; j < kMultikeyN; j++) {
+    uint8_t *sbuf = ws_get(&ws, omp_get_thread_num());
+    memcpy(sbuf, s0s, kLambda);
+    dcf_eval(sbuf, 0, mks[j], x0_bits);
+  }
+  t_elapsed = get_time() - t;
+  perf_stop(&pc);
+  printf("dcf_eval of many keys (us): %lf\n", t_elapsed / kMultikeyN * 1e6);
+  perf_report(&pc, "dcf_eval of many keys", kMultikeyN);
+  ws_close(&ws);
+
+  int mkb_num = kMultikeyN / kMultikeyBatchN;
+  KeyBatch *mkbs = (KeyBatch *)malloc(mkb_num * sizeof(KeyBatch));
+  assert(mkbs != NULL);
+  for (int i = 0; i < mkb_num; i++) {
+    mkbs[i].n = kMultikeyBatchN;
+    mkbs[i].bitlen = kAlphaBitlen;
+    mkbs[i].cws = (uint8_t *)malloc((size_t)kDcfCwLen * kAlphaBitlen * kMultikeyBatchN);
+    mkbs[i].cw_np1s = (uint8_t *)malloc(kLambda * kMultikeyBatchN);
+    assert(mkbs[i].cws != NULL && mkbs[i].cw_np1s != NULL);
+    dcf_key_batch_from_keys(mkbs[i], mks + i * kMultikeyBatchN);
+  }
+  size_t mk_sbuf_len = kMultikeyBatchN * (kLambda * 6 + 1);
+  ws_open(&ws, mk_sbuf_len);
+  perf_reset(&pc);
+  perf_start(&pc);
+  t = get_time();
+#pragma omp parallel for
+  for (int i = 0; i < mkb_num; i++) {
+    uint8_t *sbuf = ws_get(&ws, omp_get_thread_num());
+    for (int j = 0; j < kMultikeyBatchN; j++) {
+      memcpy(sbuf + j * kLambda, s0s, kLambda);
+    }
+    dcf_eval_multikey(sbuf, 0, mkbs[i], x0_bits);
+  }
+  t_elapsed = get_time() - t;
+  perf_stop(&pc);
+  printf("dcf_eval_multikey (us): %lf\n", t_elapsed / kMultikeyN * 1e6);
+  perf_report(&pc, "dcf_eval_multikey", kMultikeyN);
+
+  ws_close(&ws);
+  for (int i = 0; i < mkb_num; i++) {
+    free(mkbs[i].cws);
+    free(mkbs[i].cw_np1s);
+  }
+  free(mkbs);
+  free(mks);
+  free(mk_cws);
+  free(mk_cw_np1s);
+
+  // DCF eval from a frontier at depths trading table memory for skipped levels
+  ws_open(&ws, kLambda * 6);
+  for (int depth = 8; depth <= 16; depth += 4) {
+    uint8_t *frontier = (uint8_t *)malloc((size_t)kDcfFrontierNodeLen << depth);
+    assert(frontier != NULL);
+    t = get_time();
+    memcpy(frontier, s0s, kLambda);
+    dcf_frontier_build(frontier, 0, k, depth);
+    double t_build = get_time() - t;
+
+    perf_reset(&pc);
+    perf_start(&pc);
+    t = get_time();
+#pragma omp parallel for
+    for (int i = 0; i < kN; i++) {
+      uint8_t *sbuf = ws_get(&ws, omp_get_thread_num());
+      dcf_eval_frontier(sbuf, 0, k, frontier, depth, xs_bits[i]);
+    }
+    t_elapsed = get_time() - t;
+    perf_stop(&pc);
+    printf("dcf_eval_frontier depth %d (us): %lf, build (ms): %lf, table (KiB): %zu\n", depth, t_elapsed / kN * 1e6,
+      t_build * 1e3, ((size_t)kDcfFrontierNodeLen << depth) / 1024);
+    perf_report(&pc, "dcf_eval_frontier", kN);
+    free(frontier);
+  }
+  ws_close(&ws);
+
+  // Boolean DCF
+  Key kb;
+  kb.cw_np1 = (uint8_t *)malloc(1);
+  assert(kb.cw_np1 != NULL);
+  kb.cws = (uint8_t *)malloc(kDcfBoolCwLen * kAlphaBitlen);
+  assert(kb.cws != NULL);
+  printf("Key len (B): %d, boolean: %d\n", kDcfCwLen * kAlphaBitlen + kLambda, kDcfBoolCwLen * kAlphaBitlen + 1);
+
+  sbuf = (uint8_t *)malloc(kLambda * 6);
+  assert(sbuf != NULL);
+  iter_num = 100000;
+  t = get_time();
+  for (int i = 0; i < iter_num; i++) {
+    memcpy(sbuf, s0s, kLambda * 2);
+    dcf_bool_gen(kb, cf, sbuf);
+  }
+  printf("dcf_bool_gen (us): %lf\n", (get_time() - t) / iter_num * 1e6);
+  free(sbuf);
+
+  ws_open(&ws, kLambda * 3);
+  perf_reset(&pc);
+  perf_start(&pc);
+  t = get_time();
+#pragma omp parallel for
+  for (int i = 0; i < kN; i++) {
+    uint8_t *sbuf = ws_get(&ws, omp_get_thread_num());
+    memcpy(sbuf, s0s, kLambda);
+    volatile uint8_t y = dcf_bool_eval(sbuf, 0, kb, xs_bits[i]);
+    (void)y;
+  }
+  t_elapsed = get_time() - t;
+  perf_stop(&pc);
+  printf("dcf_bool_eval (us): %lf\n", t_elapsed / kN * 1e6);
+  perf_report(&pc, "dcf_bool_eval", kN);
+  ws_close(&ws);
+
+  // 64 points per call to fill 1 word
+  size_t bool_sbuf_len = 64 * (kLambda * 3 + 2);
+  ws_open(&ws, bool_sbuf_len);
+  uint64_t *ys = (uint64_t *)malloc((kN + 63) / 64 * sizeof(uint64_t));
+  assert(ys != NULL);
+  perf_reset(&pc);
+  perf_start(&pc);
+  t = get_time();
+#pragma omp parallel for
+  for (int i = 0; i < (kN + 63) / 64; i++) {
+    uint8_t *sbuf = ws_get(&ws, omp_get_thread_num());
+    int n = kN - i * 64 < 64 ? kN - i * 64 : 64;
+    memcpy(sbuf, s0s, kLambda);
+    dcf_bool_eval_batch(ys + i, sbuf, 0, kb, xs_bits + i * 64, n);
+  }
+  t_elapsed = get_time() - t;
+  perf_stop(&pc);
+  printf("dcf_bool_eval_batch (us): %lf\n", t_elapsed / kN * 1e6);
+  perf_report(&pc, "dcf_bool_eval_batch", kN);
+
+  free(ys);
+  ws_close(&ws);
+  free(kb.cw_np1);
+  free(kb.cws);
+
+  // Radix-4 DCF, half the dependent PRG steps at about twice the key len
+  Key kr;
+  kr.cw_np1 = (uint8_t *)malloc(kLambda);
+  assert(kr.cw_np1 != NULL);
+  kr.cws = (uint8_t *)malloc(kDcfR4CwLen * dcf_r4_level_num(kAlphaBitlen));
+  assert(kr.cws != NULL);
+  printf("Key len (B): %d, radix-4: %d\n", kDcfCwLen * kAlphaBitlen + kLambda,
+    kDcfR4CwLen * dcf_r4_level_num(kAlphaBitlen) + kLambda);
+
+  sbuf = (uint8_t *)malloc(kLambda * 20);
+  assert(sbuf != NULL);
+  iter_num = 100000;
+  t = get_time();
+  for (int i = 0; i < iter_num; i++) {
+    memcpy(sbuf, s0s, kLambda * 2);
+    dcf_r4_gen(kr, cf, sbuf);
+  }
+  printf("dcf_r4_gen (us): %lf\n", (get_time() - t) / iter_num * 1e6);
+  free(sbuf);
+
+  ws_open(&ws, kLambda * 7);
+  perf_reset(&pc);
+  perf_start(&pc);
+  t = get_time();
+#pragma omp parallel for
+  for (int i = 0; i < kN; i++) {
+    uint8_t *sbuf = ws_get(&ws, omp_get_thread_num());
+    memcpy(sbuf, s0s, kLambda);
+    dcf_r4_eval(sbuf, 0, kr, xs_bits[i]);
+  }
+  t_elapsed = get_time() - t;
+  perf_stop(&pc);
+  printf("dcf_r4_eval (us): %lf\n", t_elapsed / kN * 1e6);
+  perf_report(&pc, "dcf_r4_eval", kN);
+  ws_close(&ws);
+  free(kr.cw_np1);
+  free(kr.cws);
 
-  free(sbufs);
+  free(xs_bits);
   free(xs);
 
   // Cleanup
+  perf_close(&pc);
   prg_free();
   free(s0s);
   free(beta);
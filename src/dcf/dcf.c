@@ -4,16 +4,6 @@
 #include <string.h>
 #include "utils.h"
 
-// Load the 1bit t from MSB, so we can truncate during adding
-FSS_CUDA_HOST_DEVICE static inline void load_st(uint8_t *s, uint8_t *t) {
-  *t = get_bit_lsb(s, kLambda * 8 - 1);
-  set_bit_lsb(s, kLambda * 8 - 1, 0);
-}
-
-static inline void set_st(uint8_t *s, uint8_t t) {
-  set_bit_lsb(s, kLambda * 8 - 1, t);
-}
-
 FSS_CUDA_HOST_DEVICE static inline void load_sst(uint8_t *ss, uint8_t *t0, uint8_t *t1) {
   load_st(ss, t0);
   load_st(ss + kLambda, t1);
@@ -36,6 +26,90 @@ FSS_CUDA_HOST_DEVICE static inline void get_cwt(const uint8_t *cw, uint8_t *tl,
   *tr = cw[kLambda * 2] & 1;
 }
 
+// 1 level of gen after the children of both parties are expanded to `sv0s` and `sv1s`
+FSS_CUDA_HOST_DEVICE static inline void dcf_gen_level(uint8_t *cw, uint8_t *s0, uint8_t *s1, uint8_t *ts, uint8_t *v,
+  uint8_t *sv0s, uint8_t *sv1s, uint8_t alpha_i, const uint8_t *beta, enum Bound bound) {
+  uint8_t t0 = ts[0], t1 = ts[1];
+  uint8_t *s0l = sv0s;
+  uint8_t *v0l = sv0s + kLambda;
+  uint8_t *s0r = sv0s + kLambda * 2;
+  uint8_t *v0r = sv0s + kLambda * 3;
+  uint8_t *s1l = sv1s;
+  uint8_t *v1l = sv1s + kLambda;
+  uint8_t *s1r = sv1s + kLambda * 2;
+  uint8_t *v1r = sv1s + kLambda * 3;
+  uint8_t t0l, t0r, t1l, t1r;
+  load_svst(sv0s, &t0l, &t0r);
+  load_svst(sv1s, &t1l, &t1r);
+
+  uint8_t *s0_lose = alpha_i ? s0l : s0r;
+  uint8_t *s1_lose = alpha_i ? s1l : s1r;
+
+  uint8_t *v0_lose = alpha_i ? v0l : v0r;
+  uint8_t *v1_lose = alpha_i ? v1l : v1r;
+  uint8_t *v0_keep = alpha_i ? v0r : v0l;
+  uint8_t *v1_keep = alpha_i ? v1r : v1l;
+
+  uint8_t *s_cw = cw;
+  memcpy(s_cw, s0_lose, kLambda);
+  xor_bytes(s_cw, s1_lose, kLambda);
+
+  uint8_t *v_cw = cw + kLambda;
+  memcpy(v_cw, v1_lose, kLambda);
+  group_neg(v0_lose);
+  group_add(v_cw, v0_lose);
+  memcpy(v0_lose, v, kLambda);
+  group_neg(v0_lose);
+  group_add(v_cw, v0_lose);
+  if (t1) group_neg(v_cw);
+  memcpy(v0_lose, beta, kLambda);
+  set_bit_lsb(v0_lose, kLambda * 8 - 1, 0);
+  if (t1) group_neg(v0_lose);
+  switch (bound) {
+    case kLtAlpha:
+      if (alpha_i) group_add(v_cw, v0_lose);
+      break;
+    case kGtAlpha:
+      if (!alpha_i) group_add(v_cw, v0_lose);
+      break;
+  }
+  group_neg(v1_keep);
+  group_add(v, v1_keep);
+  group_add(v, v0_keep);
+  memcpy(v0_lose, v_cw, kLambda);
+  if (t1) group_neg(v0_lose);
+  group_add(v, v0_lose);
+
+  uint8_t tl_cw, tr_cw;
+  tl_cw = t0l ^ t1l ^ alpha_i ^ 1;
+  tr_cw = t0r ^ t1r ^ alpha_i;
+  set_cwt(cw, tl_cw, tr_cw);
+
+  uint8_t *s0_keep = alpha_i ? s0r : s0l;
+  uint8_t *s1_keep = alpha_i ? s1r : s1l;
+  uint8_t t0_keep = alpha_i ? t0r : t0l;
+  uint8_t t1_keep = alpha_i ? t1r : t1l;
+  uint8_t t_cw_keep = alpha_i ? tr_cw : tl_cw;
+
+  memcpy(s0, s0_keep, kLambda);
+  if (t0) xor_bytes(s0, s_cw, kLambda);
+  memcpy(s1, s1_keep, kLambda);
+  if (t1) xor_bytes(s1, s_cw, kLambda);
+
+  ts[0] = t0 ? t0_keep ^ t_cw_keep : t0_keep;
+  ts[1] = t1 ? t1_keep ^ t_cw_keep : t1_keep;
+}
+
+FSS_CUDA_HOST_DEVICE static inline void dcf_gen_finish(Key k, uint8_t *s0, uint8_t *s1, uint8_t t1) {
+  uint8_t *v = k.cw_np1;
+  group_neg(s0);
+  group_add(s1, s0);
+  group_neg(v);
+  group_add(s1, v);
+  if (t1) group_neg(s1);
+  memcpy(k.cw_np1, s1, kLambda);
+}
+
 // | s0 | s1 | s0l | v0l | s0r | v0r | s1l | v1l | s1r | v1r |
 // | ss      | sv0s                  | sv1s                  |
 FSS_CUDA_HOST_DEVICE void dcf_gen(Key k, CmpFunc cf, uint8_t *sbuf) {
@@ -44,112 +118,70 @@ FSS_CUDA_HOST_DEVICE void dcf_gen(Key k, CmpFunc cf, uint8_t *sbuf) {
   uint8_t *s1 = ss + kLambda;
   uint8_t *v = k.cw_np1;
   group_zero(v);
-  uint8_t t0, t1;
-  load_sst(ss, &t0, &t1);
-  t0 = 0;
-  t1 = 1;
+  uint8_t ts[2];
+  load_sst(ss, &ts[0], &ts[1]);
+  ts[0] = 0;
+  ts[1] = 1;
   Point p = cf.point;
 
   uint8_t *sv0s = sbuf + kLambda * 2;
-  uint8_t *s0l = sv0s;
-  uint8_t *v0l = sv0s + kLambda;
-  uint8_t *s0r = sv0s + kLambda * 2;
-  uint8_t *v0r = sv0s + kLambda * 3;
   uint8_t *sv1s = sbuf + kLambda * 6;
-  uint8_t *s1l = sv1s;
-  uint8_t *v1l = sv1s + kLambda;
-  uint8_t *s1r = sv1s + kLambda * 2;
-  uint8_t *v1r = sv1s + kLambda * 3;
-  uint8_t t0l, t0r, t1l, t1r;
 
   for (int i = 0; i < p.alpha.bitlen; i++) {
+#ifdef __CUDACC__
     prg(sv0s, 4 * kLambda, s0);
     prg(sv1s, 4 * kLambda, s1);
-    load_svst(sv0s, &t0l, &t0r);
-    load_svst(sv1s, &t1l, &t1r);
+#else
+    // ss and sv0s | sv1s are already the layout of 2 seeds, so both parties' blocks are in flight together
+    prg_n(sv0s, 4 * kLambda, ss, 2);
+#endif
 
     // Actually get MSB first
     uint8_t alpha_i = get_bit_lsb(p.alpha.bytes, p.alpha.bitlen - i - 1);
-    uint8_t *cw = k.cws + i * kDcfCwLen;
-
-    uint8_t *s0_lose = alpha_i ? s0l : s0r;
-    uint8_t *s1_lose = alpha_i ? s1l : s1r;
-
-    uint8_t *v0_lose = alpha_i ? v0l : v0r;
-    uint8_t *v1_lose = alpha_i ? v1l : v1r;
-    uint8_t *v0_keep = alpha_i ? v0r : v0l;
-    uint8_t *v1_keep = alpha_i ? v1r : v1l;
-
-    uint8_t *s_cw = cw;
-    memcpy(s_cw, s0_lose, kLambda);
-    xor_bytes(s_cw, s1_lose, kLambda);
-
-    uint8_t *v_cw = cw + kLambda;
-    memcpy(v_cw, v1_lose, kLambda);
-    group_neg(v0_lose);
-    group_add(v_cw, v0_lose);
-    memcpy(v0_lose, v, kLambda);
-    group_neg(v0_lose);
-    group_add(v_cw, v0_lose);
-    if (t1) group_neg(v_cw);
-    memcpy(v0_lose, p.beta, kLambda);
-    set_bit_lsb(v0_lose, kLambda * 8 - 1, 0);
-    if (t1) group_neg(v0_lose);
-    switch (cf.bound) {
-      case kLtAlpha:
-        if (alpha_i) group_add(v_cw, v0_lose);
-        break;
-      case kGtAlpha:
-        if (!alpha_i) group_add(v_cw, v0_lose);
-        break;
-    }
-    group_neg(v1_keep);
-    group_add(v, v1_keep);
-    group_add(v, v0_keep);
-    memcpy(v0_lose, v_cw, kLambda);
-    if (t1) group_neg(v0_lose);
-    group_add(v, v0_lose);
+    dcf_gen_level(k.cws + i * kDcfCwLen, s0, s1, ts, v, sv0s, sv1s, alpha_i, p.beta, cf.bound);
+  }
 
-    uint8_t tl_cw, tr_cw;
-    tl_cw = t0l ^ t1l ^ alpha_i ^ 1;
-    tr_cw = t0r ^ t1r ^ alpha_i;
-    set_cwt(cw, tl_cw, tr_cw);
-
-    uint8_t *s0_keep = alpha_i ? s0r : s0l;
-    uint8_t *s1_keep = alpha_i ? s1r : s1l;
-    uint8_t t0_keep = alpha_i ? t0r : t0l;
-    uint8_t t1_keep = alpha_i ? t1r : t1l;
-    uint8_t t_cw_keep = alpha_i ? tr_cw : tl_cw;
-
-    memcpy(s0, s0_keep, kLambda);
-    if (t0) xor_bytes(s0, s_cw, kLambda);
-    memcpy(s1, s1_keep, kLambda);
-    if (t1) xor_bytes(s1, s_cw, kLambda);
-
-    if (t0) t0 = t0_keep ^ t_cw_keep;
-    else t0 = t0_keep;
-    if (t1) t1 = t1_keep ^ t_cw_keep;
-    else t1 = t1_keep;
+  dcf_gen_finish(k, s0, s1, ts[1]);
+}
+
+// | ss | svss | ts |
+// ss is | s0 | s1 | per key, svss is | sv0s | sv1s | per key, and ts is | t0 | t1 | per key
+void dcf_gen_n(const Key *ks, const CmpFunc *cfs, uint8_t *sbuf, int n) {
+  uint8_t *ss = sbuf;
+  uint8_t *svss = sbuf + kLambda * 2 * n;
+  uint8_t *ts = sbuf + kLambda * 10 * n;
+  for (int j = 0; j < n; j++) {
+    group_zero(ks[j].cw_np1);
+    load_sst(ss + j * kLambda * 2, &ts[j * 2], &ts[j * 2 + 1]);
+    ts[j * 2] = 0;
+    ts[j * 2 + 1] = 1;
   }
 
-  group_neg(s0);
-  group_add(s1, s0);
-  group_neg(v);
-  group_add(s1, v);
-  if (t1) group_neg(s1);
-  memcpy(k.cw_np1, s1, kLambda);
+  int bitlen = cfs[0].point.alpha.bitlen;
+  for (int i = 0; i < bitlen; i++) {
+    prg_n(svss, 4 * kLambda, ss, n * 2);
+
+    for (int j = 0; j < n; j++) {
+      Point p = cfs[j].point;
+      uint8_t *s0 = ss + j * kLambda * 2;
+      uint8_t *sv0s = svss + j * kLambda * 8;
+      // Actually get MSB first
+      uint8_t alpha_i = get_bit_lsb(p.alpha.bytes, bitlen - i - 1);
+      dcf_gen_level(ks[j].cws + i * kDcfCwLen, s0, s0 + kLambda, ts + j * 2, ks[j].cw_np1, sv0s, sv0s + kLambda * 4,
+        alpha_i, p.beta, cfs[j].bound);
+    }
+  }
+
+  for (int j = 0; j < n; j++) {
+    uint8_t *s0 = ss + j * kLambda * 2;
+    dcf_gen_finish(ks[j], s0, s0 + kLambda, ts[j * 2 + 1]);
+  }
 }
 
-// | s | v | sl | vl | sr | vr |
-// |       | svs               |
-FSS_CUDA_HOST_DEVICE void dcf_eval(uint8_t *sbuf, uint8_t b, Key k, Bits x) {
+// Walk from the node at `depth` whose `s` is at first lambda bytes and `v` is at next lambda bytes to the leaf of `x`
+FSS_CUDA_HOST_DEVICE static inline void dcf_eval_from(uint8_t *sbuf, uint8_t b, Key k, Bits x, int depth, uint8_t t) {
   uint8_t *s = sbuf;
   uint8_t *v = sbuf + kLambda;
-  group_zero(v);
-  uint8_t t;
-  load_st(s, &t);
-  t = b;
-
   uint8_t *svs = sbuf + kLambda * 2;
   uint8_t *sl = svs;
   uint8_t *vl = svs + kLambda;
@@ -157,7 +189,7 @@ FSS_CUDA_HOST_DEVICE void dcf_eval(uint8_t *sbuf, uint8_t b, Key k, Bits x) {
   uint8_t *vr = svs + kLambda * 3;
   uint8_t tl, tr;
 
-  for (int i = 0; i < x.bitlen; i++) {
+  for (int i = depth; i < x.bitlen; i++) {
     const uint8_t *cw = k.cws + i * kDcfCwLen;
     const uint8_t *s_cw = cw;
     const uint8_t *v_cw = cw + kLambda;
@@ -191,18 +223,182 @@ FSS_CUDA_HOST_DEVICE void dcf_eval(uint8_t *sbuf, uint8_t b, Key k, Bits x) {
   memcpy(s, v, kLambda);
 }
 
+// | s | v | sl | vl | sr | vr |
+// |       | svs               |
+FSS_CUDA_HOST_DEVICE void dcf_eval(uint8_t *sbuf, uint8_t b, Key k, Bits x) {
+  uint8_t *s = sbuf;
+  uint8_t *v = sbuf + kLambda;
+  group_zero(v);
+  uint8_t t;
+  load_st(s, &t);
+  t = b;
+  dcf_eval_from(sbuf, b, k, x, 0, t);
+}
+
+void dcf_eval_frontier(uint8_t *sbuf, uint8_t b, Key k, const uint8_t *frontier, int depth, Bits x) {
+  // Top `depth` bits of `x`, MSB first, index the frontier
+  size_t idx = 0;
+  for (int i = 0; i < depth; i++) {
+    idx = idx << 1 | get_bit_lsb(x.bytes, x.bitlen - i - 1);
+  }
+  memcpy(sbuf, frontier + idx * kDcfFrontierNodeLen, kDcfFrontierNodeLen);
+  uint8_t t;
+  load_st(sbuf, &t);
+  dcf_eval_from(sbuf, b, k, x, depth, t);
+}
+
+// | ss | vs | svss | ts |
+// ss, vs and ts are per point and svss is 4 lambda per point
+void dcf_eval_batch(uint8_t *sbuf, uint8_t b, Key k, const Bits *xs, int n) {
+  uint8_t *ss = sbuf;
+  uint8_t *vs = sbuf + kLambda * n;
+  uint8_t *svss = sbuf + kLambda * 2 * n;
+  uint8_t *ts = sbuf + kLambda * 6 * n;
+  uint8_t t;
+  load_st(ss, &t);
+  t = b;
+  for (int j = 0; j < n; j++) {
+    if (j > 0) memcpy(ss + j * kLambda, ss, kLambda);
+    group_zero(vs + j * kLambda);
+    ts[j] = t;
+  }
+
+  int bitlen = xs[0].bitlen;
+  for (int i = 0; i < bitlen; i++) {
+    const uint8_t *cw = k.cws + i * kDcfCwLen;
+    const uint8_t *s_cw = cw;
+    const uint8_t *v_cw = cw + kLambda;
+    uint8_t tl_cw, tr_cw;
+    get_cwt(cw, &tl_cw, &tr_cw);
+
+    prg_n(svss, 4 * kLambda, ss, n);
+
+    for (int j = 0; j < n; j++) {
+      uint8_t *s = ss + j * kLambda;
+      uint8_t *v = vs + j * kLambda;
+      uint8_t *svs = svss + j * kLambda * 4;
+      uint8_t *sl = svs;
+      uint8_t *vl = svs + kLambda;
+      uint8_t *sr = svs + kLambda * 2;
+      uint8_t *vr = svs + kLambda * 3;
+      uint8_t tl, tr;
+      t = ts[j];
+
+      load_svst(svs, &tl, &tr);
+      // Actually get MSB first
+      uint8_t x_i = get_bit_lsb(xs[j].bytes, bitlen - i - 1);
+      uint8_t *s_next = x_i ? sr : sl;
+      uint8_t t_next = x_i ? tr : tl;
+      if (t) {
+        xor_bytes(s_next, s_cw, kLambda);
+        t_next ^= x_i ? tr_cw : tl_cw;
+      }
+
+      uint8_t *v_delta = x_i ? vr : vl;
+      if (t) group_add(v_delta, v_cw);
+      if (b) group_neg(v_delta);
+      group_add(v, v_delta);
+
+      memcpy(s, s_next, kLambda);
+      ts[j] = t_next;
+    }
+  }
+
+  for (int j = 0; j < n; j++) {
+    uint8_t *s = ss + j * kLambda;
+    uint8_t *v = vs + j * kLambda;
+    if (ts[j]) group_add(s, k.cw_np1);
+    if (b) group_neg(s);
+    group_add(v, s);
+    memcpy(s, v, kLambda);
+  }
+}
+
+void dcf_key_batch_from_keys(KeyBatch kb, const Key *ks) {
+  for (int j = 0; j < kb.n; j++) {
+    for (int i = 0; i < kb.bitlen; i++) {
+      memcpy(kb.cws + ((size_t)i * kb.n + j) * kDcfCwLen, ks[j].cws + i * kDcfCwLen, kDcfCwLen);
+    }
+    memcpy(kb.cw_np1s + j * kLambda, ks[j].cw_np1, kLambda);
+  }
+}
+
+// Levels of correction words to prefetch ahead
+#define kMultikeyPrefetchLevels 1
+
+// | ss | vs | svss | ts |
+// ss, vs and ts are per key and svss is 4 lambda per key
+void dcf_eval_multikey(uint8_t *sbuf, uint8_t b, KeyBatch kb, Bits x) {
+  int n = kb.n;
+  uint8_t *ss = sbuf;
+  uint8_t *vs = sbuf + kLambda * n;
+  uint8_t *svss = sbuf + kLambda * 2 * n;
+  uint8_t *ts = sbuf + kLambda * 6 * n;
+  for (int j = 0; j < n; j++) {
+    load_st(ss + j * kLambda, &ts[j]);
+    ts[j] = b;
+    group_zero(vs + j * kLambda);
+  }
+
+  for (int i = 0; i < kb.bitlen; i++) {
+    const uint8_t *cws = kb.cws + (size_t)i * n * kDcfCwLen;
+    // Actually get MSB first
+    uint8_t x_i = get_bit_lsb(x.bytes, x.bitlen - i - 1);
+
+    // The left child is the first 2 blocks, so only the right child needs all 4
+    int out_len = x_i ? 4 * kLambda : 2 * kLambda;
+    prg_n(svss, out_len, ss, n);
+
+    const uint8_t *cws_ahead = cws + (size_t)kMultikeyPrefetchLevels * n * kDcfCwLen;
+    int prefetch = i + kMultikeyPrefetchLevels < kb.bitlen;
+    for (int j = 0; j < n; j++) {
+      const uint8_t *cw = cws + j * kDcfCwLen;
+      if (prefetch) __builtin_prefetch(cws_ahead + j * kDcfCwLen);
+      const uint8_t *s_cw = cw;
+      const uint8_t *v_cw = cw + kLambda;
+      uint8_t tl_cw, tr_cw;
+      get_cwt(cw, &tl_cw, &tr_cw);
+
+      uint8_t *s_next = svss + j * out_len + x_i * kLambda * 2;
+      uint8_t *v_delta = s_next + kLambda;
+      uint8_t t_next;
+      load_st(s_next, &t_next);
+      set_bit_lsb(v_delta, kLambda * 8 - 1, 0);
+      if (ts[j]) {
+        xor_bytes(s_next, s_cw, kLambda);
+        t_next ^= x_i ? tr_cw : tl_cw;
+        group_add(v_delta, v_cw);
+      }
+      if (b) group_neg(v_delta);
+      group_add(vs + j * kLambda, v_delta);
+
+      memcpy(ss + j * kLambda, s_next, kLambda);
+      ts[j] = t_next;
+    }
+  }
+
+  for (int j = 0; j < n; j++) {
+    uint8_t *s = ss + j * kLambda;
+    uint8_t *v = vs + j * kLambda;
+    if (ts[j]) group_add(s, kb.cw_np1s + j * kLambda);
+    if (b) group_neg(s);
+    group_add(v, s);
+    memcpy(s, v, kLambda);
+  }
+}
+
 #include <assert.h>
 #include <stdlib.h>
-#include <omp.h>
+#include "pool.h"
+#include "full_domain.h"
 
-void dcf_eval_full_domain_node(int depth, uint8_t *sbufl, uint8_t *sbufr, uint8_t b, Key k, uint8_t *vs_alloc) {
+void dcf_eval_full_domain_node(int depth, uint8_t *sbufl, uint8_t *sbufr, uint8_t b, Key k) {
   uint8_t *s = sbufl;
   uint8_t *v = sbufl + kLambda;
   uint8_t t;
   load_st(s, &t);
 
-  uint8_t *svs = (uint8_t *)malloc(kLambda * 4);
-  assert(svs != NULL);
+  uint8_t svs[kLambda * 4];
   uint8_t *sl = svs;
   uint8_t *vl = svs + kLambda;
   uint8_t *sr = svs + kLambda * 2;
@@ -226,14 +422,7 @@ void dcf_eval_full_domain_node(int depth, uint8_t *sbufl, uint8_t *sbufr, uint8_
 
   uint8_t *vl_out = v;
   uint8_t *vr_out = sbufr + kLambda;
-  if (vs_alloc) {
-    vl_out = vs_alloc;
-    memcpy(vl_out, v, kLambda);
-    vr_out = vs_alloc + kLambda;
-    memcpy(vr_out, v, kLambda);
-  } else {
-    memcpy(vr_out, v, kLambda);
-  }
+  memcpy(vr_out, v, kLambda);
 
   if (t) {
     group_add(vl, v_cw);
@@ -251,61 +440,109 @@ void dcf_eval_full_domain_node(int depth, uint8_t *sbufl, uint8_t *sbufr, uint8_
   set_st(sbufl, tl);
   memcpy(sbufr, sr, kLambda);
   set_st(sbufr, tr);
-  free(svs);
 }
 
-void dcf_eval_full_domain_leaf(uint8_t *sbuf, uint8_t b, Key k, uint8_t *v) {
-  uint8_t *s = sbuf;
-  uint8_t t;
-  load_st(s, &t);
+// Height of subtrees evaluated breadth-first with prg_n(), i.e., up to 2 ^ this leaves per batch
+#define kFullDomainBlockDepth 4
+
+// Eval all leaves of the subtree whose root is at `sbuf`, breadth-first so that each level is 1 prg_n() call.
+// `s` of the root is at first lambda bytes with `t` in its MSB, and `v` of the root is at next lambda bytes.
+// Output is stored at each lambda bytes of `sbuf`.
+void dcf_eval_full_domain_block(int depth, uint8_t *sbuf, uint8_t b, Key k, int height) {
+  uint8_t ss[kLambda << kFullDomainBlockDepth];
+  uint8_t vs[kLambda << kFullDomainBlockDepth];
+  uint8_t ts[1 << kFullDomainBlockDepth];
+  uint8_t svss[(kLambda * 4) << (kFullDomainBlockDepth - 1)];
+  assert(height <= kFullDomainBlockDepth);
+
+  memcpy(ss, sbuf, kLambda);
+  load_st(ss, &ts[0]);
+  memcpy(vs, sbuf + kLambda, kLambda);
+
+  for (int h = 0; h < height; h++) {
+    int width = 1 << h;
+    const uint8_t *cw = k.cws + (depth + h) * kDcfCwLen;
+    const uint8_t *s_cw = cw;
+    const uint8_t *v_cw = cw + kLambda;
+    uint8_t tl_cw, tr_cw;
+    get_cwt(cw, &tl_cw, &tr_cw);
 
-  if (t) group_add(s, k.cw_np1);
-  if (b) group_neg(s);
-  group_add(v, s);
-  memcpy(s, v, kLambda);
+    prg_n(svss, 4 * kLambda, ss, width);
+
+    // Children of node j are 2j and 2j + 1, so go backward to not overwrite unvisited nodes
+    for (int j = width - 1; j >= 0; j--) {
+      uint8_t *svs = svss + j * kLambda * 4;
+      uint8_t *sl = svs;
+      uint8_t *vl = svs + kLambda;
+      uint8_t *sr = svs + kLambda * 2;
+      uint8_t *vr = svs + kLambda * 3;
+      uint8_t tl, tr;
+      uint8_t t = ts[j];
+
+      load_svst(svs, &tl, &tr);
+      if (t) {
+        xor_bytes(sl, s_cw, kLambda);
+        xor_bytes(sr, s_cw, kLambda);
+        tl ^= tl_cw;
+        tr ^= tr_cw;
+        group_add(vl, v_cw);
+        group_add(vr, v_cw);
+      }
+      if (b) {
+        group_neg(vl);
+        group_neg(vr);
+      }
+
+      uint8_t *v = vs + j * kLambda;
+      uint8_t *vl_out = vs + 2 * j * kLambda;
+      uint8_t *vr_out = vs + (2 * j + 1) * kLambda;
+      memcpy(vr_out, v, kLambda);
+      memmove(vl_out, v, kLambda);
+      group_add(vl_out, vl);
+      group_add(vr_out, vr);
+      memcpy(ss + 2 * j * kLambda, sl, kLambda);
+      memcpy(ss + (2 * j + 1) * kLambda, sr, kLambda);
+      ts[2 * j] = tl;
+      ts[2 * j + 1] = tr;
+    }
+  }
+
+  for (int j = 0; j < (1 << height); j++) {
+    uint8_t *s = ss + j * kLambda;
+    if (ts[j]) group_add(s, k.cw_np1);
+    if (b) group_neg(s);
+    group_add(vs + j * kLambda, s);
+    memcpy(sbuf + j * kLambda, vs + j * kLambda, kLambda);
+  }
 }
 
-void dcf_eval_full_domain_subtree(
-  int depth, uint8_t *sbuf, size_t l, size_t r, uint8_t b, Key k, int x_bitlen, uint8_t *v_alloc, int par_depth) {
+void dcf_eval_full_domain_subtree(int depth, uint8_t *sbuf, size_t l, size_t r, uint8_t b, Key k, int x_bitlen) {
   assert(kLambda * (1ULL << (x_bitlen - depth)) == r - l);
 
-  if (depth == x_bitlen) {
-    dcf_eval_full_domain_leaf(sbuf + l, b, k, v_alloc);
+  if (x_bitlen - depth <= kFullDomainBlockDepth) {
+    dcf_eval_full_domain_block(depth, sbuf + l, b, k, x_bitlen - depth);
     return;
-  } else {
-    assert(v_alloc == NULL);
   }
 
   size_t mid = (l + r) / 2;
+  dcf_eval_full_domain_node(depth, sbuf + l, sbuf + mid, b, k);
+  dcf_eval_full_domain_subtree(depth + 1, sbuf, l, mid, b, k, x_bitlen);
+  dcf_eval_full_domain_subtree(depth + 1, sbuf, mid, r, b, k, x_bitlen);
+}
 
-  if (depth == x_bitlen - 1) {
-    v_alloc = (uint8_t *)malloc(2 * kLambda);
-    assert(v_alloc != NULL);
-    dcf_eval_full_domain_node(depth, sbuf + l, sbuf + mid, b, k, v_alloc);
-  } else {
-    dcf_eval_full_domain_node(depth, sbuf + l, sbuf + mid, b, k, v_alloc);
-  }
+static const FullDomainTree kDcfFullDomainTree = {
+  dcf_eval_full_domain_node, dcf_eval_full_domain_subtree, kFullDomainBlockDepth};
 
-  uint8_t *vl_alloc = v_alloc ? v_alloc : NULL;
-  uint8_t *vr_alloc = v_alloc ? v_alloc + kLambda : NULL;
-  if (depth < par_depth) {
-#pragma omp parallel
-#pragma omp single
-    {
-#pragma omp task
-      { dcf_eval_full_domain_subtree(depth + 1, sbuf, l, mid, b, k, x_bitlen, vl_alloc, par_depth); }
-#pragma omp task
-      { dcf_eval_full_domain_subtree(depth + 1, sbuf, mid, r, b, k, x_bitlen, vr_alloc, par_depth); }
-#pragma omp taskwait
-    }
-  } else {
-    dcf_eval_full_domain_subtree(depth + 1, sbuf, l, mid, b, k, x_bitlen, vl_alloc, par_depth);
-    dcf_eval_full_domain_subtree(depth + 1, sbuf, mid, r, b, k, x_bitlen, vr_alloc, par_depth);
-  }
+void dcf_full_domain_set_grain(int grain_bitlen) {
+  full_domain_set_grain(grain_bitlen);
+}
 
-  if (depth == x_bitlen - 1) {
-    free(v_alloc);
-  }
+void dcf_frontier_build(uint8_t *frontier, uint8_t b, Key k, int depth) {
+  group_zero(frontier + kLambda);
+  set_st(frontier, b);
+
+  // The same in-place breadth-first expansion as the top levels of full domain eval, ending with a stride of 1 node
+  full_domain_expand(pool_get(), &kDcfFullDomainTree, frontier, (size_t)kDcfFrontierNodeLen << depth, b, k, depth);
 }
 
 void dcf_eval_full_domain(uint8_t *sbuf, uint8_t b, Key k, int x_bitlen) {
@@ -315,13 +552,60 @@ void dcf_eval_full_domain(uint8_t *sbuf, uint8_t b, Key k, int x_bitlen) {
   uint8_t t = b;
   set_st(s, t);
 
-  int threads = omp_get_max_threads();
-  int par_depth = 0;
-  while ((1 << par_depth) <= threads) {
-    par_depth++;
+  full_domain_eval(&kDcfFullDomainTree, sbuf, b, k, x_bitlen);
+}
+
+typedef struct {
+  uint64_t *ys;
+  // Nodes at `depth`, each 2 lambda
+  const uint8_t *frontier;
+  // Per worker, each `scratch_len`
+  uint8_t *scratches;
+  size_t scratch_len;
+  uint8_t b;
+  Key k;
+  int depth;
+  int x_bitlen;
+} FullDomainU64Ctx;
+
+// Full domain eval of 1 subtree in the worker's scratch, then keep the low 8 bytes of each output
+static void dcf_eval_full_domain_u64_task(void *ctx, size_t i) {
+  FullDomainU64Ctx *c = (FullDomainU64Ctx *)ctx;
+  uint8_t *scratch = c->scratches + pool_worker_id() * c->scratch_len;
+  memcpy(scratch, c->frontier + i * kDcfFrontierNodeLen, kDcfFrontierNodeLen);
+  size_t leaf_num = 1ULL << (c->x_bitlen - c->depth);
+  dcf_eval_full_domain_subtree(c->depth, scratch, 0, leaf_num * kLambda, c->b, c->k, c->x_bitlen);
+
+  uint64_t *ys = c->ys + i * leaf_num;
+  for (size_t j = 0; j < leaf_num; j++) {
+    memcpy(ys + j, scratch + j * kLambda, sizeof(uint64_t));
   }
-  par_depth--;
+}
+
+// | frontier | scratch of worker 0 | ... |
+size_t dcf_full_domain_u64_sbuf_len(int x_bitlen) {
+  int threads = pool_thread_num(pool_get());
+  int top_depth = full_domain_top_depth(&kDcfFullDomainTree, x_bitlen, threads);
+  // The root of a subtree takes 2 lambda
+  size_t scratch_len = kLambda * ((1ULL << (x_bitlen - top_depth)) + 1);
+  return ((size_t)kDcfFrontierNodeLen << top_depth) + scratch_len * threads;
+}
 
-  size_t sbuf_len = kLambda * (1ULL << x_bitlen);
-  dcf_eval_full_domain_subtree(0, sbuf, 0, sbuf_len, b, k, x_bitlen, NULL, par_depth);
+void dcf_eval_full_domain_u64(uint64_t *ys, uint8_t *sbuf, uint8_t b, Key k, int x_bitlen) {
+  Pool *pool = pool_get();
+  int threads = pool_thread_num(pool);
+  int top_depth = full_domain_top_depth(&kDcfFullDomainTree, x_bitlen, threads);
+
+  dcf_frontier_build(sbuf, b, k, top_depth);
+
+  FullDomainU64Ctx ctx;
+  ctx.ys = ys;
+  ctx.frontier = sbuf;
+  ctx.scratches = sbuf + ((size_t)kDcfFrontierNodeLen << top_depth);
+  ctx.scratch_len = kLambda * ((1ULL << (x_bitlen - top_depth)) + 1);
+  ctx.b = b;
+  ctx.k = k;
+  ctx.depth = top_depth;
+  ctx.x_bitlen = x_bitlen;
+  pool_for(pool, 1ULL << top_depth, 1, dcf_eval_full_domain_u64_task, &ctx);
 }
@@ -0,0 +1,199 @@
+// SPDX-License-Identifier: Apache-2.0
+
+#include <fss/dcf_bool.h>
+#include <string.h>
+#include "utils.h"
+
+#define kVBit (kLambda * 8 - 2)
+
+// Load the 1bit t from MSB and the 1bit v from the 2nd MSB
+static inline void load_stv(uint8_t *s, uint8_t *t, uint8_t *v) {
+  load_st(s, t);
+  *v = get_bit_lsb(s, kVBit);
+  set_bit_lsb(s, kVBit, 0);
+}
+
+// Save the 2bit tl tr in an extra byte
+static inline void set_cwt(uint8_t *cw, uint8_t tl, uint8_t tr) {
+  cw[kLambda] = tl << 1 | tr;
+}
+
+static inline void get_cwt(const uint8_t *cw, uint8_t *tl, uint8_t *tr) {
+  *tl = cw[kLambda] >> 1;
+  *tr = cw[kLambda] & 1;
+}
+
+// Seed correction with v correction removed
+static inline void xor_s_cw(uint8_t *s, const uint8_t *cw) {
+  xor_bytes(s, cw, kLambda);
+  set_bit_lsb(s, kVBit, 0);
+}
+
+// Convert a seed to a bit
+static inline uint8_t s_to_bit(const uint8_t *s) {
+  return s[0] & 1;
+}
+
+// | s0 | s1 | s0l | s0r | s1l | s1r |
+// | ss      | s0s       | s1s       |
+void dcf_bool_gen(Key k, CmpFunc cf, uint8_t *sbuf) {
+  uint8_t *s0 = sbuf;
+  uint8_t *s1 = sbuf + kLambda;
+  uint8_t t0 = 0, t1 = 1;
+  uint8_t v = 0;
+  set_bit_lsb(s0, kLambda * 8 - 1, 0);
+  set_bit_lsb(s1, kLambda * 8 - 1, 0);
+  Point p = cf.point;
+  uint8_t beta = p.beta[0] & 1;
+
+  uint8_t *s0s = sbuf + kLambda * 2;
+  uint8_t *s0l = s0s;
+  uint8_t *s0r = s0s + kLambda;
+  uint8_t *s1s = sbuf + kLambda * 4;
+  uint8_t *s1l = s1s;
+  uint8_t *s1r = s1s + kLambda;
+  uint8_t t0l, t0r, t1l, t1r;
+  uint8_t v0l, v0r, v1l, v1r;
+
+  for (int i = 0; i < p.alpha.bitlen; i++) {
+    prg(s0s, 2 * kLambda, s0);
+    prg(s1s, 2 * kLambda, s1);
+    load_stv(s0l, &t0l, &v0l);
+    load_stv(s0r, &t0r, &v0r);
+    load_stv(s1l, &t1l, &v1l);
+    load_stv(s1r, &t1r, &v1r);
+
+    // Actually get MSB first
+    uint8_t alpha_i = get_bit_lsb(p.alpha.bytes, p.alpha.bitlen - i - 1);
+    uint8_t *cw = k.cws + i * kDcfBoolCwLen;
+
+    uint8_t *s_cw = cw;
+    memcpy(s_cw, alpha_i ? s0l : s0r, kLambda);
+    xor_bytes(s_cw, alpha_i ? s1l : s1r, kLambda);
+
+    uint8_t v0_lose = alpha_i ? v0l : v0r;
+    uint8_t v1_lose = alpha_i ? v1l : v1r;
+    uint8_t v0_keep = alpha_i ? v0r : v0l;
+    uint8_t v1_keep = alpha_i ? v1r : v1l;
+    uint8_t v_cw = v0_lose ^ v1_lose ^ v;
+    switch (cf.bound) {
+      case kLtAlpha:
+        if (alpha_i) v_cw ^= beta;
+        break;
+      case kGtAlpha:
+        if (!alpha_i) v_cw ^= beta;
+        break;
+    }
+    v ^= v0_keep ^ v1_keep ^ v_cw;
+    set_bit_lsb(cw, kVBit, v_cw);
+
+    uint8_t tl_cw, tr_cw;
+    tl_cw = t0l ^ t1l ^ alpha_i ^ 1;
+    tr_cw = t0r ^ t1r ^ alpha_i;
+    set_cwt(cw, tl_cw, tr_cw);
+
+    uint8_t *s0_keep = alpha_i ? s0r : s0l;
+    uint8_t *s1_keep = alpha_i ? s1r : s1l;
+    uint8_t t0_keep = alpha_i ? t0r : t0l;
+    uint8_t t1_keep = alpha_i ? t1r : t1l;
+    uint8_t t_cw_keep = alpha_i ? tr_cw : tl_cw;
+
+    memcpy(s0, s0_keep, kLambda);
+    if (t0) xor_s_cw(s0, cw);
+    memcpy(s1, s1_keep, kLambda);
+    if (t1) xor_s_cw(s1, cw);
+
+    if (t0) t0 = t0_keep ^ t_cw_keep;
+    else t0 = t0_keep;
+    if (t1) t1 = t1_keep ^ t_cw_keep;
+    else t1 = t1_keep;
+  }
+
+  k.cw_np1[0] = s_to_bit(s0) ^ s_to_bit(s1) ^ v;
+}
+
+// | s | sl | sr |
+// |   | ss      |
+uint8_t dcf_bool_eval(uint8_t *sbuf, uint8_t b, Key k, Bits x) {
+  uint8_t *s = sbuf;
+  uint8_t t = b;
+  uint8_t v = 0;
+  set_bit_lsb(s, kLambda * 8 - 1, 0);
+
+  uint8_t *ss = sbuf + kLambda;
+  uint8_t *sl = ss;
+  uint8_t *sr = ss + kLambda;
+  uint8_t tl, tr, vl, vr;
+
+  for (int i = 0; i < x.bitlen; i++) {
+    const uint8_t *cw = k.cws + i * kDcfBoolCwLen;
+    uint8_t tl_cw, tr_cw;
+    get_cwt(cw, &tl_cw, &tr_cw);
+    uint8_t v_cw = get_bit_lsb(cw, kVBit);
+
+    prg(ss, 2 * kLambda, s);
+    load_stv(sl, &tl, &vl);
+    load_stv(sr, &tr, &vr);
+
+    // Actually get MSB first
+    uint8_t x_i = get_bit_lsb(x.bytes, x.bitlen - i - 1);
+
+    v ^= (x_i ? vr : vl) ^ (t & v_cw);
+    memcpy(s, x_i ? sr : sl, kLambda);
+    if (t) xor_s_cw(s, cw);
+    if (t) t = (x_i ? tr : tl) ^ (x_i ? tr_cw : tl_cw);
+    else t = x_i ? tr : tl;
+  }
+
+  return v ^ s_to_bit(s) ^ (t & k.cw_np1[0] & 1);
+}
+
+// | ss | svss | ts | vs |
+// ss, ts and vs are per point and svss is 2 lambda per point
+void dcf_bool_eval_batch(uint64_t *ys, uint8_t *sbuf, uint8_t b, Key k, const Bits *xs, int n) {
+  uint8_t *ss = sbuf;
+  uint8_t *svss = sbuf + kLambda * n;
+  uint8_t *ts = sbuf + kLambda * 3 * n;
+  uint8_t *vs = ts + n;
+  set_bit_lsb(ss, kLambda * 8 - 1, 0);
+  for (int j = 0; j < n; j++) {
+    if (j > 0) memcpy(ss + j * kLambda, ss, kLambda);
+    ts[j] = b;
+    vs[j] = 0;
+  }
+
+  int bitlen = xs[0].bitlen;
+  for (int i = 0; i < bitlen; i++) {
+    const uint8_t *cw = k.cws + i * kDcfBoolCwLen;
+    uint8_t tl_cw, tr_cw;
+    get_cwt(cw, &tl_cw, &tr_cw);
+    uint8_t v_cw = get_bit_lsb(cw, kVBit);
+
+    prg_n(svss, 2 * kLambda, ss, n);
+
+    for (int j = 0; j < n; j++) {
+      // Actually get MSB first
+      uint8_t x_i = get_bit_lsb(xs[j].bytes, bitlen - i - 1);
+      uint8_t *s_next = svss + (2 * j + x_i) * kLambda;
+      uint8_t t = ts[j];
+      uint8_t t_next, v_next;
+      load_stv(s_next, &t_next, &v_next);
+
+      vs[j] ^= v_next ^ (t & v_cw);
+      uint8_t *s = ss + j * kLambda;
+      memcpy(s, s_next, kLambda);
+      if (t) {
+        xor_s_cw(s, cw);
+        t_next ^= x_i ? tr_cw : tl_cw;
+      }
+      ts[j] = t_next;
+    }
+  }
+
+  memset(ys, 0, sizeof(uint64_t) * ((n + 63) / 64));
+  uint8_t cw_np1 = k.cw_np1[0] & 1;
+  for (int j = 0; j < n; j++) {
+    uint64_t y = vs[j] ^ s_to_bit(ss + j * kLambda) ^ (ts[j] & cw_np1);
+    ys[j / 64] |= y << (j % 64);
+  }
+}
@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <random>
+#include <cstdlib>
+#include <cstring>
+#include <climits>
+#include <cassert>
+#include <gtest/gtest.h>
+#include <fss/dcf_bool.h>
+
+using random_bytes_engine = std::independent_bits_engine<std::default_random_engine, CHAR_BIT, uint8_t>;
+
+class DcfBoolTest : public ::testing::TestWithParam<Bound> {
+ protected:
+  void SetUp() override {
+    std::random_device rd;
+    random_bytes_engine rbe(rd());
+    uint8_t keys[4 * kLambda];
+    std::generate(std::begin(keys), std::end(keys), std::ref(rbe));
+    prg_init((uint8_t *)keys, 4 * kLambda);
+    std::generate(std::begin(s0s), std::end(s0s), std::ref(rbe));
+    gen.seed(rd());
+
+    key.cw_np1 = (uint8_t *)malloc(1);
+    key.cws = (uint8_t *)malloc(kDcfBoolCwLen * kAlphaBitlen);
+    assert(key.cw_np1 != NULL && key.cws != NULL);
+  }
+
+  void TearDown() override {
+    prg_free();
+    free(key.cw_np1);
+    free(key.cws);
+  }
+
+  void Gen(uint16_t alpha, Bound bound) {
+    alpha_int = alpha;
+    Bits alpha_bits = {(uint8_t *)&alpha_int, kAlphaBitlen};
+    uint8_t beta[kLambda];
+    memset(beta, 0, kLambda);
+    beta[0] = 1;
+    CmpFunc cf = {{alpha_bits, beta}, bound};
+    uint8_t sbuf[kLambda * 6];
+    memcpy(sbuf, s0s, kLambda * 2);
+    dcf_bool_gen(key, cf, sbuf);
+  }
+
+  static uint8_t Expected(uint16_t x, uint16_t alpha, Bound bound) {
+    return bound == kLtAlpha ? x < alpha : x > alpha;
+  }
+
+  static constexpr int kAlphaBitlen = 16;
+
+  std::mt19937 gen;
+  uint8_t s0s[kLambda * 2];
+  uint16_t alpha_int;
+  Key key;
+};
+
+TEST_P(DcfBoolTest, EvalAtRandPoints) {
+  Bound bound = GetParam();
+  std::uniform_int_distribution<uint16_t> dis(0, UINT16_MAX);
+  constexpr int kNumKeys = 4;
+  constexpr int kNumTrials = 100;
+
+  for (int i = 0; i < kNumKeys; i++) {
+    uint16_t alpha = i == 0 ? 0 : i == 1 ? UINT16_MAX : dis(gen);
+    Gen(alpha, bound);
+    for (int j = 0; j < kNumTrials; j++) {
+      uint16_t x = j == 0 ? alpha : j == 1 ? alpha - 1 : j == 2 ? alpha + 1 : dis(gen);
+      Bits x_bits = {(uint8_t *)&x, kAlphaBitlen};
+      uint8_t sbuf[kLambda * 3];
+      memcpy(sbuf, s0s, kLambda);
+      uint8_t y0 = dcf_bool_eval(sbuf, 0, key, x_bits);
+      memcpy(sbuf, s0s + kLambda, kLambda);
+      uint8_t y1 = dcf_bool_eval(sbuf, 1, key, x_bits);
+      EXPECT_EQ(y0 ^ y1, Expected(x, alpha, bound)) << "Result differ at x = " << x << ", alpha = " << alpha;
+    }
+  }
+}
+
+TEST_P(DcfBoolTest, EvalBatchEqEval) {
+  Bound bound = GetParam();
+  std::uniform_int_distribution<uint16_t> dis(0, UINT16_MAX);
+  // Not a multiple of 64 to cover the last partial word
+  constexpr int kN = 150;
+  uint16_t alpha = dis(gen);
+  Gen(alpha, bound);
+
+  uint16_t xs[kN];
+  Bits xs_bits[kN];
+  for (int j = 0; j < kN; j++) {
+    xs[j] = j == 0 ? alpha : dis(gen);
+    xs_bits[j] = {(uint8_t *)&xs[j], kAlphaBitlen};
+  }
+  uint8_t *sbuf = (uint8_t *)malloc(kN * (kLambda * 3 + 2));
+  assert(sbuf != NULL);
+  uint64_t ys[2][(kN + 63) / 64];
+  for (uint8_t b = 0; b < 2; b++) {
+    memcpy(sbuf, s0s + b * kLambda, kLambda);
+    dcf_bool_eval_batch(ys[b], sbuf, b, key, xs_bits, kN);
+  }
+
+  for (int j = 0; j < kN; j++) {
+    memcpy(sbuf, s0s, kLambda);
+    uint8_t y0 = dcf_bool_eval(sbuf, 0, key, xs_bits[j]);
+    EXPECT_EQ((ys[0][j / 64] >> (j % 64)) & 1, y0) << "Party 0 shares differ at x = " << xs[j];
+    uint8_t y = ((ys[0][j / 64] ^ ys[1][j / 64]) >> (j % 64)) & 1;
+    EXPECT_EQ(y, Expected(xs[j], alpha, bound)) << "Result differ at x = " << xs[j];
+  }
+  EXPECT_EQ(ys[0][kN / 64] >> (kN % 64), 0u) << "Unused bits are not 0";
+  free(sbuf);
+}
+
+INSTANTIATE_TEST_SUITE_P(Bounds, DcfBoolTest, ::testing::Values(kLtAlpha, kGtAlpha));
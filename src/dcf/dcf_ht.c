@@ -0,0 +1,227 @@
+// SPDX-License-Identifier: Apache-2.0
+
+#include <fss/dcf_ht.h>
+#include <string.h>
+#include <assert.h>
+#include "utils.h"
+#include "full_domain.h"
+
+static inline uint8_t get_t(const uint8_t *s) {
+  return get_bit_lsb(s, kLambda * 8 - 1);
+}
+
+// σ(l || r) = (l xor r || l) per 16B chunk, where l is the low 8B
+static inline void sigma(uint8_t *out, const uint8_t *s) {
+  for (int i = 0; i < kLambda; i += 16) {
+    memcpy(out + i + 8, s + i, 8);
+    memcpy(out + i, s + i, 8);
+    xor_bytes(out + i, s + i + 8, 8);
+  }
+}
+
+// `hw` = H(s) || value of s, where the value is a group element
+static inline void expand(uint8_t *hw, uint8_t *sigma_buf, const uint8_t *s) {
+  sigma(sigma_buf, s);
+  prg(hw, 2 * kLambda, sigma_buf);
+  set_bit_lsb(hw + kLambda, kLambda * 8 - 1, 0);
+}
+
+// | s0 | s1 | σ | h0 | w0 | h1 | w1 |
+// | ss      |   | hw0     | hw1     |
+void dcf_ht_gen(Key k, CmpFunc cf, uint8_t *sbuf) {
+  uint8_t *s0 = sbuf;
+  uint8_t *s1 = sbuf + kLambda;
+  uint8_t *sigma_buf = sbuf + kLambda * 2;
+  uint8_t *hw0 = sbuf + kLambda * 3;
+  uint8_t *h0 = hw0;
+  uint8_t *w0 = hw0 + kLambda;
+  uint8_t *hw1 = sbuf + kLambda * 5;
+  uint8_t *h1 = hw1;
+  uint8_t *w1 = hw1 + kLambda;
+  Point p = cf.point;
+
+  // Δ = s0 xor s1 with MSB(Δ) = 1, and the party bit is the root t
+  set_bit_lsb(s0, kLambda * 8 - 1, 0);
+  set_bit_lsb(s1, kLambda * 8 - 1, 1);
+  uint8_t delta[kLambda];
+  memcpy(delta, s0, kLambda);
+  xor_bytes(delta, s1, kLambda);
+
+  // Difference of the 2 parties' accumulated values on the path, i.e., share 0 - share 1
+  uint8_t d[kLambda];
+  memset(d, 0, kLambda);
+  uint8_t beta[kLambda];
+  memcpy(beta, p.beta, kLambda);
+  set_bit_lsb(beta, kLambda * 8 - 1, 0);
+
+  for (int i = 0; i < p.alpha.bitlen; i++) {
+    uint8_t t0 = get_t(s0), t1 = get_t(s1);
+    expand(hw0, sigma_buf, s0);
+    expand(hw1, sigma_buf, s1);
+    if (i > 0) {
+      group_add(d, w0);
+      group_neg(w1);
+      group_add(d, w1);
+    }
+
+    // Actually get MSB first
+    uint8_t alpha_i = get_bit_lsb(p.alpha.bytes, p.alpha.bitlen - i - 1);
+    uint8_t *cw = k.cws + i * kDcfHtCwLen;
+
+    // The lose child gets equal seeds and the keep child gets seeds differing by Δ
+    uint8_t *s_cw = cw;
+    memcpy(s_cw, h0, kLambda);
+    xor_bytes(s_cw, h1, kLambda);
+    if (!alpha_i) xor_bytes(s_cw, delta, kLambda);
+
+    // Off the path after this level, shares sum to d + (t0 - t1) * v_cw, which should be beta or 0
+    uint8_t *v_cw = cw + kLambda;
+    uint8_t cond = 0;
+    switch (cf.bound) {
+      case kLtAlpha:
+        cond = alpha_i;
+        break;
+      case kGtAlpha:
+        cond = !alpha_i;
+        break;
+    }
+    memcpy(v_cw, d, kLambda);
+    group_neg(v_cw);
+    if (cond) group_add(v_cw, beta);
+    if (t1) group_neg(v_cw);
+    // d += (t0 - t1) * v_cw
+    uint8_t v_cw_signed[kLambda];
+    memcpy(v_cw_signed, v_cw, kLambda);
+    if (t1) group_neg(v_cw_signed);
+    group_add(d, v_cw_signed);
+
+    // s_L = H(s) xor t * CW and s_R = s_L xor s
+    if (t0) xor_bytes(h0, s_cw, kLambda);
+    if (t1) xor_bytes(h1, s_cw, kLambda);
+    if (alpha_i) {
+      xor_bytes(s0, h0, kLambda);
+      xor_bytes(s1, h1, kLambda);
+    } else {
+      memcpy(s0, h0, kLambda);
+      memcpy(s1, h1, kLambda);
+    }
+  }
+
+  // Values of leaves
+  uint8_t t1 = get_t(s1);
+  expand(hw0, sigma_buf, s0);
+  expand(hw1, sigma_buf, s1);
+  group_add(d, w0);
+  group_neg(w1);
+  group_add(d, w1);
+
+  // (t0 - t1) * cw_np1 = -d
+  memcpy(k.cw_np1, d, kLambda);
+  if (!t1) group_neg(k.cw_np1);
+}
+
+// | s | σ | h | w |
+// |   |   | hw    |
+void dcf_ht_eval(uint8_t *sbuf, uint8_t b, Key k, Bits x) {
+  uint8_t *s = sbuf;
+  uint8_t *sigma_buf = sbuf + kLambda;
+  uint8_t *hw = sbuf + kLambda * 2;
+  uint8_t *h = hw;
+  uint8_t *w = hw + kLambda;
+  uint8_t v[kLambda];
+  group_zero(v);
+  set_bit_lsb(s, kLambda * 8 - 1, b);
+
+  for (int i = 0; i < x.bitlen; i++) {
+    const uint8_t *cw = k.cws + i * kDcfHtCwLen;
+    uint8_t t = get_t(s);
+    expand(hw, sigma_buf, s);
+    if (i > 0) group_add(v, w);
+    if (t) group_add(v, cw + kLambda);
+
+    // Actually get MSB first
+    uint8_t x_i = get_bit_lsb(x.bytes, x.bitlen - i - 1);
+    if (t) xor_bytes(h, cw, kLambda);
+    if (x_i) xor_bytes(s, h, kLambda);
+    else memcpy(s, h, kLambda);
+  }
+
+  uint8_t t = get_t(s);
+  expand(hw, sigma_buf, s);
+  group_add(v, w);
+  if (t) group_add(v, k.cw_np1);
+  if (b) group_neg(v);
+  memcpy(sbuf, v, kLambda);
+}
+
+// Expand the node at `sbufl`, whose seed is at first lambda bytes and accumulated value is at next lambda bytes,
+// to its children at `sbufl` and `sbufr`. `depth` is the depth of the node.
+// Inner nodes do not depend on the party bit `b`, which is only for the signature of FullDomainNodeFn.
+static void dcf_ht_eval_full_domain_node(int depth, uint8_t *sbufl, uint8_t *sbufr, uint8_t b, Key k) {
+  (void)b;
+  uint8_t *s = sbufl;
+  uint8_t *v = sbufl + kLambda;
+  uint8_t sigma_buf[kLambda];
+  uint8_t hw[kLambda * 2];
+  uint8_t *h = hw;
+  uint8_t *w = hw + kLambda;
+
+  const uint8_t *cw = k.cws + depth * kDcfHtCwLen;
+  uint8_t t = get_t(s);
+  expand(hw, sigma_buf, s);
+  if (depth > 0) group_add(v, w);
+  if (t) group_add(v, cw + kLambda);
+
+  if (t) xor_bytes(h, cw, kLambda);
+  // s_R = s_L xor s
+  memcpy(sbufr + kLambda, v, kLambda);
+  memcpy(sbufr, s, kLambda);
+  xor_bytes(sbufr, h, kLambda);
+  memcpy(sbufl, h, kLambda);
+}
+
+// Output of the leaf whose seed is at `sbuf` and accumulated value is `v`
+static void dcf_ht_eval_full_domain_leaf(uint8_t *sbuf, const uint8_t *v, uint8_t b, Key k) {
+  uint8_t sigma_buf[kLambda];
+  uint8_t hw[kLambda * 2];
+  uint8_t *w = hw + kLambda;
+  uint8_t t = get_t(sbuf);
+  expand(hw, sigma_buf, sbuf);
+  group_add(w, v);
+  if (t) group_add(w, k.cw_np1);
+  if (b) group_neg(w);
+  memcpy(sbuf, w, kLambda);
+}
+
+static void dcf_ht_eval_full_domain_subtree(
+  int depth, uint8_t *sbuf, size_t l, size_t r, uint8_t b, Key k, int x_bitlen) {
+  assert(kLambda * (1ULL << (x_bitlen - depth)) == r - l);
+
+  size_t mid = (l + r) / 2;
+  if (x_bitlen - depth == 1) {
+    // Leaves only have room for outputs, so expand to the stack
+    uint8_t svl[kLambda * 2], svr[kLambda * 2];
+    memcpy(svl, sbuf + l, kLambda * 2);
+    dcf_ht_eval_full_domain_node(depth, svl, svr, b, k);
+    memcpy(sbuf + l, svl, kLambda);
+    dcf_ht_eval_full_domain_leaf(sbuf + l, svl + kLambda, b, k);
+    memcpy(sbuf + mid, svr, kLambda);
+    dcf_ht_eval_full_domain_leaf(sbuf + mid, svr + kLambda, b, k);
+    return;
+  }
+
+  dcf_ht_eval_full_domain_node(depth, sbuf + l, sbuf + mid, b, k);
+  dcf_ht_eval_full_domain_subtree(depth + 1, sbuf, l, mid, b, k, x_bitlen);
+  dcf_ht_eval_full_domain_subtree(depth + 1, sbuf, mid, r, b, k, x_bitlen);
+}
+
+// Subtrees of height 1 expand their leaves on the stack, so the min height of a task is 1
+static const FullDomainTree kDcfHtFullDomainTree = {dcf_ht_eval_full_domain_node, dcf_ht_eval_full_domain_subtree, 1};
+
+void dcf_ht_eval_full_domain(uint8_t *sbuf, uint8_t b, Key k, int x_bitlen) {
+  assert(x_bitlen >= 1);
+  set_bit_lsb(sbuf, kLambda * 8 - 1, b);
+  memset(sbuf + kLambda, 0, kLambda);
+
+  full_domain_eval(&kDcfHtFullDomainTree, sbuf, b, k, x_bitlen);
+}
@@ -0,0 +1,155 @@
+#include <algorithm>
+#include <random>
+#include <cstdlib>
+#include <cstring>
+#include <climits>
+#include <cassert>
+#include <gtest/gtest.h>
+#include <fss/dcf_ht.h>
+#include <fss/dcf.h>
+
+using random_bytes_engine = std::independent_bits_engine<std::default_random_engine, CHAR_BIT, uint8_t>;
+
+class DcfHtTest : public ::testing::TestWithParam<Bound> {
+ protected:
+  void SetUp() override {
+    std::random_device rd;
+    random_bytes_engine rbe(rd());
+    uint8_t keys[4 * kLambda];
+    std::generate(std::begin(keys), std::end(keys), std::ref(rbe));
+    prg_init((uint8_t *)keys, 4 * kLambda);
+    std::generate(std::begin(s0s), std::end(s0s), std::ref(rbe));
+    gen.seed(rd());
+
+    key.cw_np1 = (uint8_t *)malloc(kLambda);
+    key.cws = (uint8_t *)malloc(kDcfHtCwLen * kAlphaBitlen);
+    assert(key.cw_np1 != NULL && key.cws != NULL);
+  }
+
+  void TearDown() override {
+    prg_free();
+    free(key.cw_np1);
+    free(key.cws);
+  }
+
+  void Gen(uint16_t alpha, Bound bound) {
+    alpha_int = alpha;
+    Bits alpha_bits = {(uint8_t *)&alpha_int, kAlphaBitlen};
+    uint8_t beta[kLambda];
+    memset(beta, 0, kLambda);
+    memcpy(beta, &kBeta, 8);
+    CmpFunc cf = {{alpha_bits, beta}, bound};
+    uint8_t sbuf[kLambda * 7];
+    memcpy(sbuf, s0s, kLambda * 2);
+    dcf_ht_gen(key, cf, sbuf);
+  }
+
+  uint64_t Eval(uint16_t x) {
+    Bits x_bits = {(uint8_t *)&x, kAlphaBitlen};
+    uint8_t sbuf[kLambda * 4];
+    memcpy(sbuf, s0s, kLambda);
+    dcf_ht_eval(sbuf, 0, key, x_bits);
+    uint8_t y0[kLambda];
+    memcpy(y0, sbuf, kLambda);
+    memcpy(sbuf, s0s + kLambda, kLambda);
+    dcf_ht_eval(sbuf, 1, key, x_bits);
+    group_add(y0, sbuf);
+    uint64_t y;
+    memcpy(&y, y0, 8);
+    return y;
+  }
+
+  static uint64_t Expected(uint16_t x, uint16_t alpha, Bound bound) {
+    return (bound == kLtAlpha ? x < alpha : x > alpha) ? kBeta : 0;
+  }
+
+  static constexpr int kAlphaBitlen = 16;
+  static constexpr uint64_t kBeta = 604;
+
+  std::mt19937 gen;
+  uint8_t s0s[kLambda * 2];
+  uint16_t alpha_int;
+  Key key;
+};
+
+TEST_P(DcfHtTest, EvalAtRandPoints) {
+  Bound bound = GetParam();
+  std::uniform_int_distribution<uint16_t> dis(0, UINT16_MAX);
+  constexpr int kNumKeys = 4;
+  constexpr int kNumTrials = 100;
+
+  for (int i = 0; i < kNumKeys; i++) {
+    uint16_t alpha = i == 0 ? 0 : i == 1 ? UINT16_MAX : dis(gen);
+    Gen(alpha, bound);
+    for (int j = 0; j < kNumTrials; j++) {
+      uint16_t x = j == 0 ? alpha : j == 1 ? alpha - 1 : j == 2 ? alpha + 1 : dis(gen);
+      EXPECT_EQ(Eval(x), Expected(x, alpha, bound)) << "Result differ at x = " << x << ", alpha = " << alpha;
+    }
+  }
+}
+
+TEST_P(DcfHtTest, EvalFullDomainEqEval) {
+  Bound bound = GetParam();
+  std::uniform_int_distribution<uint16_t> dis(0, UINT16_MAX);
+  uint16_t alpha = dis(gen);
+  Gen(alpha, bound);
+
+  size_t sbuf_len = kLambda * (1ULL << kAlphaBitlen);
+  uint8_t *sbufs[2];
+  for (uint8_t b = 0; b < 2; b++) {
+    sbufs[b] = (uint8_t *)malloc(sbuf_len);
+    assert(sbufs[b] != NULL);
+    memcpy(sbufs[b], s0s + b * kLambda, kLambda);
+    dcf_ht_eval_full_domain(sbufs[b], b, key, kAlphaBitlen);
+  }
+
+  for (uint32_t x = 0; x <= UINT16_MAX; x++) {
+    uint8_t *y0 = sbufs[0] + x * kLambda;
+    if (x % 997 == 0) {
+      // Spot check party 0 shares against eval
+      uint16_t x16 = x;
+      Bits x_bits = {(uint8_t *)&x16, kAlphaBitlen};
+      uint8_t sbuf[kLambda * 4];
+      memcpy(sbuf, s0s, kLambda);
+      dcf_ht_eval(sbuf, 0, key, x_bits);
+      EXPECT_EQ(memcmp(sbuf, y0, 8), 0) << "Party 0 shares differ at x = " << x;
+    }
+    group_add(y0, sbufs[1] + x * kLambda);
+    uint64_t y;
+    memcpy(&y, y0, 8);
+    EXPECT_EQ(y, Expected(x, alpha, bound)) << "Result differ at x = " << x;
+  }
+  free(sbufs[0]);
+  free(sbufs[1]);
+}
+
+TEST_P(DcfHtTest, EvalFullDomainIndependentOfGrain) {
+  Bound bound = GetParam();
+  std::uniform_int_distribution<uint16_t> dis(0, UINT16_MAX);
+  Gen(dis(gen), bound);
+
+  size_t sbuf_len = kLambda * (1ULL << kAlphaBitlen);
+  uint8_t *ys_ref = (uint8_t *)malloc(sbuf_len);
+  uint8_t *ys = (uint8_t *)malloc(sbuf_len);
+  assert(ys_ref != NULL && ys != NULL);
+
+  for (uint8_t b = 0; b < 2; b++) {
+    dcf_full_domain_set_grain(kAlphaBitlen);
+    memcpy(ys_ref, s0s + b * kLambda, kLambda);
+    dcf_ht_eval_full_domain(ys_ref, b, key, kAlphaBitlen);
+
+    // Down to tasks of height 1, i.e., only the leaves expanded per task
+    for (int grain_bitlen : {1, 2, 5, 12}) {
+      dcf_full_domain_set_grain(grain_bitlen);
+      memcpy(ys, s0s + b * kLambda, kLambda);
+      dcf_ht_eval_full_domain(ys, b, key, kAlphaBitlen);
+      EXPECT_EQ(memcmp(ys, ys_ref, sbuf_len), 0) << "b = " << (int)b << ", grain_bitlen = " << grain_bitlen;
+    }
+  }
+  dcf_full_domain_set_grain(12);
+
+  free(ys_ref);
+  free(ys);
+}
+
+INSTANTIATE_TEST_SUITE_P(Bounds, DcfHtTest, ::testing::Values(kLtAlpha, kGtAlpha));
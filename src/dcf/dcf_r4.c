@@ -0,0 +1,191 @@
+// SPDX-License-Identifier: Apache-2.0
+
+#include <fss/dcf_r4.h>
+#include <string.h>
+#include "utils.h"
+
+// Input bits 2 * (level num - i) - 1 and the next lower one as a digit 0-3, where bit bitlen is the 0 padding
+static inline uint8_t get_digit(Bits x, int level_num, int i) {
+  int pos = (level_num - i) * 2 - 1;
+  uint8_t hi = pos < x.bitlen ? get_bit_lsb(x.bytes, pos) : 0;
+  uint8_t lo = get_bit_lsb(x.bytes, pos - 1);
+  return hi << 1 | lo;
+}
+
+// The seed with MSB set to `hi` is the PRG input for children 2 * `hi` and 2 * `hi` + 1
+static inline void set_hi(uint8_t *in, const uint8_t *s, uint8_t hi) {
+  memcpy(in, s, kLambda);
+  set_bit_lsb(in, kLambda * 8 - 1, hi);
+}
+
+// Load `t` of the child at `sv` and clear the MSB of its value
+static inline void load_svt(uint8_t *sv, uint8_t *t) {
+  load_st(sv, t);
+  set_bit_lsb(sv + kLambda, kLambda * 8 - 1, 0);
+}
+
+// Expand `s` to | s_0 | v_0 | s_1 | v_1 | s_2 | v_2 | s_3 | v_3 | at `svs`, with `in` of 2 * lambda as the PRG input
+static inline void expand_all(uint8_t *svs, uint8_t *in, const uint8_t *s, uint8_t *ts) {
+  set_hi(in, s, 0);
+  set_hi(in + kLambda, s, 1);
+  prg_n(svs, 4 * kLambda, in, 2);
+  for (int c = 0; c < 4; c++) {
+    load_svt(svs + c * 2 * kLambda, ts + c);
+  }
+}
+
+// | s0 | s1 | in | sv0s | sv1s |
+// | ss      |    | 8 lambda each |
+void dcf_r4_gen(Key k, CmpFunc cf, uint8_t *sbuf) {
+  uint8_t *s0 = sbuf;
+  uint8_t *s1 = sbuf + kLambda;
+  uint8_t *in = sbuf + kLambda * 2;
+  uint8_t *sv0s = sbuf + kLambda * 4;
+  uint8_t *sv1s = sbuf + kLambda * 12;
+  uint8_t *v = k.cw_np1;
+  group_zero(v);
+  uint8_t t0, t1;
+  load_st(s0, &t0);
+  load_st(s1, &t1);
+  t0 = 0;
+  t1 = 1;
+  Point p = cf.point;
+  int level_num = dcf_r4_level_num(p.alpha.bitlen);
+
+  uint8_t beta[kLambda];
+  uint8_t t0s[4], t1s[4];
+  uint8_t r[kLambda * 2];
+  uint8_t tmp[kLambda];
+
+  for (int i = 0; i < level_num; i++) {
+    // Pseudorandom corrections of the keep child so that it looks like the others.
+    // Parties only know 1 of s0 and s1, so s0 xor s1 is unknown to them.
+    memcpy(in, s0, kLambda);
+    xor_bytes(in, s1, kLambda);
+    prg(r, 2 * kLambda, in);
+    set_bit_lsb(r, kLambda * 8 - 1, 0);
+    set_bit_lsb(r + kLambda, kLambda * 8 - 1, 0);
+
+    expand_all(sv0s, in, s0, t0s);
+    expand_all(sv1s, in, s1, t1s);
+
+    uint8_t alpha_i = get_digit(p.alpha, level_num, i);
+    uint8_t *cw = k.cws + i * kDcfR4CwLen;
+    uint8_t *s_cws = cw;
+    uint8_t *v_cws = cw + kLambda * 4;
+    uint8_t t_cws = 0;
+    memcpy(beta, p.beta, kLambda);
+    set_bit_lsb(beta, kLambda * 8 - 1, 0);
+    if (t1) group_neg(beta);
+
+    for (int c = 0; c < 4; c++) {
+      uint8_t *s_cw = s_cws + c * kLambda;
+      uint8_t *v_cw = v_cws + c * kLambda;
+      uint8_t *s0c = sv0s + c * 2 * kLambda, *v0c = s0c + kLambda;
+      uint8_t *s1c = sv1s + c * 2 * kLambda, *v1c = s1c + kLambda;
+      if (c == alpha_i) {
+        memcpy(s_cw, r, kLambda);
+        memset(v_cw, 0, kLambda);
+        group_add(v_cw, r + kLambda);
+        t_cws |= (t0s[c] ^ t1s[c] ^ 1) << c;
+        continue;
+      }
+
+      // Lose children get equal seeds and equal t
+      memcpy(s_cw, s0c, kLambda);
+      xor_bytes(s_cw, s1c, kLambda);
+      t_cws |= (t0s[c] ^ t1s[c]) << c;
+
+      // Their value shares sum to beta or 0 with v
+      memcpy(v_cw, v1c, kLambda);
+      group_neg(v0c);
+      group_add(v_cw, v0c);
+      memcpy(tmp, v, kLambda);
+      group_neg(tmp);
+      group_add(v_cw, tmp);
+      if (t1) group_neg(v_cw);
+      switch (cf.bound) {
+        case kLtAlpha:
+          if (c < alpha_i) group_add(v_cw, beta);
+          break;
+        case kGtAlpha:
+          if (c > alpha_i) group_add(v_cw, beta);
+          break;
+      }
+    }
+    cw[kLambda * 8] = t_cws;
+
+    // v += v0_keep - v1_keep + (t0 - t1) * v_cw_keep
+    uint8_t *s0_keep = sv0s + alpha_i * 2 * kLambda, *v0_keep = s0_keep + kLambda;
+    uint8_t *s1_keep = sv1s + alpha_i * 2 * kLambda, *v1_keep = s1_keep + kLambda;
+    group_neg(v1_keep);
+    group_add(v, v1_keep);
+    group_add(v, v0_keep);
+    memcpy(tmp, v_cws + alpha_i * kLambda, kLambda);
+    if (t1) group_neg(tmp);
+    group_add(v, tmp);
+
+    uint8_t t_cw_keep = (t_cws >> alpha_i) & 1;
+    const uint8_t *s_cw_keep = s_cws + alpha_i * kLambda;
+    memcpy(s0, s0_keep, kLambda);
+    if (t0) xor_bytes(s0, s_cw_keep, kLambda);
+    memcpy(s1, s1_keep, kLambda);
+    if (t1) xor_bytes(s1, s_cw_keep, kLambda);
+
+    uint8_t t0_next = t0s[alpha_i], t1_next = t1s[alpha_i];
+    if (t0) t0_next ^= t_cw_keep;
+    if (t1) t1_next ^= t_cw_keep;
+    t0 = t0_next;
+    t1 = t1_next;
+  }
+
+  group_neg(s0);
+  group_add(s1, s0);
+  group_neg(v);
+  group_add(s1, v);
+  if (t1) group_neg(s1);
+  memcpy(k.cw_np1, s1, kLambda);
+}
+
+// | s | v | in | s_{2hi} | v_{2hi} | s_{2hi+1} | v_{2hi+1} |
+// |   |   |    | svs                                       |
+void dcf_r4_eval(uint8_t *sbuf, uint8_t b, Key k, Bits x) {
+  uint8_t *s = sbuf;
+  uint8_t *v = sbuf + kLambda;
+  uint8_t *in = sbuf + kLambda * 2;
+  uint8_t *svs = sbuf + kLambda * 3;
+  group_zero(v);
+  uint8_t t;
+  load_st(s, &t);
+  t = b;
+  int level_num = dcf_r4_level_num(x.bitlen);
+
+  for (int i = 0; i < level_num; i++) {
+    const uint8_t *cw = k.cws + i * kDcfR4CwLen;
+    uint8_t x_i = get_digit(x, level_num, i);
+    uint8_t hi = x_i >> 1, lo = x_i & 1;
+
+    // Only the 2 blocks of the child on the path are used
+    set_hi(in, s, hi);
+    prg(svs, 4 * kLambda, in);
+    uint8_t *s_next = svs + lo * 2 * kLambda;
+    uint8_t *v_delta = s_next + kLambda;
+    uint8_t t_next;
+    load_svt(s_next, &t_next);
+    if (t) {
+      xor_bytes(s_next, cw + x_i * kLambda, kLambda);
+      t_next ^= (cw[kLambda * 8] >> x_i) & 1;
+      group_add(v_delta, cw + kLambda * 4 + x_i * kLambda);
+    }
+    if (b) group_neg(v_delta);
+    group_add(v, v_delta);
+
+    memcpy(s, s_next, kLambda);
+    t = t_next;
+  }
+
+  if (t) group_add(s, k.cw_np1);
+  if (b) group_neg(s);
+  group_add(v, s);
+  memcpy(s, v, kLambda);
+}
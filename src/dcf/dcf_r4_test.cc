@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <random>
+#include <cstdlib>
+#include <cstring>
+#include <climits>
+#include <cassert>
+#include <gtest/gtest.h>
+#include <fss/dcf_r4.h>
+
+using random_bytes_engine = std::independent_bits_engine<std::default_random_engine, CHAR_BIT, uint8_t>;
+
+class DcfR4Test : public ::testing::TestWithParam<Bound> {
+ protected:
+  void SetUp() override {
+    std::random_device rd;
+    random_bytes_engine rbe(rd());
+    uint8_t keys[4 * kLambda];
+    std::generate(std::begin(keys), std::end(keys), std::ref(rbe));
+    prg_init((uint8_t *)keys, 4 * kLambda);
+    std::generate(std::begin(s0s), std::end(s0s), std::ref(rbe));
+    gen.seed(rd());
+
+    key.cw_np1 = (uint8_t *)malloc(kLambda);
+    key.cws = (uint8_t *)malloc(kDcfR4CwLen * dcf_r4_level_num(kMaxBitlen));
+    assert(key.cw_np1 != NULL && key.cws != NULL);
+  }
+
+  void TearDown() override {
+    prg_free();
+    free(key.cw_np1);
+    free(key.cws);
+  }
+
+  void Gen(uint16_t alpha, int bitlen, Bound bound) {
+    alpha_int = alpha;
+    Bits alpha_bits = {(uint8_t *)&alpha_int, bitlen};
+    uint8_t beta[kLambda];
+    memset(beta, 0, kLambda);
+    memcpy(beta, &kBeta, 8);
+    CmpFunc cf = {{alpha_bits, beta}, bound};
+    uint8_t sbuf[kLambda * 20];
+    memcpy(sbuf, s0s, kLambda * 2);
+    dcf_r4_gen(key, cf, sbuf);
+  }
+
+  uint64_t Eval(uint16_t x, int bitlen) {
+    Bits x_bits = {(uint8_t *)&x, bitlen};
+    uint8_t sbuf[kLambda * 7];
+    memcpy(sbuf, s0s, kLambda);
+    dcf_r4_eval(sbuf, 0, key, x_bits);
+    uint8_t y0[kLambda];
+    memcpy(y0, sbuf, kLambda);
+    memcpy(sbuf, s0s + kLambda, kLambda);
+    dcf_r4_eval(sbuf, 1, key, x_bits);
+    group_add(y0, sbuf);
+    uint64_t y;
+    memcpy(&y, y0, 8);
+    return y;
+  }
+
+  static uint64_t Expected(uint16_t x, uint16_t alpha, Bound bound) {
+    return (bound == kLtAlpha ? x < alpha : x > alpha) ? kBeta : 0;
+  }
+
+  static constexpr int kMaxBitlen = 16;
+  static constexpr uint64_t kBeta = 604;
+
+  std::mt19937 gen;
+  uint8_t s0s[kLambda * 2];
+  uint16_t alpha_int;
+  Key key;
+};
+
+TEST_P(DcfR4Test, EvalAtRandPoints) {
+  Bound bound = GetParam();
+  constexpr int kNumKeys = 4;
+  constexpr int kNumTrials = 100;
+
+  // Odd bitlens are padded
+  for (int bitlen : {kMaxBitlen - 1, kMaxBitlen}) {
+    uint16_t max = (1 << bitlen) - 1;
+    std::uniform_int_distribution<uint16_t> dis(0, max);
+    for (int i = 0; i < kNumKeys; i++) {
+      uint16_t alpha = i == 0 ? 0 : i == 1 ? max : dis(gen);
+      Gen(alpha, bitlen, bound);
+      for (int j = 0; j < kNumTrials; j++) {
+        uint16_t x = j == 0 ? alpha : j == 1 ? alpha - 1 : j == 2 ? alpha + 1 : dis(gen);
+        x &= max;
+        EXPECT_EQ(Eval(x, bitlen), Expected(x, alpha, bound))
+          << "Result differ at x = " << x << ", alpha = " << alpha << ", bitlen = " << bitlen;
+      }
+    }
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(Bounds, DcfR4Test, ::testing::Values(kLtAlpha, kGtAlpha));
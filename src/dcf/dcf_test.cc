@@ -464,3 +464,305 @@ TEST_F(DcfTest, EvalFullDomainEqEvalPointsForGtAlpha) {
   free(key.cws);
   free(sbuf);
 }
+
+TEST_F(DcfTest, EvalBatchEqEval) {
+  constexpr int kN = 37;
+  uint8_t *sbuf = (uint8_t *)malloc(kN * (kLambda * 6 + 1));
+  assert(sbuf != NULL);
+
+  Key key;
+  key.cw_np1 = (uint8_t *)malloc(kLambda);
+  assert(key.cw_np1 != NULL);
+  key.cws = (uint8_t *)malloc(kDcfCwLen * kAlphaBitlen);
+  assert(key.cws != NULL);
+
+  // Prepare comparison function
+  uint16_t alpha_int = kAlpha;
+  uint8_t *alpha = (uint8_t *)&alpha_int;
+  Bits alpha_bits = {alpha, kAlphaBitlen};
+  uint8_t *beta = (uint8_t *)malloc(kLambda);
+  assert(beta != NULL);
+  memset(beta, 0, kLambda);
+  memcpy(beta, &kBeta, 8);
+  Point p = {alpha_bits, beta};
+  CmpFunc cf = {p, kLtAlpha};
+
+  // Generate DCF keys
+  memcpy(sbuf, kS0s, kLambda * 2);
+  dcf_gen(key, cf, sbuf);
+
+  // Random points with alpha itself
+  std::random_device rd;
+  std::mt19937 gen(rd());
+  std::uniform_int_distribution<uint16_t> dis(0, UINT16_MAX);
+  uint16_t xs[kN];
+  Bits xs_bits[kN];
+  for (int j = 0; j < kN; j++) {
+    xs[j] = j == 0 ? kAlpha : dis(gen);
+    xs_bits[j] = {(uint8_t *)&xs[j], kAlphaBitlen};
+  }
+
+  for (uint8_t b = 0; b < 2; b++) {
+    memcpy(sbuf, kS0s + b * kLambda, kLambda);
+    dcf_eval_batch(sbuf, b, key, xs_bits, kN);
+    uint8_t *ys_batch = (uint8_t *)malloc(kN * kLambda);
+    assert(ys_batch != NULL);
+    memcpy(ys_batch, sbuf, kN * kLambda);
+
+    for (int j = 0; j < kN; j++) {
+      memcpy(sbuf, kS0s + b * kLambda, kLambda);
+      dcf_eval(sbuf, b, key, xs_bits[j]);
+      EXPECT_EQ(memcmp(sbuf, ys_batch + j * kLambda, kLambda), 0)
+        << "Party " << (int)b << " shares differ at x = " << xs[j];
+    }
+    free(ys_batch);
+  }
+
+  free(beta);
+  free(key.cw_np1);
+  free(key.cws);
+  free(sbuf);
+}
+
+TEST_F(DcfTest, EvalFrontierEqEval) {
+  constexpr int kNumTrials = 100;
+  uint8_t sbuf[kLambda * 10];
+
+  Key key;
+  key.cw_np1 = (uint8_t *)malloc(kLambda);
+  assert(key.cw_np1 != NULL);
+  key.cws = (uint8_t *)malloc(kDcfCwLen * kAlphaBitlen);
+  assert(key.cws != NULL);
+
+  // Prepare comparison function
+  uint16_t alpha_int = kAlpha;
+  uint8_t *alpha = (uint8_t *)&alpha_int;
+  Bits alpha_bits = {alpha, kAlphaBitlen};
+  uint8_t beta[kLambda];
+  memset(beta, 0, kLambda);
+  memcpy(beta, &kBeta, 8);
+  Point p = {alpha_bits, beta};
+  CmpFunc cf = {p, kLtAlpha};
+
+  // Generate DCF keys
+  memcpy(sbuf, kS0s, kLambda * 2);
+  dcf_gen(key, cf, sbuf);
+
+  std::random_device rd;
+  std::mt19937 gen(rd());
+  std::uniform_int_distribution<uint16_t> dis(0, UINT16_MAX);
+
+  // From the root to the leaves
+  for (int depth : {0, 1, 7, kAlphaBitlen}) {
+    for (uint8_t b = 0; b < 2; b++) {
+      uint8_t *frontier = (uint8_t *)malloc((size_t)kDcfFrontierNodeLen << depth);
+      assert(frontier != NULL);
+      memcpy(frontier, kS0s + b * kLambda, kLambda);
+      dcf_frontier_build(frontier, b, key, depth);
+
+      for (int j = 0; j < kNumTrials; j++) {
+        uint16_t x = j == 0 ? kAlpha : dis(gen);
+        Bits x_bits = {(uint8_t *)&x, kAlphaBitlen};
+        memcpy(sbuf, kS0s + b * kLambda, kLambda);
+        dcf_eval(sbuf, b, key, x_bits);
+        uint8_t y[kLambda];
+        memcpy(y, sbuf, kLambda);
+        dcf_eval_frontier(sbuf, b, key, frontier, depth, x_bits);
+        EXPECT_EQ(memcmp(sbuf, y, kLambda), 0)
+          << "Party " << (int)b << " shares differ at x = " << x << ", depth = " << depth;
+      }
+      free(frontier);
+    }
+  }
+
+  free(key.cw_np1);
+  free(key.cws);
+}
+
+TEST_F(DcfTest, EvalMultikeyEqEval) {
+  constexpr int kN = 37;
+  uint8_t *sbuf = (uint8_t *)malloc(kN * (kLambda * 6 + 1));
+  assert(sbuf != NULL);
+
+  // Keys of random alphas with their own seeds, where key 0 is of kAlpha
+  std::random_device rd;
+  std::mt19937 gen(rd());
+  std::uniform_int_distribution<uint16_t> dis(0, UINT16_MAX);
+  random_bytes_engine rbe(rd());
+  uint8_t beta[kLambda];
+  memset(beta, 0, kLambda);
+  memcpy(beta, &kBeta, 8);
+  Key keys[kN];
+  uint8_t *s0ss = (uint8_t *)malloc(kN * kLambda * 2);
+  assert(s0ss != NULL);
+  std::generate(s0ss, s0ss + kN * kLambda * 2, std::ref(rbe));
+  for (int j = 0; j < kN; j++) {
+    keys[j].cw_np1 = (uint8_t *)malloc(kLambda);
+    keys[j].cws = (uint8_t *)malloc(kDcfCwLen * kAlphaBitlen);
+    assert(keys[j].cw_np1 != NULL && keys[j].cws != NULL);
+    uint16_t alpha_int = j == 0 ? kAlpha : dis(gen);
+    Bits alpha_bits = {(uint8_t *)&alpha_int, kAlphaBitlen};
+    CmpFunc cf = {{alpha_bits, beta}, j % 2 ? kGtAlpha : kLtAlpha};
+    memcpy(sbuf, s0ss + j * kLambda * 2, kLambda * 2);
+    dcf_gen(keys[j], cf, sbuf);
+  }
+
+  KeyBatch kb;
+  kb.n = kN;
+  kb.bitlen = kAlphaBitlen;
+  kb.cws = (uint8_t *)malloc(kDcfCwLen * kAlphaBitlen * kN);
+  kb.cw_np1s = (uint8_t *)malloc(kLambda * kN);
+  assert(kb.cws != NULL && kb.cw_np1s != NULL);
+  dcf_key_batch_from_keys(kb, keys);
+
+  uint8_t *ys_multikey = (uint8_t *)malloc(kN * kLambda);
+  assert(ys_multikey != NULL);
+  for (uint16_t x : {kAlpha, (uint16_t)0, (uint16_t)UINT16_MAX, dis(gen), dis(gen)}) {
+    Bits x_bits = {(uint8_t *)&x, kAlphaBitlen};
+    for (uint8_t b = 0; b < 2; b++) {
+      for (int j = 0; j < kN; j++) {
+        memcpy(sbuf + j * kLambda, s0ss + (j * 2 + b) * kLambda, kLambda);
+      }
+      dcf_eval_multikey(sbuf, b, kb, x_bits);
+      memcpy(ys_multikey, sbuf, kN * kLambda);
+
+      for (int j = 0; j < kN; j++) {
+        memcpy(sbuf, s0ss + (j * 2 + b) * kLambda, kLambda);
+        dcf_eval(sbuf, b, keys[j], x_bits);
+        EXPECT_EQ(memcmp(sbuf, ys_multikey + j * kLambda, kLambda), 0)
+          << "Party " << (int)b << " shares of key " << j << " differ at x = " << x;
+      }
+    }
+  }
+
+  for (int j = 0; j < kN; j++) {
+    free(keys[j].cw_np1);
+    free(keys[j].cws);
+  }
+  free(kb.cws);
+  free(kb.cw_np1s);
+  free(ys_multikey);
+  free(s0ss);
+  free(sbuf);
+}
+
+TEST_F(DcfTest, GenNEqGen) {
+  constexpr int kN = 5;
+  uint8_t *sbuf = (uint8_t *)malloc(kN * (kLambda * 10 + 2));
+  assert(sbuf != NULL);
+
+  std::random_device rd;
+  std::mt19937 gen(rd());
+  std::uniform_int_distribution<uint16_t> dis(0, UINT16_MAX);
+  random_bytes_engine rbe(rd());
+  uint8_t beta[kLambda];
+  memset(beta, 0, kLambda);
+  memcpy(beta, &kBeta, 8);
+  uint16_t alphas[kN];
+  CmpFunc cfs[kN];
+  Key keys[kN], keys_n[kN];
+  uint8_t *s0ss = (uint8_t *)malloc(kN * kLambda * 2);
+  assert(s0ss != NULL);
+  std::generate(s0ss, s0ss + kN * kLambda * 2, std::ref(rbe));
+  for (int j = 0; j < kN; j++) {
+    for (Key *k : {&keys[j], &keys_n[j]}) {
+      k->cw_np1 = (uint8_t *)malloc(kLambda);
+      k->cws = (uint8_t *)malloc(kDcfCwLen * kAlphaBitlen);
+      assert(k->cw_np1 != NULL && k->cws != NULL);
+    }
+    alphas[j] = j == 0 ? kAlpha : dis(gen);
+    Bits alpha_bits = {(uint8_t *)&alphas[j], kAlphaBitlen};
+    cfs[j] = {{alpha_bits, beta}, j % 2 ? kGtAlpha : kLtAlpha};
+    memcpy(sbuf, s0ss + j * kLambda * 2, kLambda * 2);
+    dcf_gen(keys[j], cfs[j], sbuf);
+  }
+
+  memcpy(sbuf, s0ss, kN * kLambda * 2);
+  dcf_gen_n(keys_n, cfs, sbuf, kN);
+  for (int j = 0; j < kN; j++) {
+    EXPECT_EQ(memcmp(keys[j].cws, keys_n[j].cws, kDcfCwLen * kAlphaBitlen), 0) << "cws of key " << j << " differ";
+    EXPECT_EQ(memcmp(keys[j].cw_np1, keys_n[j].cw_np1, kLambda), 0) << "cw_np1 of key " << j << " differs";
+  }
+
+  // The keys still open to the comparison
+  for (int j = 0; j < kN; j++) {
+    for (uint16_t x : {alphas[j], (uint16_t)(alphas[j] - 1), (uint16_t)(alphas[j] + 1), dis(gen)}) {
+      Bits x_bits = {(uint8_t *)&x, kAlphaBitlen};
+      uint8_t ys[2][kLambda];
+      for (uint8_t b = 0; b < 2; b++) {
+        memcpy(sbuf, s0ss + (j * 2 + b) * kLambda, kLambda);
+        dcf_eval(sbuf, b, keys_n[j], x_bits);
+        memcpy(ys[b], sbuf, kLambda);
+      }
+      group_add(ys[0], ys[1]);
+      uint64_t y;
+      memcpy(&y, ys[0], 8);
+      bool on = j % 2 ? x > alphas[j] : x < alphas[j];
+      EXPECT_EQ(y, on ? kBeta : 0) << "Key " << j << " at x = " << x;
+    }
+  }
+
+  for (int j = 0; j < kN; j++) {
+    free(keys[j].cw_np1);
+    free(keys[j].cws);
+    free(keys_n[j].cw_np1);
+    free(keys_n[j].cws);
+  }
+  free(s0ss);
+  free(sbuf);
+}
+
+TEST_F(DcfTest, EvalFullDomainU64EqFullDomain) {
+  Key key;
+  key.cw_np1 = (uint8_t *)malloc(kLambda);
+  assert(key.cw_np1 != NULL);
+  key.cws = (uint8_t *)malloc(kDcfCwLen * kAlphaBitlen);
+  assert(key.cws != NULL);
+
+  // Prepare comparison function
+  uint16_t alpha_int = kAlpha;
+  uint8_t *alpha = (uint8_t *)&alpha_int;
+  Bits alpha_bits = {alpha, kAlphaBitlen};
+  uint8_t beta[kLambda];
+  memset(beta, 0, kLambda);
+  memcpy(beta, &kBeta, 8);
+  Point p = {alpha_bits, beta};
+  CmpFunc cf = {p, kLtAlpha};
+
+  // Generate DCF keys
+  uint8_t gen_sbuf[kLambda * 10];
+  memcpy(gen_sbuf, kS0s, kLambda * 2);
+  dcf_gen(key, cf, gen_sbuf);
+
+  // Small domains have no top levels
+  for (int x_bitlen : {1, 5, kAlphaBitlen}) {
+    size_t n = 1ULL << x_bitlen;
+    uint8_t *sbuf = (uint8_t *)malloc(kLambda * n);
+    assert(sbuf != NULL);
+    uint8_t *scratch = (uint8_t *)malloc(dcf_full_domain_u64_sbuf_len(x_bitlen));
+    assert(scratch != NULL);
+    uint64_t *ys = (uint64_t *)malloc(sizeof(uint64_t) * n);
+    assert(ys != NULL);
+    // The last levels of correction words are enough to compare the 2 evals on a smaller tree
+    Key key_prefix = key;
+    key_prefix.cws = key.cws + (kAlphaBitlen - x_bitlen) * kDcfCwLen;
+
+    for (uint8_t b = 0; b < 2; b++) {
+      memcpy(sbuf, kS0s + b * kLambda, kLambda);
+      dcf_eval_full_domain(sbuf, b, key_prefix, x_bitlen);
+      memcpy(scratch, kS0s + b * kLambda, kLambda);
+      dcf_eval_full_domain_u64(ys, scratch, b, key_prefix, x_bitlen);
+      for (size_t x = 0; x < n; x++) {
+        uint64_t y;
+        memcpy(&y, sbuf + x * kLambda, 8);
+        ASSERT_EQ(ys[x], y) << "Party " << (int)b << " shares differ at x = " << x << ", x_bitlen = " << x_bitlen;
+      }
+    }
+    free(sbuf);
+    free(scratch);
+    free(ys);
+  }
+
+  free(key.cw_np1);
+  free(key.cws);
+}
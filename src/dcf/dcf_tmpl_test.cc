@@ -0,0 +1,140 @@
+#include <algorithm>
+#include <random>
+#include <cstdlib>
+#include <cstring>
+#include <climits>
+#include <cassert>
+#include <gtest/gtest.h>
+#include <fss/dcf.h>
+#include <fss/dcf.hpp>
+
+extern "C" void prg_init(const uint8_t *state, int state_len);
+
+using random_bytes_engine = std::independent_bits_engine<std::default_random_engine, CHAR_BIT, uint8_t>;
+
+using Prg = fss::Aes128Mmo<kLambda, 4>;
+using Dcf16 = fss::Dcf<16, kLambda, fss::U64Group, Prg>;
+using Dcf64 = fss::Dcf<64, kLambda, fss::U64Group, Prg>;
+
+class DcfTmplTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    std::random_device rd;
+    random_bytes_engine rbe(rd());
+    uint8_t keys[4 * kLambda];
+    std::generate(std::begin(keys), std::end(keys), std::ref(rbe));
+    prg_init((uint8_t *)keys, 4 * kLambda);
+    Prg::init(keys);
+
+    std::generate(std::begin(kS0s), std::end(kS0s), std::ref(rbe));
+    gen_.seed(rd());
+  }
+
+  void TearDown() override {
+    prg_free();
+  }
+
+  static constexpr uint64_t kBeta = 604;
+
+  uint8_t kS0s[kLambda * 2];
+  std::mt19937_64 gen_;
+};
+
+TEST_F(DcfTmplTest, GenEqCGen) {
+  uint8_t *sbuf = (uint8_t *)malloc(kLambda * 10);
+  assert(sbuf != NULL);
+
+  uint8_t cws_c[Dcf64::kCwsLen], cw_np1_c[kLambda];
+  uint8_t cws_tmpl[Dcf64::kCwsLen], cw_np1_tmpl[kLambda];
+  Key key_c = {cws_c, cw_np1_c};
+  Key key_tmpl = {cws_tmpl, cw_np1_tmpl};
+
+  uint8_t beta[kLambda];
+  memset(beta, 0, kLambda);
+  memcpy(beta, &kBeta, 8);
+
+  constexpr int kNumTrials = 20;
+
+  for (int i = 0; i < kNumTrials; i++) {
+    uint64_t alpha = gen_();
+    Bits alpha_bits = {(uint8_t *)&alpha, 64};
+    Point p = {alpha_bits, beta};
+    CmpFunc cf = {p, i % 2 ? kGtAlpha : kLtAlpha};
+
+    memcpy(sbuf, kS0s, kLambda * 2);
+    dcf_gen(key_c, cf, sbuf);
+    Dcf64::gen(key_tmpl, cf, kS0s);
+
+    EXPECT_EQ(memcmp(cws_c, cws_tmpl, Dcf64::kCwsLen), 0) << "cws differ at alpha = " << alpha;
+    EXPECT_EQ(memcmp(cw_np1_c, cw_np1_tmpl, kLambda), 0) << "cw_np1 differ at alpha = " << alpha;
+  }
+
+  free(sbuf);
+}
+
+TEST_F(DcfTmplTest, EvalEqCEval) {
+  uint8_t *sbuf = (uint8_t *)malloc(kLambda * 10);
+  assert(sbuf != NULL);
+
+  uint8_t cws[Dcf64::kCwsLen], cw_np1[kLambda];
+  Key key = {cws, cw_np1};
+
+  uint8_t beta[kLambda];
+  memset(beta, 0, kLambda);
+  memcpy(beta, &kBeta, 8);
+  uint64_t alpha = gen_();
+  Bits alpha_bits = {(uint8_t *)&alpha, 64};
+  Point p = {alpha_bits, beta};
+  CmpFunc cf = {p, kLtAlpha};
+
+  memcpy(sbuf, kS0s, kLambda * 2);
+  dcf_gen(key, cf, sbuf);
+
+  constexpr int kNumTrials = 100;
+
+  for (int i = 0; i < kNumTrials; i++) {
+    uint64_t x = i == 0 ? alpha : gen_();
+    Bits x_bits = {(uint8_t *)&x, 64};
+
+    for (uint8_t b = 0; b < 2; b++) {
+      memcpy(sbuf, kS0s + b * kLambda, kLambda);
+      dcf_eval(sbuf, b, key, x_bits);
+      uint8_t y_tmpl[kLambda];
+      Dcf64::eval(y_tmpl, b, key, kS0s + b * kLambda, x);
+
+      EXPECT_EQ(memcmp(sbuf, y_tmpl, kLambda), 0) << "Party " << (int)b << " shares differ at x = " << x;
+    }
+  }
+
+  free(sbuf);
+}
+
+TEST_F(DcfTmplTest, EvalAtRandPoints) {
+  uint8_t cws[Dcf16::kCwsLen], cw_np1[kLambda];
+  Key key = {cws, cw_np1};
+
+  uint16_t alpha = 107;
+  Bits alpha_bits = {(uint8_t *)&alpha, 16};
+  uint8_t beta[kLambda];
+  memset(beta, 0, kLambda);
+  memcpy(beta, &kBeta, 8);
+  uint8_t zero[kLambda];
+  memset(zero, 0, kLambda);
+
+  for (enum Bound bound : {kLtAlpha, kGtAlpha}) {
+    Point p = {alpha_bits, beta};
+    CmpFunc cf = {p, bound};
+    Dcf16::gen(key, cf, kS0s);
+
+    for (int i = 0; i < (1 << 16); i += 97) {
+      uint16_t x = i == 0 ? alpha : (uint16_t)i;
+      uint8_t y0[kLambda], y1[kLambda];
+      Dcf16::eval(y0, 0, key, kS0s, (uint8_t *)&x);
+      Dcf16::eval(y1, 1, key, kS0s + kLambda, (uint8_t *)&x);
+      group_add(y0, y1);
+
+      bool hit = bound == kLtAlpha ? x < alpha : x > alpha;
+      EXPECT_EQ(memcmp(y0, hit ? beta : zero, kLambda), 0) << "Result differ at x = " << x;
+    }
+  }
+}
@@ -0,0 +1,85 @@
+// SPDX-License-Identifier: Apache-2.0
+
+#include "full_domain.h"
+#include <stdatomic.h>
+#include <pthread.h>
+#include <fss/tune.h>
+
+#define kFullDomainGrainBitlen 12
+// Min tasks per thread when the domain is large enough, so stealing can balance the load
+#define kFullDomainTasksPerThread 4
+
+// 0 until set, when the first use takes it from the tune file or kFullDomainGrainBitlen
+static _Atomic int gFullDomainGrainBitlen = 0;
+static pthread_once_t gFullDomainGrainOnce = PTHREAD_ONCE_INIT;
+
+static void full_domain_grain_init() {
+  int grain_bitlen = tune_get()->full_domain_grain_bitlen;
+  int unset = 0;
+  // A grain set before the first use wins
+  atomic_compare_exchange_strong(
+    &gFullDomainGrainBitlen, &unset, grain_bitlen > 0 ? grain_bitlen : kFullDomainGrainBitlen);
+}
+
+int full_domain_grain() {
+  pthread_once(&gFullDomainGrainOnce, full_domain_grain_init);
+  return atomic_load(&gFullDomainGrainBitlen);
+}
+
+void full_domain_set_grain(int grain_bitlen) {
+  atomic_store(&gFullDomainGrainBitlen, grain_bitlen > 1 ? grain_bitlen : 1);
+}
+
+int full_domain_top_depth(const FullDomainTree *tree, int x_bitlen, int threads) {
+  int grain_bitlen = full_domain_grain();
+  if (grain_bitlen < tree->block_depth) grain_bitlen = tree->block_depth;
+  int top_depth = x_bitlen > grain_bitlen ? x_bitlen - grain_bitlen : 0;
+  while (top_depth < x_bitlen - tree->block_depth &&
+    (1LL << top_depth) < (long long)threads * kFullDomainTasksPerThread) {
+    top_depth++;
+  }
+  return top_depth;
+}
+
+typedef struct {
+  const FullDomainTree *tree;
+  uint8_t *sbuf;
+  uint8_t b;
+  Key k;
+  int depth;
+  int x_bitlen;
+  // Bytes of output under 1 node at `depth`
+  size_t stride;
+} FullDomainCtx;
+
+static void full_domain_node_task(void *ctx, size_t i) {
+  FullDomainCtx *c = (FullDomainCtx *)ctx;
+  uint8_t *sbufl = c->sbuf + i * c->stride;
+  c->tree->node(c->depth, sbufl, sbufl + c->stride / 2, c->b, c->k);
+}
+
+static void full_domain_subtree_task(void *ctx, size_t i) {
+  FullDomainCtx *c = (FullDomainCtx *)ctx;
+  c->tree->subtree(c->depth, c->sbuf, i * c->stride, (i + 1) * c->stride, c->b, c->k, c->x_bitlen);
+}
+
+void full_domain_expand(
+  Pool *pool, const FullDomainTree *tree, uint8_t *sbuf, size_t len, uint8_t b, Key k, int depth) {
+  FullDomainCtx ctx = {tree, sbuf, b, k, 0, 0, len};
+  for (int i = 0; i < depth; i++) {
+    ctx.depth = i;
+    ctx.stride = len >> i;
+    pool_for(pool, 1ULL << i, 1, full_domain_node_task, &ctx);
+  }
+}
+
+void full_domain_eval(const FullDomainTree *tree, uint8_t *sbuf, uint8_t b, Key k, int x_bitlen) {
+  Pool *pool = pool_get();
+  int top_depth = full_domain_top_depth(tree, x_bitlen, pool_thread_num(pool));
+
+  size_t sbuf_len = kLambda * (1ULL << x_bitlen);
+  full_domain_expand(pool, tree, sbuf, sbuf_len, b, k, top_depth);
+
+  FullDomainCtx ctx = {tree, sbuf, b, k, top_depth, x_bitlen, sbuf_len >> top_depth};
+  pool_for(pool, 1ULL << top_depth, 1, full_domain_subtree_task, &ctx);
+}
@@ -0,0 +1,44 @@
+// SPDX-License-Identifier: Apache-2.0
+
+// Full domain eval of a GGM-style tree on the thread pool, shared by DCF, DPF and half-tree DCF.
+// The top levels are expanded breadth-first in place, 1 pool_for() per level, until there are enough subtrees of at most
+// the grain height, which then run as 1 task each.
+// `sbuf` holds lambda bytes per leaf, and the node under which a range of leaves lies is stored at the start of the range.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <fss/prelude.h>
+#include "pool.h"
+
+// Expand the node at `sbufl`, whose depth is `depth`, to its children at `sbufl` and `sbufr`
+typedef void (*FullDomainNodeFn)(int depth, uint8_t *sbufl, uint8_t *sbufr, uint8_t b, Key k);
+
+// Eval all leaves in [l, r) of `sbuf`, whose root is at `sbuf + l` and at depth `depth`
+typedef void (*FullDomainSubtreeFn)(int depth, uint8_t *sbuf, size_t l, size_t r, uint8_t b, Key k, int x_bitlen);
+
+typedef struct {
+  FullDomainNodeFn node;
+  FullDomainSubtreeFn subtree;
+  // Min height of subtrees run as 1 task, e.g., the height of the breadth-first blocks of `subtree`
+  int block_depth;
+} FullDomainTree;
+
+// Max height of subtrees run as 1 task, i.e., 2 ^ this leaves per task.
+// Set by dcf_full_domain_set_grain(), otherwise `full_domain_grain_bitlen` of tune_get() if set, otherwise 12.
+// Thread-safe.
+int full_domain_grain();
+
+void full_domain_set_grain(int grain_bitlen);
+
+// Depth of the top levels expanded breadth-first, which gives enough subtrees of at most the grain height
+int full_domain_top_depth(const FullDomainTree *tree, int x_bitlen, int threads);
+
+// Expand the top `depth` levels breadth-first in place, where the root at `sbuf` is over `len` bytes,
+// so that each node at `depth` is at `sbuf + i * (len >> depth)`
+void full_domain_expand(
+  Pool *pool, const FullDomainTree *tree, uint8_t *sbuf, size_t len, uint8_t b, Key k, int depth);
+
+// Full domain eval with the root already at `sbuf`
+void full_domain_eval(const FullDomainTree *tree, uint8_t *sbuf, uint8_t b, Key k, int x_bitlen);
@@ -32,3 +32,7 @@ FSS_CUDA_HOST_DEVICE void group_neg(uint8_t *val) {
 FSS_CUDA_HOST_DEVICE void group_zero(uint8_t *val) {
   memset(val, 0, 8);
 }
+
+const char *group_name() {
+  return "u64";
+}
@@ -0,0 +1,37 @@
+// SPDX-License-Identifier: Apache-2.0
+
+// Ring Z_2^64. Elements are stored in the low 8 bytes and the other bytes are 0.
+// Adding and negating wrap around natively, so there is no conditional reduction like u64.c.
+
+#include <fss/group.h>
+#include <string.h>
+#include "../utils.h"
+
+#if kLambda < 16
+#error "kLambda must be >= 16 for z2_64 group"
+#endif
+
+FSS_CUDA_HOST_DEVICE void group_add(uint8_t *val, const uint8_t *rhs) {
+  uint64_t val64, rhs64;
+  memcpy(&val64, val, 8);
+  memcpy(&rhs64, rhs, 8);
+  val64 += rhs64;
+  memcpy(val, &val64, 8);
+  memset(val + 8, 0, kLambda - 8);
+}
+
+FSS_CUDA_HOST_DEVICE void group_neg(uint8_t *val) {
+  uint64_t val64;
+  memcpy(&val64, val, 8);
+  val64 = -val64;
+  memcpy(val, &val64, 8);
+  memset(val + 8, 0, kLambda - 8);
+}
+
+FSS_CUDA_HOST_DEVICE void group_zero(uint8_t *val) {
+  memset(val, 0, 8);
+}
+
+const char *group_name() {
+  return "z2_64";
+}
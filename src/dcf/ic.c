@@ -0,0 +1,52 @@
+// SPDX-License-Identifier: Apache-2.0
+
+#include <fss/ic.h>
+#include <string.h>
+#include <assert.h>
+
+// Groups view lambda bytes as a little-endian int, so small ints are the same bytes in all of them
+static void group_from_bit(uint8_t *val, uint8_t bit) {
+  memset(val, 0, kLambda);
+  val[0] = bit;
+}
+
+void ic_gen_base(Key k, Bits r, uint8_t *sbuf) {
+  uint8_t beta[kLambda];
+  group_from_bit(beta, 1);
+  CmpFunc cf = {{r, beta}, kLtAlpha};
+  dcf_gen(k, cf, sbuf);
+}
+
+void ic_gen_ge(Key k, uint8_t *w, uint64_t r, uint64_t c, uint64_t n, int bitlen, uint8_t *sbuf) {
+  assert(bitlen <= 64);
+  assert(r < n && c < n);
+  // t = r + c mod n without overflowing 64 bits
+  uint8_t wrap = c >= n - r;
+  uint64_t t = wrap ? c - (n - r) : r + c;
+
+  uint8_t beta[kLambda];
+  group_from_bit(beta, 1);
+  group_neg(beta);
+  Bits alpha = {(uint8_t *)&t, bitlen};
+  CmpFunc cf = {{alpha, beta}, kLtAlpha};
+  dcf_gen(k, cf, sbuf);
+
+  group_from_bit(w, !wrap);
+}
+
+void ic_eval_base(uint8_t *sbuf, uint8_t b, Key k, Bits x) {
+  dcf_eval(sbuf, b, k, x);
+}
+
+void ic_eval_ge(uint8_t *sbuf, uint8_t b, Key k, Bits x, const uint8_t *y_base, const uint8_t *w) {
+  dcf_eval(sbuf, b, k, x);
+  group_add(sbuf, y_base);
+  group_add(sbuf, w);
+}
+
+void ic_eval_ge_frontier(
+  uint8_t *sbuf, uint8_t b, Key k, const uint8_t *frontier, int depth, Bits x, const uint8_t *y_base, const uint8_t *w) {
+  dcf_eval_frontier(sbuf, b, k, frontier, depth, x);
+  group_add(sbuf, y_base);
+  group_add(sbuf, w);
+}
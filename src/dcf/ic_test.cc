@@ -0,0 +1,107 @@
+#include <algorithm>
+#include <random>
+#include <cstdlib>
+#include <cstring>
+#include <climits>
+#include <cassert>
+#include <gtest/gtest.h>
+#include <fss/ic.h>
+
+using random_bytes_engine = std::independent_bits_engine<std::default_random_engine, CHAR_BIT, uint8_t>;
+
+class IcTest : public ::testing::TestWithParam<std::pair<uint64_t, int>> {
+ protected:
+  void SetUp() override {
+    std::random_device rd;
+    random_bytes_engine rbe(rd());
+    uint8_t keys[4 * kLambda];
+    std::generate(std::begin(keys), std::end(keys), std::ref(rbe));
+    prg_init((uint8_t *)keys, 4 * kLambda);
+    gen.seed(rd());
+
+    for (int i = 0; i < 2; i++) {
+      std::generate(s0s[i], s0s[i] + kLambda * 2, std::ref(rbe));
+    }
+    for (Key *k : {&key_base, &key_ge}) {
+      k->cw_np1 = (uint8_t *)malloc(kLambda);
+      k->cws = (uint8_t *)malloc(kDcfCwLen * 64);
+      assert(k->cw_np1 != NULL && k->cws != NULL);
+    }
+    sbuf = (uint8_t *)malloc(kLambda * 10);
+    assert(sbuf != NULL);
+  }
+
+  void TearDown() override {
+    prg_free();
+    for (Key *k : {&key_base, &key_ge}) {
+      free(k->cw_np1);
+      free(k->cws);
+    }
+    free(sbuf);
+  }
+
+  uint64_t Rand(uint64_t n) {
+    std::uniform_int_distribution<uint64_t> dis(0, n - 1);
+    return dis(gen);
+  }
+
+  // Reconstruct [x >= c] from the evals of both parties
+  uint64_t EvalGe(uint64_t x, uint64_t r, uint64_t n, int bitlen, const uint8_t *w) {
+    uint64_t xp = (uint64_t)(((unsigned __int128)x + r) % n);
+    Bits xp_bits = {(uint8_t *)&xp, bitlen};
+    uint8_t ys[2][kLambda];
+    for (uint8_t b = 0; b < 2; b++) {
+      memcpy(sbuf, s0s[0] + b * kLambda, kLambda);
+      ic_eval_base(sbuf, b, key_base, xp_bits);
+      uint8_t y_base[kLambda];
+      memcpy(y_base, sbuf, kLambda);
+
+      // Party 0 takes w and party 1 takes 0 as shares
+      uint8_t w_b[kLambda];
+      memset(w_b, 0, kLambda);
+      if (b == 0) memcpy(w_b, w, kLambda);
+      memcpy(sbuf, s0s[1] + b * kLambda, kLambda);
+      ic_eval_ge(sbuf, b, key_ge, xp_bits, y_base, w_b);
+      memcpy(ys[b], sbuf, kLambda);
+    }
+    group_add(ys[0], ys[1]);
+    uint64_t y;
+    memcpy(&y, ys[0], 8);
+    return y;
+  }
+
+  std::mt19937_64 gen;
+  uint8_t s0s[2][kLambda * 2];
+  Key key_base, key_ge;
+  uint8_t *sbuf;
+};
+
+TEST_P(IcTest, EvalGeAtRandPoints) {
+  uint64_t n = GetParam().first;
+  int bitlen = GetParam().second;
+
+  constexpr int kNumKeys = 8;
+  constexpr int kNumTrials = 50;
+
+  for (int i = 0; i < kNumKeys; i++) {
+    // Fixed mask with different thresholds, including the edges
+    uint64_t r = i == 0 ? n - 1 : Rand(n);
+    uint64_t c = i == 1 ? 0 : i == 2 ? n - 1 : Rand(n);
+    Bits r_bits = {(uint8_t *)&r, bitlen};
+    memcpy(sbuf, s0s[0], kLambda * 2);
+    ic_gen_base(key_base, r_bits, sbuf);
+    uint8_t w[kLambda];
+    memcpy(sbuf, s0s[1], kLambda * 2);
+    ic_gen_ge(key_ge, w, r, c, n, bitlen, sbuf);
+
+    for (int j = 0; j < kNumTrials; j++) {
+      uint64_t x = j == 0 ? c : j == 1 ? (c + n - 1) % n : j == 2 ? 0 : j == 3 ? n - 1 : Rand(n);
+      EXPECT_EQ(EvalGe(x, r, n, bitlen, w), (uint64_t)(x >= c)) << "Result differ at x = " << x << ", c = " << c
+                                                                << ", r = " << r;
+    }
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(Moduli, IcTest,
+  ::testing::Values(std::make_pair(18446744073709551557ull, 64), std::make_pair(65536ull, 16),
+    std::make_pair(1000ull, 10)));
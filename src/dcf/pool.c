@@ -0,0 +1,277 @@
+// SPDX-License-Identifier: Apache-2.0
+
+#include "pool.h"
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <omp.h>
+
+// A range is packed as lo << 32 | hi, so the owner and thieves can both update it with 1 CAS
+typedef struct {
+  _Alignas(64) _Atomic uint64_t range;
+} Range;
+
+struct Pool {
+  int thread_num;
+  pthread_t *threads;
+  Range *ranges;
+
+  pthread_mutex_t mu;
+  pthread_cond_t start_cv;
+  pthread_cond_t done_cv;
+  uint64_t epoch;
+  int running;
+  int stop;
+
+  // Current job
+  PoolFn fn;
+  void *ctx;
+  size_t grain;
+
+  // Held for a whole pool_for(), so jobs of concurrent callers run one at a time
+  pthread_mutex_t for_mu;
+  // The workers are stopped after the pool is replaced, so pool_for() runs on the calling thread only
+  int retired;
+  Pool *next_retired;
+};
+
+typedef struct {
+  Pool *pool;
+  int id;
+} WorkerArg;
+
+static pthread_mutex_t gPoolMu = PTHREAD_MUTEX_INITIALIZER;
+static Pool *gPool = NULL;
+// Pools replaced after a change of the thread num, kept until pool_free() for callers that still hold them
+static Pool *gRetiredPools = NULL;
+// Worker threads set it, and other threads are 0
+static _Thread_local int tWorkerId = 0;
+
+static inline uint64_t range_pack(uint32_t lo, uint32_t hi) {
+  return (uint64_t)lo << 32 | hi;
+}
+
+static inline uint32_t range_lo(uint64_t r) {
+  return r >> 32;
+}
+
+static inline uint32_t range_hi(uint64_t r) {
+  return (uint32_t)r;
+}
+
+// Take up to `grain` indices from the front of the own range
+static int range_take(Range *own, size_t grain, uint32_t *lo, uint32_t *hi) {
+  uint64_t r = atomic_load_explicit(&own->range, memory_order_relaxed);
+  while (1) {
+    uint32_t l = range_lo(r), h = range_hi(r);
+    if (l >= h) return 0;
+    uint32_t m = h - l > grain ? l + (uint32_t)grain : h;
+    if (atomic_compare_exchange_weak_explicit(
+          &own->range, &r, range_pack(m, h), memory_order_acq_rel, memory_order_relaxed)) {
+      *lo = l;
+      *hi = m;
+      return 1;
+    }
+  }
+}
+
+// Steal the back half of the victim's range, or all of it when not more than `grain`
+static int range_steal(Range *victim, size_t grain, uint32_t *lo, uint32_t *hi) {
+  uint64_t r = atomic_load_explicit(&victim->range, memory_order_relaxed);
+  while (1) {
+    uint32_t l = range_lo(r), h = range_hi(r);
+    if (l >= h) return 0;
+    uint32_t m = h - l > grain ? l + (h - l) / 2 : l;
+    if (atomic_compare_exchange_weak_explicit(
+          &victim->range, &r, range_pack(l, m), memory_order_acq_rel, memory_order_relaxed)) {
+      *lo = m;
+      *hi = h;
+      return 1;
+    }
+  }
+}
+
+static void pool_run(Pool *pool, int id) {
+  Range *own = &pool->ranges[id];
+  uint32_t lo, hi;
+  while (1) {
+    while (range_take(own, pool->grain, &lo, &hi)) {
+      for (uint32_t i = lo; i < hi; i++) {
+        pool->fn(pool->ctx, i);
+      }
+    }
+    int stolen = 0;
+    for (int k = 1; k < pool->thread_num && !stolen; k++) {
+      Range *victim = &pool->ranges[(id + k) % pool->thread_num];
+      stolen = range_steal(victim, pool->grain, &lo, &hi);
+    }
+    if (!stolen) return;
+    // Only the owner refills its empty range, and thieves never shrink an empty one
+    atomic_store_explicit(&own->range, range_pack(lo, hi), memory_order_release);
+  }
+}
+
+static void *pool_worker(void *arg) {
+  WorkerArg *wa = (WorkerArg *)arg;
+  Pool *pool = wa->pool;
+  int id = wa->id;
+  free(wa);
+  tWorkerId = id;
+
+  uint64_t seen = 0;
+  while (1) {
+    pthread_mutex_lock(&pool->mu);
+    while (pool->epoch == seen && !pool->stop) {
+      pthread_cond_wait(&pool->start_cv, &pool->mu);
+    }
+    if (pool->stop) {
+      pthread_mutex_unlock(&pool->mu);
+      return NULL;
+    }
+    seen = pool->epoch;
+    pthread_mutex_unlock(&pool->mu);
+
+    pool_run(pool, id);
+
+    pthread_mutex_lock(&pool->mu);
+    if (--pool->running == 0) pthread_cond_signal(&pool->done_cv);
+    pthread_mutex_unlock(&pool->mu);
+  }
+}
+
+static Pool *pool_new(int thread_num) {
+  Pool *pool = (Pool *)calloc(1, sizeof(Pool));
+  assert(pool != NULL);
+  pool->thread_num = thread_num;
+  pool->ranges = (Range *)aligned_alloc(64, sizeof(Range) * thread_num);
+  assert(pool->ranges != NULL);
+  for (int i = 0; i < thread_num; i++) {
+    atomic_init(&pool->ranges[i].range, 0);
+  }
+  pthread_mutex_init(&pool->mu, NULL);
+  pthread_mutex_init(&pool->for_mu, NULL);
+  pthread_cond_init(&pool->start_cv, NULL);
+  pthread_cond_init(&pool->done_cv, NULL);
+
+  // The calling thread works as worker 0
+  pool->threads = (pthread_t *)malloc(sizeof(pthread_t) * thread_num);
+  assert(pool->threads != NULL);
+  for (int i = 1; i < thread_num; i++) {
+    WorkerArg *wa = (WorkerArg *)malloc(sizeof(WorkerArg));
+    assert(wa != NULL);
+    wa->pool = pool;
+    wa->id = i;
+    int ret = pthread_create(&pool->threads[i], NULL, pool_worker, wa);
+    assert(ret == 0);
+    (void)ret;
+  }
+  return pool;
+}
+
+// Stop the workers once the running job if any is done
+static void pool_retire(Pool *pool) {
+  pthread_mutex_lock(&pool->for_mu);
+  pthread_mutex_lock(&pool->mu);
+  pool->stop = 1;
+  pthread_cond_broadcast(&pool->start_cv);
+  pthread_mutex_unlock(&pool->mu);
+  for (int i = 1; i < pool->thread_num; i++) {
+    pthread_join(pool->threads[i], NULL);
+  }
+  pool->retired = 1;
+  pthread_mutex_unlock(&pool->for_mu);
+}
+
+static void pool_delete(Pool *pool) {
+  if (!pool->retired) pool_retire(pool);
+  pthread_mutex_destroy(&pool->mu);
+  pthread_mutex_destroy(&pool->for_mu);
+  pthread_cond_destroy(&pool->start_cv);
+  pthread_cond_destroy(&pool->done_cv);
+  free(pool->threads);
+  free(pool->ranges);
+  free(pool);
+}
+
+Pool *pool_get() {
+  int thread_num = omp_get_max_threads();
+  pthread_mutex_lock(&gPoolMu);
+  if (gPool != NULL && gPool->thread_num != thread_num) {
+    pool_retire(gPool);
+    gPool->next_retired = gRetiredPools;
+    gRetiredPools = gPool;
+    gPool = NULL;
+  }
+  if (gPool == NULL) gPool = pool_new(thread_num);
+  Pool *pool = gPool;
+  pthread_mutex_unlock(&gPoolMu);
+  return pool;
+}
+
+void pool_free() {
+  pthread_mutex_lock(&gPoolMu);
+  if (gPool != NULL) pool_delete(gPool);
+  gPool = NULL;
+  while (gRetiredPools != NULL) {
+    Pool *next = gRetiredPools->next_retired;
+    pool_delete(gRetiredPools);
+    gRetiredPools = next;
+  }
+  pthread_mutex_unlock(&gPoolMu);
+}
+
+int pool_thread_num(const Pool *pool) {
+  return pool->thread_num;
+}
+
+int pool_worker_id() {
+  return tWorkerId;
+}
+
+void pool_for(Pool *pool, size_t n, size_t grain, PoolFn fn, void *ctx) {
+  assert(n <= UINT32_MAX);
+  if (n == 0) return;
+  if (grain == 0) grain = 1;
+  if (pool->thread_num == 1 || n <= grain) {
+    for (size_t i = 0; i < n; i++) {
+      fn(ctx, i);
+    }
+    return;
+  }
+
+  pthread_mutex_lock(&pool->for_mu);
+  if (pool->retired) {
+    for (size_t i = 0; i < n; i++) {
+      fn(ctx, i);
+    }
+    pthread_mutex_unlock(&pool->for_mu);
+    return;
+  }
+
+  pool->fn = fn;
+  pool->ctx = ctx;
+  pool->grain = grain;
+  // Split evenly first so stealing is only for imbalance
+  for (int i = 0; i < pool->thread_num; i++) {
+    uint32_t lo = (uint32_t)(n * i / pool->thread_num);
+    uint32_t hi = (uint32_t)(n * (i + 1) / pool->thread_num);
+    atomic_store_explicit(&pool->ranges[i].range, range_pack(lo, hi), memory_order_relaxed);
+  }
+
+  pthread_mutex_lock(&pool->mu);
+  pool->running = pool->thread_num - 1;
+  pool->epoch++;
+  pthread_cond_broadcast(&pool->start_cv);
+  pthread_mutex_unlock(&pool->mu);
+
+  pool_run(pool, 0);
+
+  pthread_mutex_lock(&pool->mu);
+  while (pool->running > 0) {
+    pthread_cond_wait(&pool->done_cv, &pool->mu);
+  }
+  pthread_mutex_unlock(&pool->mu);
+  pthread_mutex_unlock(&pool->for_mu);
+}
@@ -0,0 +1,33 @@
+// SPDX-License-Identifier: Apache-2.0
+
+// Persistent work-stealing thread pool for loops of uneven tasks.
+// Each worker owns a range of task indices and takes `grain` of them at a time from its front.
+// A worker whose range is empty steals the back half of another worker's range.
+
+#pragma once
+
+#include <stddef.h>
+
+typedef void (*PoolFn)(void *ctx, size_t i);
+
+typedef struct Pool Pool;
+
+// Get the global pool, whose thread num follows omp_get_max_threads(). Thread-safe.
+// When the thread num changes, a new pool replaces it once its running job if any is done.
+// A replaced pool stays valid for callers that still hold it, and runs their pool_for() on the calling thread only.
+Pool *pool_get();
+
+// Shut down the global pool and the replaced ones.
+// Not to call concurrently with any other pool function or while a pool returned before is still in use.
+void pool_free();
+
+// Run fn(ctx, i) for i in [0, n) on all threads of the pool, including the calling one, and wait for all.
+// Concurrent calls run one at a time.
+// Not reentrant, i.e., fn must not call pool_for().
+void pool_for(Pool *pool, size_t n, size_t grain, PoolFn fn, void *ctx);
+
+int pool_thread_num(const Pool *pool);
+
+// Id in [0, thread num) of the worker running the calling fn of pool_for(), so fn can index per-thread scratch.
+// The calling thread of pool_for() is 0.
+int pool_worker_id();
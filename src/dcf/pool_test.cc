@@ -0,0 +1,112 @@
+#include <atomic>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include <omp.h>
+#include <fss/dcf.h>
+
+extern "C" {
+#include "pool.h"
+}
+
+static void count_task(void *ctx, size_t i) {
+  std::vector<std::atomic<int>> *counts = (std::vector<std::atomic<int>> *)ctx;
+  // Uneven tasks so that stealing happens
+  volatile uint64_t x = 0;
+  for (size_t j = 0; j < (i % 7) * 1000; j++) x += j;
+  (*counts)[i]++;
+}
+
+TEST(PoolTest, RunEachIndexOnce) {
+  for (int threads : {1, 3, 4}) {
+    omp_set_num_threads(threads);
+    Pool *pool = pool_get();
+    EXPECT_EQ(pool_thread_num(pool), threads);
+    for (size_t n : {0, 1, 5, 1000}) {
+      for (size_t grain : {1, 16}) {
+        std::vector<std::atomic<int>> counts(n);
+        pool_for(pool, n, grain, count_task, &counts);
+        for (size_t i = 0; i < n; i++) {
+          EXPECT_EQ(counts[i].load(), 1) << "threads = " << threads << ", n = " << n << ", i = " << i;
+        }
+      }
+    }
+  }
+  pool_free();
+}
+
+static void worker_id_task(void *ctx, size_t i) {
+  std::vector<int> *ids = (std::vector<int> *)ctx;
+  volatile uint64_t x = 0;
+  for (size_t j = 0; j < (i % 7) * 1000; j++) x += j;
+  (*ids)[i] = pool_worker_id();
+}
+
+TEST(PoolTest, WorkerIdsInRange) {
+  for (int threads : {1, 3}) {
+    omp_set_num_threads(threads);
+    Pool *pool = pool_get();
+    std::vector<int> ids(1000, -1);
+    pool_for(pool, ids.size(), 1, worker_id_task, &ids);
+    for (size_t i = 0; i < ids.size(); i++) {
+      EXPECT_TRUE(ids[i] >= 0 && ids[i] < threads) << "threads = " << threads << ", i = " << i << ", id = " << ids[i];
+    }
+  }
+  EXPECT_EQ(pool_worker_id(), 0);
+  pool_free();
+}
+
+TEST(PoolTest, ConcurrentFullDomainEval) {
+  constexpr int kXBitlen = 14;
+  constexpr int kCallers = 2;
+  constexpr int kRepeats = 4;
+  size_t len = kLambda * (1ULL << kXBitlen);
+
+  std::mt19937_64 rng(7);
+  uint8_t prg_keys[4 * kLambda];
+  for (auto &byte : prg_keys) byte = (uint8_t)rng();
+  prg_init(prg_keys, 4 * kLambda);
+
+  // 1 key and party per caller, with the output of a call alone as reference
+  std::vector<uint8_t> key_bufs[kCallers], s0s[kCallers], refs[kCallers];
+  Key keys[kCallers];
+  for (int c = 0; c < kCallers; c++) {
+    key_bufs[c].resize(kDcfCwLen * kXBitlen + kLambda);
+    keys[c].cws = key_bufs[c].data();
+    keys[c].cw_np1 = key_bufs[c].data() + kDcfCwLen * kXBitlen;
+    uint16_t alpha = (uint16_t)(rng() % (1 << kXBitlen));
+    uint8_t beta[kLambda] = {0};
+    beta[0] = (uint8_t)(c + 1);
+    CmpFunc cf = {{{(uint8_t *)&alpha, kXBitlen}, beta}, kLtAlpha};
+    uint8_t sbuf[kLambda * 10];
+    for (int i = 0; i < kLambda * 2; i++) sbuf[i] = (uint8_t)rng();
+    s0s[c].assign(sbuf + c * kLambda, sbuf + (c + 1) * kLambda);
+    dcf_gen(keys[c], cf, sbuf);
+
+    refs[c].resize(len);
+    memcpy(refs[c].data(), s0s[c].data(), kLambda);
+    dcf_eval_full_domain(refs[c].data(), c, keys[c], kXBitlen);
+  }
+
+  // The same thread num, then different ones, so that each pool_get() replaces the pool the other caller is using
+  for (int other_threads : {3, 2}) {
+    std::vector<std::thread> callers;
+    for (int c = 0; c < kCallers; c++) {
+      callers.emplace_back([&, c] {
+        omp_set_num_threads(c == 0 ? 3 : other_threads);
+        std::vector<uint8_t> ys(len);
+        for (int r = 0; r < kRepeats; r++) {
+          memcpy(ys.data(), s0s[c].data(), kLambda);
+          dcf_eval_full_domain(ys.data(), c, keys[c], kXBitlen);
+          EXPECT_EQ(memcmp(ys.data(), refs[c].data(), len), 0)
+            << "caller = " << c << ", other threads = " << other_threads << ", repeat = " << r;
+        }
+      });
+    }
+    for (auto &caller : callers) caller.join();
+  }
+  pool_free();
+  prg_free();
+}
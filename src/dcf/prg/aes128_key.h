@@ -0,0 +1,35 @@
+// SPDX-License-Identifier: Apache-2.0
+
+// AES-128 key schedule with AES-NI, shared by the PRG kernels and the keystream of rand.c.
+// Only for x86-64 translation units that include <immintrin.h> themselves.
+
+#pragma once
+
+#include <stdint.h>
+#include <immintrin.h>
+
+__attribute__((target("aes"))) static inline __m128i aes128_expand_key_step(__m128i key, __m128i assist) {
+  assist = _mm_shuffle_epi32(assist, 0xff);
+  key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+  key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+  key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+  return _mm_xor_si128(key, assist);
+}
+
+#define AES128_EXPAND_KEY_ROUND(rk, r, rcon) \
+  rk[r] = aes128_expand_key_step(rk[r - 1], _mm_aeskeygenassist_si128(rk[r - 1], rcon))
+
+// Round keys `rk[0..11)` of the 16-byte `key`
+__attribute__((target("aes"))) static inline void aes128_expand_key(__m128i *rk, const uint8_t *key) {
+  rk[0] = _mm_loadu_si128((const __m128i *)key);
+  AES128_EXPAND_KEY_ROUND(rk, 1, 0x01);
+  AES128_EXPAND_KEY_ROUND(rk, 2, 0x02);
+  AES128_EXPAND_KEY_ROUND(rk, 3, 0x04);
+  AES128_EXPAND_KEY_ROUND(rk, 4, 0x08);
+  AES128_EXPAND_KEY_ROUND(rk, 5, 0x10);
+  AES128_EXPAND_KEY_ROUND(rk, 6, 0x20);
+  AES128_EXPAND_KEY_ROUND(rk, 7, 0x40);
+  AES128_EXPAND_KEY_ROUND(rk, 8, 0x80);
+  AES128_EXPAND_KEY_ROUND(rk, 9, 0x1b);
+  AES128_EXPAND_KEY_ROUND(rk, 10, 0x36);
+}
@@ -6,12 +6,302 @@
 
 #include <fss/prg.h>
 #include <string.h>
+#include <stdlib.h>
 #include <assert.h>
 #include <openssl/evp.h>
 #include "../utils.h"
 
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+  #define FSS_X86_DISPATCH 1
+  #include <immintrin.h>
+  #include "aes128_key.h"
+#endif
+
+// Each lambda-byte block is kLambda / 16 AES blocks, each with its own key
+#define kChunks (kLambda / 16)
+#define kAesBlocks (kBlocks * kChunks)
+
 EVP_CIPHER_CTX *gOpensslCtxs[kBlocks][kLambda / 16];
 
+// Compute AES blocks [0, n) of the output, where AES block i uses key i and the (i % kChunks)-th 16B of the seed
+typedef void (*PrgKernel)(uint8_t *out, int n, const uint8_t *seed);
+
+static void prg_openssl(uint8_t *out, int n, const uint8_t *seed) {
+  for (int i = 0; i < n; i++) {
+    int j = i % kChunks;
+    int cipher_len;
+    EVP_EncryptUpdate(gOpensslCtxs[i / kChunks][j], out + i * 16, &cipher_len, seed + j * 16, 16);
+    assert(cipher_len == 16);
+    xor_bytes(out + i * 16, seed + j * 16, 16);
+  }
+}
+
+// Expand `n` seeds, each to `nb` AES blocks, into contiguous `out`
+typedef void (*PrgNKernel)(uint8_t *out, int nb, const uint8_t *seeds, int n);
+
+static void prg_n_openssl(uint8_t *out, int nb, const uint8_t *seeds, int n) {
+  for (int s = 0; s < n; s++) {
+    prg_openssl(out + s * nb * 16, nb, seeds + s * kLambda);
+  }
+}
+
+static PrgKernel gPrgKernel = prg_openssl;
+static PrgNKernel gPrgNKernel = prg_n_openssl;
+static const char *gPrgName = "openssl";
+
+#ifdef FSS_X86_DISPATCH
+
+// Round-major so that round r of the keys of consecutive AES blocks are contiguous for VAES
+static uint8_t gRoundKeys[11][kAesBlocks][16] __attribute__((aligned(64)));
+
+__attribute__((target("aes"))) static void aes_expand_keys(const uint8_t *state) {
+  for (int i = 0; i < kAesBlocks; i++) {
+    __m128i rk[11];
+    aes128_expand_key(rk, state + i * 16);
+    for (int r = 0; r < 11; r++) {
+      _mm_store_si128((__m128i *)gRoundKeys[r][i], rk[r]);
+    }
+  }
+}
+
+__attribute__((target("aes"))) static inline void prg_aesni_block(uint8_t *out, int i, const uint8_t *seed) {
+  __m128i p = _mm_loadu_si128((const __m128i *)(seed + (i % kChunks) * 16));
+  __m128i x = _mm_xor_si128(p, _mm_load_si128((const __m128i *)gRoundKeys[0][i]));
+  for (int r = 1; r < 10; r++) {
+    x = _mm_aesenc_si128(x, _mm_load_si128((const __m128i *)gRoundKeys[r][i]));
+  }
+  x = _mm_aesenclast_si128(x, _mm_load_si128((const __m128i *)gRoundKeys[10][i]));
+  _mm_storeu_si128((__m128i *)(out + i * 16), _mm_xor_si128(x, p));
+}
+
+__attribute__((target("aes"))) static void prg_aesni(uint8_t *out, int n, const uint8_t *seed) {
+  for (int i = 0; i < n; i++) {
+    prg_aesni_block(out, i, seed);
+  }
+}
+
+__attribute__((target("aes,vaes,avx2"))) static void prg_vaes256(uint8_t *out, int n, const uint8_t *seed) {
+  int i = 0;
+  for (; i + 2 <= n; i += 2) {
+    __m256i p = _mm256_inserti128_si256(
+      _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)(seed + (i % kChunks) * 16))),
+      _mm_loadu_si128((const __m128i *)(seed + ((i + 1) % kChunks) * 16)), 1);
+    __m256i x = _mm256_xor_si256(p, _mm256_loadu_si256((const __m256i *)gRoundKeys[0][i]));
+    for (int r = 1; r < 10; r++) {
+      x = _mm256_aesenc_epi128(x, _mm256_loadu_si256((const __m256i *)gRoundKeys[r][i]));
+    }
+    x = _mm256_aesenclast_epi128(x, _mm256_loadu_si256((const __m256i *)gRoundKeys[10][i]));
+    _mm256_storeu_si256((__m256i *)(out + i * 16), _mm256_xor_si256(x, p));
+  }
+  for (; i < n; i++) {
+    prg_aesni_block(out, i, seed);
+  }
+}
+
+__attribute__((target("aes,vaes,avx512f"))) static void prg_vaes512(uint8_t *out, int n, const uint8_t *seed) {
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m512i p;
+    if (kChunks == 1) {
+      p = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i *)seed));
+    } else {
+      p = _mm512_castsi128_si512(_mm_loadu_si128((const __m128i *)(seed + (i % kChunks) * 16)));
+      p = _mm512_inserti32x4(p, _mm_loadu_si128((const __m128i *)(seed + ((i + 1) % kChunks) * 16)), 1);
+      p = _mm512_inserti32x4(p, _mm_loadu_si128((const __m128i *)(seed + ((i + 2) % kChunks) * 16)), 2);
+      p = _mm512_inserti32x4(p, _mm_loadu_si128((const __m128i *)(seed + ((i + 3) % kChunks) * 16)), 3);
+    }
+    __m512i x = _mm512_xor_si512(p, _mm512_loadu_si512(gRoundKeys[0][i]));
+    for (int r = 1; r < 10; r++) {
+      x = _mm512_aesenc_epi128(x, _mm512_loadu_si512(gRoundKeys[r][i]));
+    }
+    x = _mm512_aesenclast_epi128(x, _mm512_loadu_si512(gRoundKeys[10][i]));
+    _mm512_storeu_si512(out + i * 16, _mm512_xor_si512(x, p));
+  }
+  for (; i < n; i++) {
+    prg_aesni_block(out, i, seed);
+  }
+}
+
+// For prg_n kernels, all AES blocks of all seeds are flattened, where flat block q is block (q % nb) of seed (q / nb).
+// So blocks of different seeds fill the lanes and several vectors are kept in flight.
+
+static inline const uint8_t *prg_n_plain(const uint8_t *seeds, int nb, int q) {
+  return seeds + (q / nb) * kLambda + (q % nb % kChunks) * 16;
+}
+
+#define kPrgNAesniWays 8
+
+__attribute__((target("aes"))) static void prg_n_aesni(uint8_t *out, int nb, const uint8_t *seeds, int n) {
+  int m = nb * n;
+  int q = 0;
+  for (; q + kPrgNAesniWays <= m; q += kPrgNAesniWays) {
+    __m128i p[kPrgNAesniWays], x[kPrgNAesniWays];
+    int ki[kPrgNAesniWays];
+    for (int w = 0; w < kPrgNAesniWays; w++) {
+      ki[w] = (q + w) % nb;
+      p[w] = _mm_loadu_si128((const __m128i *)prg_n_plain(seeds, nb, q + w));
+      x[w] = _mm_xor_si128(p[w], _mm_load_si128((const __m128i *)gRoundKeys[0][ki[w]]));
+    }
+    for (int r = 1; r < 10; r++) {
+      for (int w = 0; w < kPrgNAesniWays; w++) {
+        x[w] = _mm_aesenc_si128(x[w], _mm_load_si128((const __m128i *)gRoundKeys[r][ki[w]]));
+      }
+    }
+    for (int w = 0; w < kPrgNAesniWays; w++) {
+      x[w] = _mm_aesenclast_si128(x[w], _mm_load_si128((const __m128i *)gRoundKeys[10][ki[w]]));
+      _mm_storeu_si128((__m128i *)(out + (q + w) * 16), _mm_xor_si128(x[w], p[w]));
+    }
+  }
+  for (; q < m; q++) {
+    prg_aesni_block(out + (q / nb) * nb * 16, q % nb, seeds + (q / nb) * kLambda);
+  }
+}
+
+#define kPrgNVaes256Ways 4
+
+// Round r keys of flat blocks q and q + 1
+__attribute__((target("aes,vaes,avx2"))) static inline __m256i prg_n_vaes256_key(int r, int nb, int q) {
+  if (nb == 1) return _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i *)gRoundKeys[r][0]));
+  return _mm256_loadu_si256((const __m256i *)gRoundKeys[r][q % nb]);
+}
+
+__attribute__((target("aes,vaes,avx2"))) static void prg_n_vaes256(uint8_t *out, int nb, const uint8_t *seeds, int n) {
+  // Lanes need consecutive keys
+  if (nb != 1 && nb % 2 != 0) {
+    prg_n_aesni(out, nb, seeds, n);
+    return;
+  }
+  int m = nb * n;
+  int q = 0;
+  for (; q + 2 * kPrgNVaes256Ways <= m; q += 2 * kPrgNVaes256Ways) {
+    __m256i p[kPrgNVaes256Ways], x[kPrgNVaes256Ways];
+    for (int w = 0; w < kPrgNVaes256Ways; w++) {
+      int qw = q + w * 2;
+      p[w] = _mm256_inserti128_si256(
+        _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)prg_n_plain(seeds, nb, qw))),
+        _mm_loadu_si128((const __m128i *)prg_n_plain(seeds, nb, qw + 1)), 1);
+      x[w] = _mm256_xor_si256(p[w], prg_n_vaes256_key(0, nb, qw));
+    }
+    for (int r = 1; r < 10; r++) {
+      for (int w = 0; w < kPrgNVaes256Ways; w++) {
+        x[w] = _mm256_aesenc_epi128(x[w], prg_n_vaes256_key(r, nb, q + w * 2));
+      }
+    }
+    for (int w = 0; w < kPrgNVaes256Ways; w++) {
+      x[w] = _mm256_aesenclast_epi128(x[w], prg_n_vaes256_key(10, nb, q + w * 2));
+      _mm256_storeu_si256((__m256i *)(out + (q + w * 2) * 16), _mm256_xor_si256(x[w], p[w]));
+    }
+  }
+  for (; q < m; q++) {
+    prg_aesni_block(out + (q / nb) * nb * 16, q % nb, seeds + (q / nb) * kLambda);
+  }
+}
+
+#define kPrgNVaes512Ways 4
+
+// Round r keys of flat blocks [q, q + 4)
+__attribute__((target("aes,vaes,avx512f"))) static inline __m512i prg_n_vaes512_key(int r, int nb, int q) {
+  if (nb == 1) return _mm512_broadcast_i32x4(_mm_load_si128((const __m128i *)gRoundKeys[r][0]));
+  if (nb == 2) return _mm512_broadcast_i64x4(_mm256_load_si256((const __m256i *)gRoundKeys[r][0]));
+  return _mm512_loadu_si512(gRoundKeys[r][q % nb]);
+}
+
+__attribute__((target("aes,vaes,avx512f"))) static inline __m512i prg_n_vaes512_plain(
+  const uint8_t *seeds, int nb, int q) {
+  // 4 blocks of 1 seed
+  if (kChunks == 1 && nb % 4 == 0) return _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i *)(seeds + q / nb * kLambda)));
+  __m512i p = _mm512_castsi128_si512(_mm_loadu_si128((const __m128i *)prg_n_plain(seeds, nb, q)));
+  p = _mm512_inserti32x4(p, _mm_loadu_si128((const __m128i *)prg_n_plain(seeds, nb, q + 1)), 1);
+  p = _mm512_inserti32x4(p, _mm_loadu_si128((const __m128i *)prg_n_plain(seeds, nb, q + 2)), 2);
+  return _mm512_inserti32x4(p, _mm_loadu_si128((const __m128i *)prg_n_plain(seeds, nb, q + 3)), 3);
+}
+
+__attribute__((target("aes,vaes,avx512f"))) static void prg_n_vaes512(uint8_t *out, int nb, const uint8_t *seeds, int n) {
+  // Lanes need consecutive keys
+  if (nb != 1 && nb != 2 && nb % 4 != 0) {
+    prg_n_vaes256(out, nb, seeds, n);
+    return;
+  }
+  int m = nb * n;
+  int q = 0;
+  for (; q + 4 * kPrgNVaes512Ways <= m; q += 4 * kPrgNVaes512Ways) {
+    __m512i p[kPrgNVaes512Ways], x[kPrgNVaes512Ways];
+    for (int w = 0; w < kPrgNVaes512Ways; w++) {
+      p[w] = prg_n_vaes512_plain(seeds, nb, q + w * 4);
+      x[w] = _mm512_xor_si512(p[w], prg_n_vaes512_key(0, nb, q + w * 4));
+    }
+    for (int r = 1; r < 10; r++) {
+      for (int w = 0; w < kPrgNVaes512Ways; w++) {
+        x[w] = _mm512_aesenc_epi128(x[w], prg_n_vaes512_key(r, nb, q + w * 4));
+      }
+    }
+    for (int w = 0; w < kPrgNVaes512Ways; w++) {
+      x[w] = _mm512_aesenclast_epi128(x[w], prg_n_vaes512_key(10, nb, q + w * 4));
+      _mm512_storeu_si512(out + (q + w * 4) * 16, _mm512_xor_si512(x[w], p[w]));
+    }
+  }
+  // 2 vectors in flight, e.g., the seeds of both parties of 1 level of DCF gen
+  if (q + 8 <= m) {
+    __m512i p0 = prg_n_vaes512_plain(seeds, nb, q);
+    __m512i p1 = prg_n_vaes512_plain(seeds, nb, q + 4);
+    __m512i x0 = _mm512_xor_si512(p0, prg_n_vaes512_key(0, nb, q));
+    __m512i x1 = _mm512_xor_si512(p1, prg_n_vaes512_key(0, nb, q + 4));
+    for (int r = 1; r < 10; r++) {
+      x0 = _mm512_aesenc_epi128(x0, prg_n_vaes512_key(r, nb, q));
+      x1 = _mm512_aesenc_epi128(x1, prg_n_vaes512_key(r, nb, q + 4));
+    }
+    x0 = _mm512_aesenclast_epi128(x0, prg_n_vaes512_key(10, nb, q));
+    x1 = _mm512_aesenclast_epi128(x1, prg_n_vaes512_key(10, nb, q + 4));
+    _mm512_storeu_si512(out + q * 16, _mm512_xor_si512(x0, p0));
+    _mm512_storeu_si512(out + (q + 4) * 16, _mm512_xor_si512(x1, p1));
+    q += 8;
+  }
+  for (; q + 4 <= m; q += 4) {
+    __m512i p = prg_n_vaes512_plain(seeds, nb, q);
+    __m512i x = _mm512_xor_si512(p, prg_n_vaes512_key(0, nb, q));
+    for (int r = 1; r < 10; r++) {
+      x = _mm512_aesenc_epi128(x, prg_n_vaes512_key(r, nb, q));
+    }
+    x = _mm512_aesenclast_epi128(x, prg_n_vaes512_key(10, nb, q));
+    _mm512_storeu_si512(out + q * 16, _mm512_xor_si512(x, p));
+  }
+  for (; q < m; q++) {
+    prg_aesni_block(out + (q / nb) * nb * 16, q % nb, seeds + (q / nb) * kLambda);
+  }
+}
+
+// Pick the widest kernel supported by the CPU.
+// Env FSS_PRG_KERNEL = openssl/aesni/vaes256/vaes512 caps it, e.g., for comparison.
+static void prg_select_kernel(const uint8_t *state) {
+  __builtin_cpu_init();
+  int has_aesni = __builtin_cpu_supports("aes");
+  int has_vaes256 = has_aesni && __builtin_cpu_supports("vaes") && __builtin_cpu_supports("avx2");
+  int has_vaes512 = has_vaes256 && __builtin_cpu_supports("avx512f");
+
+  const char *want = getenv("FSS_PRG_KERNEL");
+  if (want != NULL && strcmp(want, "openssl") == 0) has_aesni = 0;
+  if (want != NULL && (!has_aesni || strcmp(want, "aesni") == 0)) has_vaes256 = 0;
+  if (want != NULL && (!has_vaes256 || strcmp(want, "vaes256") == 0)) has_vaes512 = 0;
+
+  if (!has_aesni) return;
+  aes_expand_keys(state);
+  if (has_vaes512) {
+    gPrgKernel = prg_vaes512;
+    gPrgNKernel = prg_n_vaes512;
+    gPrgName = "vaes512";
+  } else if (has_vaes256) {
+    gPrgKernel = prg_vaes256;
+    gPrgNKernel = prg_n_vaes256;
+    gPrgName = "vaes256";
+  } else {
+    gPrgKernel = prg_aesni;
+    gPrgNKernel = prg_n_aesni;
+    gPrgName = "aesni";
+  }
+}
+
+#endif
+
 void prg_init(const uint8_t *state, int state_len) {
   assert(kLambda % 16 == 0);
   assert(state_len >= kBlocks * kLambda);
@@ -27,6 +317,13 @@ void prg_init(const uint8_t *state, int state_len) {
       gOpensslCtxs[i][j] = ctx;
     }
   }
+
+  gPrgKernel = prg_openssl;
+  gPrgNKernel = prg_n_openssl;
+  gPrgName = "openssl";
+#ifdef FSS_X86_DISPATCH
+  prg_select_kernel(state);
+#endif
 }
 
 void prg_free() {
@@ -37,16 +334,18 @@ void prg_free() {
   }
 }
 
+const char *prg_name() {
+  return gPrgName;
+}
+
 void prg(uint8_t *out, int out_len, const uint8_t *seed) {
   assert(out_len % kLambda == 0);
   assert(out_len <= kBlocks * kLambda);
-  int blocks = out_len / kLambda;
-  for (int i = 0; i < blocks; i++) {
-    for (int j = 0; j < kLambda / 16; j++) {
-      int cipher_len;
-      EVP_EncryptUpdate(gOpensslCtxs[i][j], out + i * kLambda + j * 16, &cipher_len, seed + j * 16, 16);
-      assert(cipher_len == 16);
-      xor_bytes(out + i * kLambda + j * 16, seed + j * 16, 16);
-    }
-  }
+  gPrgKernel(out, out_len / kLambda * kChunks, seed);
+}
+
+void prg_n(uint8_t *out, int out_len, const uint8_t *seeds, int n) {
+  assert(out_len % kLambda == 0);
+  assert(out_len <= kBlocks * kLambda);
+  gPrgNKernel(out, out_len / kLambda * kChunks, seeds, n);
 }
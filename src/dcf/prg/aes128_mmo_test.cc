@@ -0,0 +1,81 @@
+#include <algorithm>
+#include <random>
+#include <cstdlib>
+#include <cstring>
+#include <climits>
+#include <gtest/gtest.h>
+#include <fss/prg.h>
+
+using random_bytes_engine = std::independent_bits_engine<std::default_random_engine, CHAR_BIT, uint8_t>;
+
+class Aes128MmoTest : public ::testing::TestWithParam<const char *> {
+ protected:
+  void SetUp() override {
+    std::random_device rd;
+    random_bytes_engine rbe(rd());
+    std::generate(std::begin(state_), std::end(state_), std::ref(rbe));
+    std::generate(std::begin(seeds_), std::end(seeds_), std::ref(rbe));
+  }
+
+  void TearDown() override {
+    unsetenv("FSS_PRG_KERNEL");
+  }
+
+  // Expand all seeds with the kernel picked by env FSS_PRG_KERNEL = `kernel`
+  void expand(const char *kernel, int out_len, uint8_t *out) {
+    setenv("FSS_PRG_KERNEL", kernel, 1);
+    prg_init(state_, kBlocks * kLambda);
+    name_ = prg_name();
+    for (int i = 0; i < kNumSeeds; i++) {
+      prg(out + i * out_len, out_len, seeds_ + i * kLambda);
+    }
+    prg_free();
+  }
+
+  // Same as expand() but with prg_n() on the first `n` seeds
+  void expand_n(const char *kernel, int out_len, uint8_t *out, int n) {
+    setenv("FSS_PRG_KERNEL", kernel, 1);
+    prg_init(state_, kBlocks * kLambda);
+    name_ = prg_name();
+    prg_n(out, out_len, seeds_, n);
+    prg_free();
+  }
+
+  static constexpr int kNumSeeds = 64;
+
+  uint8_t state_[kBlocks * kLambda];
+  uint8_t seeds_[kNumSeeds * kLambda];
+  const char *name_;
+};
+
+TEST_P(Aes128MmoTest, KernelEqOpenssl) {
+  const char *kernel = GetParam();
+  for (int blocks = 1; blocks <= kBlocks; blocks++) {
+    int out_len = blocks * kLambda;
+    uint8_t want[kNumSeeds * kBlocks * kLambda];
+    uint8_t got[kNumSeeds * kBlocks * kLambda];
+    expand("openssl", out_len, want);
+    ASSERT_STREQ(name_, "openssl");
+    expand(kernel, out_len, got);
+    if (strcmp(name_, kernel) != 0) GTEST_SKIP() << kernel << " is not supported by the CPU";
+    EXPECT_EQ(memcmp(want, got, kNumSeeds * out_len), 0) << "Output differ with " << blocks << " blocks";
+  }
+}
+
+TEST_P(Aes128MmoTest, PrgNEqPrg) {
+  const char *kernel = GetParam();
+  for (int blocks = 1; blocks <= kBlocks; blocks++) {
+    int out_len = blocks * kLambda;
+    uint8_t want[kNumSeeds * kBlocks * kLambda];
+    expand("openssl", out_len, want);
+    // Odd n to cover tails
+    for (int n : {1, 3, 8, 13, kNumSeeds}) {
+      uint8_t got[kNumSeeds * kBlocks * kLambda];
+      expand_n(kernel, out_len, got, n);
+      if (strcmp(name_, kernel) != 0) GTEST_SKIP() << kernel << " is not supported by the CPU";
+      EXPECT_EQ(memcmp(want, got, n * out_len), 0) << "Output differ with " << blocks << " blocks and n = " << n;
+    }
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(Kernels, Aes128MmoTest, ::testing::Values("openssl", "aesni", "vaes256", "vaes512"));
@@ -0,0 +1,142 @@
+// SPDX-License-Identifier: Apache-2.0
+
+#include <fss/tune.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <omp.h>
+#include <fss/dcf.h>
+
+// Max len of a line of the file
+#define kTuneLineLen 256
+
+typedef struct {
+  const char *key;
+  size_t offset;
+  // Valid values are in [min, max]
+  int min;
+  int max;
+} TuneField;
+
+static const TuneField kTuneFields[] = {
+  {"thread_num", offsetof(TuneConfig, thread_num), 0, 1 << 16},
+  {"chunk", offsetof(TuneConfig, chunk), 0, 1 << 30},
+  {"eval_batch", offsetof(TuneConfig, eval_batch), 1, kTuneMaxEvalBatch},
+  {"full_domain_grain_bitlen", offsetof(TuneConfig, full_domain_grain_bitlen), 0, 63},
+  {"frontier_depth", offsetof(TuneConfig, frontier_depth), 0, 64},
+};
+
+#define kTuneFieldNum ((int)(sizeof(kTuneFields) / sizeof(kTuneFields[0])))
+
+static TuneConfig gTune;
+static int gTuneFromFile = 0;
+static pthread_once_t gTuneOnce = PTHREAD_ONCE_INIT;
+
+void tune_default(TuneConfig *cfg) {
+  cfg->thread_num = 0;
+  cfg->chunk = 0;
+  cfg->eval_batch = 1;
+  cfg->full_domain_grain_bitlen = 0;
+  cfg->frontier_depth = 0;
+}
+
+int tune_load(TuneConfig *cfg, const char *path) {
+  FILE *f = fopen(path, "r");
+  if (f == NULL) return -1;
+  char line[kTuneLineLen];
+  int ret = 0;
+  while (ret == 0 && fgets(line, sizeof(line), f) != NULL) {
+    char *hash = strchr(line, '#');
+    if (hash != NULL) *hash = '\0';
+    char key[64], rest[2];
+    int value;
+    // Skip blank lines, and reject trailing garbage after the value
+    if (sscanf(line, " %1s", rest) != 1) continue;
+    if (sscanf(line, " %63[a-z_] = %d %1s", key, &value, rest) != 2) {
+      ret = -1;
+      break;
+    }
+    ret = -1;
+    for (int i = 0; i < kTuneFieldNum; i++) {
+      const TuneField *field = &kTuneFields[i];
+      if (strcmp(key, field->key) != 0) continue;
+      if (value >= field->min && value <= field->max) {
+        *(int *)((char *)cfg + field->offset) = value;
+        ret = 0;
+      }
+      break;
+    }
+  }
+  fclose(f);
+  return ret;
+}
+
+int tune_save(const TuneConfig *cfg, const char *path, const char *comment) {
+  FILE *f = fopen(path, "w");
+  if (f == NULL) return -1;
+  // Prefix each line of the comment
+  const char *p = comment;
+  while (p != NULL && *p != '\0') {
+    const char *eol = strchr(p, '\n');
+    int len = eol != NULL ? (int)(eol - p) : (int)strlen(p);
+    fprintf(f, "# %.*s\n", len, p);
+    p = eol != NULL ? eol + 1 : NULL;
+  }
+  for (int i = 0; i < kTuneFieldNum; i++) {
+    const TuneField *field = &kTuneFields[i];
+    fprintf(f, "%s = %d\n", field->key, *(const int *)((const char *)cfg + field->offset));
+  }
+  return fclose(f) == 0 ? 0 : -1;
+}
+
+static void tune_load_env() {
+  tune_default(&gTune);
+  const char *path = getenv(kTuneFileEnv);
+  if (path == NULL || path[0] == '\0') return;
+  TuneConfig cfg;
+  tune_default(&cfg);
+  if (tune_load(&cfg, path) != 0) {
+    fprintf(stderr, "Tune file %s unreadable or invalid, using defaults\n", path);
+    return;
+  }
+  gTune = cfg;
+  gTuneFromFile = 1;
+}
+
+const TuneConfig *tune_get() {
+  pthread_once(&gTuneOnce, tune_load_env);
+  return &gTune;
+}
+
+void tune_set_schedule(const TuneConfig *cfg, int points_per_iter) {
+  if (cfg->chunk > 0) {
+    int chunk = cfg->chunk / points_per_iter;
+    omp_set_schedule(omp_sched_dynamic, chunk > 0 ? chunk : 1);
+  } else {
+    omp_set_schedule(omp_sched_static, 0);
+  }
+}
+
+void tune_apply(const TuneConfig *cfg) {
+  if (cfg->thread_num > 0) omp_set_num_threads(cfg->thread_num);
+  tune_set_schedule(cfg, 1);
+  if (cfg->full_domain_grain_bitlen > 0) dcf_full_domain_set_grain(cfg->full_domain_grain_bitlen);
+}
+
+int tune_from_file() {
+  tune_get();
+  return gTuneFromFile;
+}
+
+int tune_init() {
+  tune_apply(tune_get());
+  return tune_from_file();
+}
+
+// Apply the file of $FSS_TUNE_FILE when the program starts, so programs on the library need not call tune_init().
+// This file is linked into every program that evals, as the full domain scheduler takes its default grain from here.
+__attribute__((constructor)) static void tune_init_at_load() {
+  if (tune_from_file()) tune_apply(tune_get());
+}
@@ -0,0 +1,89 @@
+#include <stdio.h>
+#include <string>
+#include <cstdlib>
+#include <gtest/gtest.h>
+#include <omp.h>
+#include <fss/tune.h>
+
+extern "C" {
+#include "full_domain.h"
+}
+
+static std::string temp_path(const char *name) {
+  return std::string(testing::TempDir()) + name;
+}
+
+static void write_file(const std::string &path, const char *text) {
+  FILE *f = fopen(path.c_str(), "w");
+  ASSERT_NE(f, nullptr);
+  fputs(text, f);
+  fclose(f);
+}
+
+TEST(TuneTest, SaveLoad) {
+  TuneConfig cfg;
+  tune_default(&cfg);
+  cfg.thread_num = 6;
+  cfg.chunk = 512;
+  cfg.eval_batch = 32;
+  cfg.full_domain_grain_bitlen = 10;
+  cfg.frontier_depth = 8;
+  std::string path = temp_path("tune_save_load.conf");
+  ASSERT_EQ(tune_save(&cfg, path.c_str(), "Line 1\nLine 2"), 0);
+
+  TuneConfig loaded;
+  tune_default(&loaded);
+  ASSERT_EQ(tune_load(&loaded, path.c_str()), 0);
+  EXPECT_EQ(loaded.thread_num, 6);
+  EXPECT_EQ(loaded.chunk, 512);
+  EXPECT_EQ(loaded.eval_batch, 32);
+  EXPECT_EQ(loaded.full_domain_grain_bitlen, 10);
+  EXPECT_EQ(loaded.frontier_depth, 8);
+  remove(path.c_str());
+}
+
+TEST(TuneTest, LoadKeepsAbsentKeys) {
+  std::string path = temp_path("tune_partial.conf");
+  write_file(path, "# Comment\n\n  chunk = 64  # Trailing comment\n");
+  TuneConfig cfg, def;
+  tune_default(&cfg);
+  tune_default(&def);
+  ASSERT_EQ(tune_load(&cfg, path.c_str()), 0);
+  EXPECT_EQ(cfg.chunk, 64);
+  EXPECT_EQ(cfg.thread_num, def.thread_num);
+  EXPECT_EQ(cfg.eval_batch, def.eval_batch);
+  EXPECT_EQ(cfg.frontier_depth, def.frontier_depth);
+  remove(path.c_str());
+}
+
+TEST(TuneTest, LoadRejectsBrokenFiles) {
+  TuneConfig cfg;
+  tune_default(&cfg);
+  EXPECT_EQ(tune_load(&cfg, temp_path("tune_missing.conf").c_str()), -1);
+
+  std::string path = temp_path("tune_broken.conf");
+  for (const char *text : {"unknown_key = 1\n", "eval_batch = 0\n", "chunk = -1\n", "chunk = 64 x\n", "chunk\n"}) {
+    write_file(path, text);
+    EXPECT_EQ(tune_load(&cfg, path.c_str()), -1) << text;
+  }
+  remove(path.c_str());
+}
+
+// Registered by CMake once more with $FSS_TUNE_FILE set, and skipped otherwise
+TEST(TuneTest, AppliedAtLoad) {
+  const char *path = getenv(kTuneFileEnv);
+  if (path == NULL) GTEST_SKIP() << kTuneFileEnv << " not set";
+  TuneConfig cfg;
+  tune_default(&cfg);
+  ASSERT_EQ(tune_load(&cfg, path), 0);
+
+  // No tune_init() call
+  EXPECT_EQ(tune_from_file(), 1);
+  EXPECT_EQ(tune_get()->chunk, cfg.chunk);
+  EXPECT_EQ(omp_get_max_threads(), cfg.thread_num);
+  omp_sched_t kind;
+  int chunk;
+  omp_get_schedule(&kind, &chunk);
+  EXPECT_EQ(chunk, cfg.chunk);
+  EXPECT_EQ(full_domain_grain(), cfg.full_domain_grain_bitlen);
+}
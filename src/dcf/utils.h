@@ -23,3 +23,13 @@ FSS_CUDA_HOST_DEVICE static inline void xor_bytes(uint8_t *val, const uint8_t *r
     val[i] ^= rhs[i];
   }
 }
+
+// Load the 1bit t from MSB, so we can truncate during adding
+FSS_CUDA_HOST_DEVICE static inline void load_st(uint8_t *s, uint8_t *t) {
+  *t = get_bit_lsb(s, kLambda * 8 - 1);
+  set_bit_lsb(s, kLambda * 8 - 1, 0);
+}
+
+static inline void set_st(uint8_t *s, uint8_t t) {
+  set_bit_lsb(s, kLambda * 8 - 1, t);
+}
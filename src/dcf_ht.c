@@ -0,0 +1,135 @@
+// For real-time extensions
+#define _POSIX_C_SOURCE 199309L
+
+// Half-tree DCF vs DCF across bitlens: gen and eval time, AES blocks per eval, and key len.
+// Usage: dcf_ht_benchmark
+
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <fss/dcf.h>
+#include <fss/dcf_ht.h>
+#include <omp.h>
+#include "workspace.h"
+
+#define kSeed 114514
+#define kMinBitlen 16
+#define kMaxBitlen 64
+#define kBitlenStep 16
+#define kN 100000
+#define kGenIterNum 10000
+
+static inline double get_time() {
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1.0e-9;
+}
+
+static void gen_rand_bytes(uint8_t *buf, size_t len) {
+  for (size_t i = 0; i < len; i++) {
+    buf[i] = rand() & 0xFF;
+  }
+}
+
+int main() {
+  srand(kSeed);
+  int thread_num = omp_get_max_threads();
+  printf("OpenMP thread num: %d\n", thread_num);
+  printf("Lambda (B): %d\n", kLambda);
+
+  // Init PRG
+  uint8_t *keys = (uint8_t *)malloc(4 * kLambda);
+  assert(keys != NULL);
+  gen_rand_bytes(keys, 4 * kLambda);
+  prg_init(keys, 4 * kLambda);
+  free(keys);
+  printf("PRG kernel: %s\n", prg_name());
+  printf("Group: %s\n", group_name());
+
+  uint8_t *s0s = (uint8_t *)malloc(kLambda * 2);
+  assert(s0s != NULL);
+  gen_rand_bytes(s0s, kLambda * 2);
+  uint8_t *beta = (uint8_t *)malloc(kLambda);
+  assert(beta != NULL);
+  memset(beta, 0, kLambda);
+  gen_rand_bytes(beta, 8);
+
+  uint64_t *xs = (uint64_t *)malloc(kN * sizeof(uint64_t));
+  assert(xs != NULL);
+  gen_rand_bytes((uint8_t *)xs, kN * sizeof(uint64_t));
+
+  Key k, kh;
+  k.cw_np1 = (uint8_t *)malloc(kLambda);
+  assert(k.cw_np1 != NULL);
+  k.cws = (uint8_t *)malloc(kDcfCwLen * kMaxBitlen);
+  assert(k.cws != NULL);
+  kh.cw_np1 = (uint8_t *)malloc(kLambda);
+  assert(kh.cw_np1 != NULL);
+  kh.cws = (uint8_t *)malloc(kDcfHtCwLen * kMaxBitlen);
+  assert(kh.cws != NULL);
+
+  uint8_t *sbuf = (uint8_t *)malloc(kLambda * 10);
+  assert(sbuf != NULL);
+  Workspace ws;
+  ws_open(&ws, kLambda * 6);
+
+  // An eval expands 4 blocks per level for DCF, and 2 blocks per level plus 2 for the leaf for half-tree DCF
+  printf("bitlen,kind,key_len,aes_blocks,gen_us,eval_us\n");
+  for (int bitlen = kMinBitlen; bitlen <= kMaxBitlen; bitlen += kBitlenStep) {
+    uint8_t alpha[8];
+    gen_rand_bytes(alpha, sizeof(alpha));
+    Bits alpha_bits = {alpha, bitlen};
+    CmpFunc cf = {{alpha_bits, beta}, kLtAlpha};
+
+    double t = get_time();
+    for (int i = 0; i < kGenIterNum; i++) {
+      memcpy(sbuf, s0s, kLambda * 2);
+      dcf_gen(k, cf, sbuf);
+    }
+    double t_gen = (get_time() - t) / kGenIterNum;
+
+    t = get_time();
+#pragma omp parallel for
+    for (int i = 0; i < kN; i++) {
+      uint8_t *sbuf = ws_get(&ws, omp_get_thread_num());
+      memcpy(sbuf, s0s, kLambda);
+      Bits x_bits = {(uint8_t *)&xs[i], bitlen};
+      dcf_eval(sbuf, 0, k, x_bits);
+    }
+    double t_eval = (get_time() - t) / kN;
+    printf("%d,dcf,%d,%d,%lf,%lf\n", bitlen, kDcfCwLen * bitlen + kLambda, 4 * bitlen, t_gen * 1e6, t_eval * 1e6);
+
+    t = get_time();
+    for (int i = 0; i < kGenIterNum; i++) {
+      memcpy(sbuf, s0s, kLambda * 2);
+      dcf_ht_gen(kh, cf, sbuf);
+    }
+    t_gen = (get_time() - t) / kGenIterNum;
+
+    t = get_time();
+#pragma omp parallel for
+    for (int i = 0; i < kN; i++) {
+      uint8_t *sbuf = ws_get(&ws, omp_get_thread_num());
+      memcpy(sbuf, s0s, kLambda);
+      Bits x_bits = {(uint8_t *)&xs[i], bitlen};
+      dcf_ht_eval(sbuf, 0, kh, x_bits);
+    }
+    t_eval = (get_time() - t) / kN;
+    printf("%d,dcf_ht,%d,%d,%lf,%lf\n", bitlen, kDcfHtCwLen * bitlen + kLambda, 2 * (bitlen + 1), t_gen * 1e6,
+      t_eval * 1e6);
+  }
+
+  prg_free();
+  free(s0s);
+  free(beta);
+  free(xs);
+  free(sbuf);
+  ws_close(&ws);
+  free(k.cw_np1);
+  free(k.cws);
+  free(kh.cw_np1);
+  free(kh.cws);
+  return 0;
+}
@@ -0,0 +1,150 @@
+// SPDX-License-Identifier: Apache-2.0
+
+// Compare the compile-time specialised DCF in fss/dcf.hpp with the C API on the 64-bit comparison path of cmp.c
+
+#include <cstring>
+#include <cstdio>
+#include <ctime>
+#include <cstdlib>
+#include <cassert>
+#include <fss/dcf.h>
+#include <fss/dcf.hpp>
+#include <omp.h>
+
+#define kSeed 114514
+#define kAlphaBitlen 64
+#define kN 1048576
+
+using Prg = fss::Aes128Mmo<kLambda, kBlocks>;
+using Dcf = fss::Dcf<kAlphaBitlen, kLambda, fss::U64Group, Prg>;
+
+static inline double get_time() {
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1.0e-9;
+}
+
+static void gen_rand_bytes(uint8_t *buf, size_t len) {
+  for (size_t i = 0; i < len; i++) {
+    buf[i] = rand() & 0xFF;
+  }
+}
+
+int main() {
+  srand(kSeed);
+  printf("DCF C vs C++ template Benchmark\n");
+  printf("OpenMP thread num: %d\n", omp_get_max_threads());
+  printf("Alpha bitlen: %d\n", kAlphaBitlen);
+  printf("Lambda (B): %d\n", kLambda);
+  printf("Key len (B): %zu\n", Dcf::kKeyLen);
+
+  // Init both PRGs with the same state so keys are interchangeable
+  uint8_t *keys = (uint8_t *)malloc(kBlocks * kLambda);
+  assert(keys != NULL);
+  gen_rand_bytes(keys, kBlocks * kLambda);
+  prg_init(keys, kBlocks * kLambda);
+  Prg::init(keys);
+  free(keys);
+  printf("PRG kernel: %s\n", prg_name());
+
+  // 2 keys like key_l and key_r in cmp.c
+  uint8_t s0s[2][2 * kLambda];
+  gen_rand_bytes(s0s[0], 2 * kLambda);
+  gen_rand_bytes(s0s[1], 2 * kLambda);
+  Key ks[2];
+  for (int j = 0; j < 2; j++) {
+    ks[j].cws = (uint8_t *)malloc(Dcf::kCwsLen);
+    ks[j].cw_np1 = (uint8_t *)malloc(kLambda);
+    assert(ks[j].cws != NULL && ks[j].cw_np1 != NULL);
+  }
+  uint64_t alphas[2];
+  gen_rand_bytes((uint8_t *)alphas, sizeof(alphas));
+  uint8_t beta[kLambda];
+  memset(beta, 0, kLambda);
+  beta[0] = 1;
+
+  uint8_t *sbuf = (uint8_t *)malloc(kLambda * 10);
+  assert(sbuf != NULL);
+
+  // Gen
+  int gen_iter_num = 100000;
+  double t = get_time();
+  for (int i = 0; i < gen_iter_num; i++) {
+    Bits alpha_bits = {(uint8_t *)&alphas[0], kAlphaBitlen};
+    CmpFunc cf = {{alpha_bits, beta}, kLtAlpha};
+    memcpy(sbuf, s0s[0], 2 * kLambda);
+    dcf_gen(ks[0], cf, sbuf);
+  }
+  double t_gen_c = (get_time() - t) / gen_iter_num;
+  t = get_time();
+  for (int i = 0; i < gen_iter_num; i++) {
+    Bits alpha_bits = {(uint8_t *)&alphas[0], kAlphaBitlen};
+    CmpFunc cf = {{alpha_bits, beta}, kLtAlpha};
+    Dcf::gen(ks[0], cf, s0s[0]);
+  }
+  double t_gen_tmpl = (get_time() - t) / gen_iter_num;
+  printf("dcf_gen C (us): %lf\n", t_gen_c * 1e6);
+  printf("dcf_gen template (us): %lf (%.2lfx)\n", t_gen_tmpl * 1e6, t_gen_c / t_gen_tmpl);
+
+  for (int j = 0; j < 2; j++) {
+    Bits alpha_bits = {(uint8_t *)&alphas[j], kAlphaBitlen};
+    CmpFunc cf = {{alpha_bits, beta}, kLtAlpha};
+    Dcf::gen(ks[j], cf, s0s[j]);
+  }
+  free(sbuf);
+
+  uint64_t *xs = (uint64_t *)malloc(kN * sizeof(uint64_t));
+  assert(xs != NULL);
+  gen_rand_bytes((uint8_t *)xs, kN * sizeof(uint64_t));
+
+  int thread_num = omp_get_max_threads();
+  uint8_t *sbufs = (uint8_t *)malloc(kLambda * 6 * thread_num);
+  assert(sbufs != NULL);
+
+  // Eval of both keys per input like Cmp.Eval, C API
+  uint64_t acc_c = 0;
+  t = get_time();
+#pragma omp parallel for reduction(^ : acc_c)
+  for (int i = 0; i < kN; i++) {
+    uint8_t *sbuf = sbufs + omp_get_thread_num() * kLambda * 6;
+    Bits x_bits = {(uint8_t *)&xs[i], kAlphaBitlen};
+    for (int j = 0; j < 2; j++) {
+      memcpy(sbuf, s0s[j], kLambda);
+      dcf_eval(sbuf, 0, ks[j], x_bits);
+      uint64_t y;
+      memcpy(&y, sbuf, 8);
+      acc_c ^= y;
+    }
+  }
+  double t_eval_c = get_time() - t;
+
+  // Same with the template
+  uint64_t acc_tmpl = 0;
+  t = get_time();
+#pragma omp parallel for reduction(^ : acc_tmpl)
+  for (int i = 0; i < kN; i++) {
+    for (int j = 0; j < 2; j++) {
+      uint8_t out[kLambda];
+      Dcf::eval(out, 0, ks[j], s0s[j], xs[i]);
+      uint64_t y;
+      memcpy(&y, out, 8);
+      acc_tmpl ^= y;
+    }
+  }
+  double t_eval_tmpl = get_time() - t;
+
+  printf("Cmp.Eval C (ms/all): %lf\n", t_eval_c * 1e3);
+  printf("Cmp.Eval template (ms/all): %lf (%.2lfx)\n", t_eval_tmpl * 1e3, t_eval_c / t_eval_tmpl);
+  printf("dcf_eval C (us): %lf\n", t_eval_c / (2.0 * kN) * 1e6);
+  printf("dcf_eval template (us): %lf\n", t_eval_tmpl / (2.0 * kN) * 1e6);
+  if (acc_c != acc_tmpl) printf("Outputs of C and template differ\n");
+
+  free(sbufs);
+  free(xs);
+  for (int j = 0; j < 2; j++) {
+    free(ks[j].cws);
+    free(ks[j].cw_np1);
+  }
+  prg_free();
+  return 0;
+}
@@ -10,6 +10,9 @@
 #include <assert.h>
 #include <stdint.h>
 #include <omp.h>
+#include "preproc.h"
+#include "rand.h"
+#include "workspace.h"
 
 #define kPrime 18446744073709551557ull
 #define kDim 1024
@@ -23,20 +26,14 @@ static inline double get_time() {
     return ts.tv_sec + ts.tv_nsec * 1.0e-9;
 }
 
+static Rng gRng;
+
 static void gen_rand_bytes(uint8_t *buf, size_t len) {
-    // Simple rand for benchmark setup
-    for (size_t i = 0; i < len; i++) {
-        buf[i] = rand() & 0xFF;
-    }
+    rng_fill_bytes(&gRng, buf, len);
 }
 
 static uint64_t get_rand_field() {
-    uint64_t r;
-    uint8_t buf[8];
-    gen_rand_bytes(buf, 8);
-    memcpy(&r, buf, 8);
-    if (r >= kPrime) return r - kPrime;
-    return r;
+    return rng_field(&gRng);
 }
 
 static uint64_t add_mod_p(uint64_t a, uint64_t b) {
@@ -59,10 +56,11 @@ uint64_t vec_b[kDim];
 uint64_t share_a_0[kDim], share_a_1[kDim];
 uint64_t share_b_0[kDim], share_b_1[kDim];
 
-// Triples
-uint64_t share_x_0[kDim], share_x_1[kDim];
-uint64_t share_y_0[kDim], share_y_1[kDim];
-uint64_t share_z_0[kDim], share_z_1[kDim];
+// Triples. Party 0 only keeps a seed and expands its shares on demand. See preproc.h.
+uint8_t seed_0[kPreprocSeedLen];
+uint64_t share_x_1[kDim];
+uint64_t share_y_1[kDim];
+uint64_t share_z_1[kDim];
 
 // Open values (simulated communication)
 uint64_t d_open[kDim];
@@ -73,9 +71,6 @@ void setup_data() {
         // True values
         uint64_t ak = get_rand_field();
         uint64_t bk = get_rand_field();
-        uint64_t xk = get_rand_field();
-        uint64_t yk = get_rand_field();
-        uint64_t zk = mul_mod_p(xk, yk);
 
         // Shares for a
         share_a_0[k] = get_rand_field();
@@ -84,28 +79,41 @@ void setup_data() {
         // Shares for b
         share_b_0[k] = get_rand_field();
         share_b_1[k] = sub_mod_p(bk, share_b_0[k]);
+    }
 
-        // Shares for x
-        share_x_0[k] = get_rand_field();
-        share_x_1[k] = sub_mod_p(xk, share_x_0[k]);
-
-        // Shares for y
-        share_y_0[k] = get_rand_field();
-        share_y_1[k] = sub_mod_p(yk, share_y_0[k]);
+    uint8_t seed_xy[kPreprocSeedLen];
+    gen_rand_bytes(seed_0, kPreprocSeedLen);
+    gen_rand_bytes(seed_xy, kPreprocSeedLen);
+    preproc_deal(share_x_1, share_y_1, share_z_1, seed_0, seed_xy, 0, kDim);
 
-        // Shares for z
-        share_z_0[k] = get_rand_field();
-        share_z_1[k] = sub_mod_p(zk, share_z_0[k]);
+    // Check the triples
+    uint64_t x0[kDim], y0[kDim], z0[kDim];
+    preproc_expand(x0, y0, z0, seed_0, 0, kDim);
+    for (int k = 0; k < kDim; ++k) {
+        uint64_t xk = add_mod_p(x0[k], share_x_1[k]);
+        uint64_t yk = add_mod_p(y0[k], share_y_1[k]);
+        assert(mul_mod_p(xk, yk) == add_mod_p(z0[k], share_z_1[k]));
+        (void)xk; (void)yk;
     }
 }
 
 int main() {
-    srand(time(NULL));
+    // Seeded from the OS
+    rng_init(&gRng, NULL, 0);
     setup_data();
 
     printf("Benchmarking Dot Product (Server 0 view)...\n");
     printf("Dimension: %d\n", kDim);
     printf("Iterations: %d\n", kN);
+    printf("Preproc kernel: %s\n", preproc_kernel_name());
+
+    // Preprocessing stored per doc: 6 arrays when both parties get explicit shares
+    printf("Preproc per doc (B): party 0 %d, party 1 %d, explicit %d\n", kPreprocSeedLen,
+           (int)(3 * kDim * sizeof(uint64_t)), (int)(6 * kDim * sizeof(uint64_t)));
+
+    // | x_0 | y_0 | z_0 | local_d | local_e | of each thread
+    Workspace ws;
+    ws_open(&ws, kDim * 5 * sizeof(uint64_t));
 
     double start = get_time();
 
@@ -119,8 +127,14 @@ int main() {
         // We assume batched for the sake of calculation of d_open later,
         // but timing includes the arithmetic.
 
-        uint64_t local_d[kDim];
-        uint64_t local_e[kDim];
+        uint64_t *share_x_0 = (uint64_t *)ws_get(&ws, omp_get_thread_num());
+        uint64_t *share_y_0 = share_x_0 + kDim;
+        uint64_t *share_z_0 = share_x_0 + kDim * 2;
+        uint64_t *local_d = share_x_0 + kDim * 3;
+        uint64_t *local_e = share_x_0 + kDim * 4;
+
+        // Every doc uses the same triples here, so every doc expands from offset 0. Doc `iter` would start at iter * kDim.
+        preproc_expand(share_x_0, share_y_0, share_z_0, seed_0, 0, kDim);
 
         for (int k = 0; k < kDim; ++k) {
             local_d[k] = sub_mod_p(share_a_0[k], share_x_0[k]);
@@ -181,5 +195,7 @@ int main() {
 
     printf("Dot Product (dim=%d): %lf ms\n", kDim, total_time * 1e3);
 
+    ws_close(&ws);
+
     return 0;
 }
@@ -0,0 +1,205 @@
+// For real-time extensions
+#define _POSIX_C_SOURCE 199309L
+
+// DPF vs equality emulated by 2 DCFs, i.e., [x < alpha + 1] - [x < alpha]
+
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <fss/dpf.h>
+#include <fss/dcf.h>
+#include <omp.h>
+#include "perf.h"
+#include "workspace.h"
+
+#define kSeed 114514
+#define kAlphaBitlen 64
+#define kN 100000
+#define kFullDomainBitlen 20
+#define kFullDomainIterNum 10
+
+static inline double get_time() {
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1.0e-9;
+}
+
+static void gen_rand_bytes(uint8_t *buf, size_t len) {
+  for (size_t i = 0; i < len; i++) {
+    buf[i] = rand() & 0xFF;
+  }
+}
+
+static Key key_alloc(int cw_len, int bitlen) {
+  Key k;
+  k.cw_np1 = (uint8_t *)malloc(kLambda);
+  assert(k.cw_np1 != NULL);
+  k.cws = (uint8_t *)malloc(cw_len * bitlen);
+  assert(k.cws != NULL);
+  return k;
+}
+
+static void key_free(Key k) {
+  free(k.cw_np1);
+  free(k.cws);
+}
+
+int main() {
+  srand(kSeed);
+  double t;
+  printf("OpenMP thread num: %d\n", omp_get_max_threads());
+  printf("Alpha bitlen: %d\n", kAlphaBitlen);
+  printf("Lambda (B): %d\n", kLambda);
+
+  // Init PRG
+  uint8_t *keys = (uint8_t *)malloc(4 * kLambda);
+  assert(keys != NULL);
+  gen_rand_bytes(keys, 4 * kLambda);
+  prg_init(keys, 4 * kLambda);
+  free(keys);
+  printf("PRG kernel: %s\n", prg_name());
+  printf("Group: %s\n", group_name());
+
+  uint8_t *s0s = (uint8_t *)malloc(kLambda * 2);
+  assert(s0s != NULL);
+  gen_rand_bytes(s0s, kLambda * 2);
+
+  uint64_t alpha_int;
+  gen_rand_bytes((uint8_t *)&alpha_int, 8);
+  // Not to overflow alpha + 1 in any bitlen
+  alpha_int >>= 1;
+  uint64_t alpha1_int = alpha_int + 1;
+  uint8_t *beta = (uint8_t *)malloc(kLambda);
+  assert(beta != NULL);
+  memset(beta, 0, kLambda);
+  gen_rand_bytes(beta, 8);
+
+  uint8_t *sbuf = (uint8_t *)malloc(kLambda * 10);
+  assert(sbuf != NULL);
+  Key k_dpf = key_alloc(kDpfCwLen, kAlphaBitlen);
+  Key k_dcf_l = key_alloc(kDcfCwLen, kAlphaBitlen);
+  Key k_dcf_r = key_alloc(kDcfCwLen, kAlphaBitlen);
+
+  PerfCounters pc;
+  perf_open(&pc);
+
+  // Gen
+  int iter_num = 100000;
+  perf_reset(&pc);
+  perf_start(&pc);
+  t = get_time();
+  for (int i = 0; i < iter_num; i++) {
+    PointFunc pf = {{{(uint8_t *)&alpha_int, kAlphaBitlen}, beta}};
+    memcpy(sbuf, s0s, kLambda * 2);
+    dpf_gen(k_dpf, pf, sbuf);
+  }
+  perf_stop(&pc);
+  printf("dpf_gen (us): %lf\n", (get_time() - t) / iter_num * 1e6);
+  perf_report(&pc, "dpf_gen", iter_num);
+
+  t = get_time();
+  for (int i = 0; i < iter_num; i++) {
+    CmpFunc cf_l = {{{(uint8_t *)&alpha1_int, kAlphaBitlen}, beta}, kLtAlpha};
+    memcpy(sbuf, s0s, kLambda * 2);
+    dcf_gen(k_dcf_l, cf_l, sbuf);
+    CmpFunc cf_r = {{{(uint8_t *)&alpha_int, kAlphaBitlen}, beta}, kLtAlpha};
+    memcpy(sbuf, s0s, kLambda * 2);
+    dcf_gen(k_dcf_r, cf_r, sbuf);
+  }
+  printf("2 dcf_gen (us): %lf\n", (get_time() - t) / iter_num * 1e6);
+
+  Workspace ws;
+  ws_open(&ws, kLambda * 6);
+  uint64_t *xs = (uint64_t *)malloc(kN * sizeof(uint64_t));
+  assert(xs != NULL);
+  gen_rand_bytes((uint8_t *)xs, kN * sizeof(uint64_t));
+
+  // Eval
+  perf_reset(&pc);
+  perf_start(&pc);
+  t = get_time();
+#pragma omp parallel for
+  for (int i = 0; i < kN; i++) {
+    uint8_t *sbuf = ws_get(&ws, omp_get_thread_num());
+    Bits x_bits = {(uint8_t *)&xs[i], kAlphaBitlen};
+    memcpy(sbuf, s0s, kLambda);
+    dpf_eval(sbuf, 0, k_dpf, x_bits);
+  }
+  double t_dpf = get_time() - t;
+  perf_stop(&pc);
+  printf("dpf_eval (us): %lf\n", t_dpf / kN * 1e6);
+  perf_report(&pc, "dpf_eval", kN);
+
+  t = get_time();
+#pragma omp parallel for
+  for (int i = 0; i < kN; i++) {
+    uint8_t *sbuf = ws_get(&ws, omp_get_thread_num());
+    Bits x_bits = {(uint8_t *)&xs[i], kAlphaBitlen};
+    memcpy(sbuf, s0s, kLambda);
+    dcf_eval(sbuf, 0, k_dcf_l, x_bits);
+    memcpy(sbuf, s0s, kLambda);
+    dcf_eval(sbuf, 0, k_dcf_r, x_bits);
+  }
+  double t_dcf = get_time() - t;
+  printf("2 dcf_eval (us): %lf (%.2lfx)\n", t_dcf / kN * 1e6, t_dcf / t_dpf);
+  ws_close(&ws);
+  free(xs);
+
+  // Full domain eval
+  Key k_dpf_fd = key_alloc(kDpfCwLen, kFullDomainBitlen);
+  Key k_dcf_l_fd = key_alloc(kDcfCwLen, kFullDomainBitlen);
+  Key k_dcf_r_fd = key_alloc(kDcfCwLen, kFullDomainBitlen);
+  PointFunc pf = {{{(uint8_t *)&alpha_int, kFullDomainBitlen}, beta}};
+  memcpy(sbuf, s0s, kLambda * 2);
+  dpf_gen(k_dpf_fd, pf, sbuf);
+  CmpFunc cf_l = {{{(uint8_t *)&alpha1_int, kFullDomainBitlen}, beta}, kLtAlpha};
+  memcpy(sbuf, s0s, kLambda * 2);
+  dcf_gen(k_dcf_l_fd, cf_l, sbuf);
+  CmpFunc cf_r = {{{(uint8_t *)&alpha_int, kFullDomainBitlen}, beta}, kLtAlpha};
+  memcpy(sbuf, s0s, kLambda * 2);
+  dcf_gen(k_dcf_r_fd, cf_r, sbuf);
+
+  size_t fd_len = kLambda * ((size_t)1 << kFullDomainBitlen);
+  uint8_t *ys = (uint8_t *)malloc(fd_len);
+  assert(ys != NULL);
+  printf("Full domain bitlen: %d\n", kFullDomainBitlen);
+
+  perf_reset(&pc);
+  perf_start(&pc);
+  t = get_time();
+  for (int i = 0; i < kFullDomainIterNum; i++) {
+    memcpy(ys, s0s, kLambda);
+    dpf_eval_full_domain(ys, 0, k_dpf_fd, kFullDomainBitlen);
+  }
+  t_dpf = (get_time() - t) / kFullDomainIterNum;
+  perf_stop(&pc);
+  printf("dpf_eval_full_domain (ms): %lf\n", t_dpf * 1e3);
+  perf_report(&pc, "dpf_eval_full_domain", (double)kFullDomainIterNum * ((size_t)1 << kFullDomainBitlen));
+
+  t = get_time();
+  for (int i = 0; i < kFullDomainIterNum; i++) {
+    memcpy(ys, s0s, kLambda);
+    dcf_eval_full_domain(ys, 0, k_dcf_l_fd, kFullDomainBitlen);
+    memcpy(ys, s0s, kLambda);
+    dcf_eval_full_domain(ys, 0, k_dcf_r_fd, kFullDomainBitlen);
+  }
+  t_dcf = (get_time() - t) / kFullDomainIterNum;
+  printf("2 dcf_eval_full_domain (ms): %lf (%.2lfx)\n", t_dcf * 1e3, t_dcf / t_dpf);
+
+  // Cleanup
+  perf_close(&pc);
+  prg_free();
+  free(ys);
+  free(s0s);
+  free(beta);
+  free(sbuf);
+  key_free(k_dpf);
+  key_free(k_dcf_l);
+  key_free(k_dcf_r);
+  key_free(k_dpf_fd);
+  key_free(k_dcf_l_fd);
+  key_free(k_dcf_r_fd);
+  return 0;
+}
@@ -0,0 +1,230 @@
+// SPDX-License-Identifier: Apache-2.0
+
+#include <fss/dpf.h>
+#include <string.h>
+#include <assert.h>
+#include "../dcf/utils.h"
+#include "../dcf/full_domain.h"
+
+FSS_CUDA_HOST_DEVICE static inline void load_sst(uint8_t *ss, uint8_t *t0, uint8_t *t1) {
+  load_st(ss, t0);
+  load_st(ss + kLambda, t1);
+}
+
+// Save the 2bit tl tr in an extra byte
+FSS_CUDA_HOST_DEVICE static inline void set_cwt(uint8_t *cw, uint8_t tl, uint8_t tr) {
+  cw[kLambda] = tl << 1 | tr;
+}
+
+FSS_CUDA_HOST_DEVICE static inline void get_cwt(const uint8_t *cw, uint8_t *tl, uint8_t *tr) {
+  *tl = cw[kLambda] >> 1;
+  *tr = cw[kLambda] & 1;
+}
+
+// | s0 | s1 | s0l | s0r | s1l | s1r |
+// | ss      | s0s       | s1s       |
+FSS_CUDA_HOST_DEVICE void dpf_gen(Key k, PointFunc pf, uint8_t *sbuf) {
+  uint8_t *ss = sbuf;
+  uint8_t *s0 = ss;
+  uint8_t *s1 = ss + kLambda;
+  uint8_t t0, t1;
+  load_sst(ss, &t0, &t1);
+  t0 = 0;
+  t1 = 1;
+  Point p = pf.point;
+
+  uint8_t *s0s = sbuf + kLambda * 2;
+  uint8_t *s0l = s0s;
+  uint8_t *s0r = s0s + kLambda;
+  uint8_t *s1s = sbuf + kLambda * 4;
+  uint8_t *s1l = s1s;
+  uint8_t *s1r = s1s + kLambda;
+  uint8_t t0l, t0r, t1l, t1r;
+
+  for (int i = 0; i < p.alpha.bitlen; i++) {
+    prg(s0s, 2 * kLambda, s0);
+    prg(s1s, 2 * kLambda, s1);
+    load_sst(s0s, &t0l, &t0r);
+    load_sst(s1s, &t1l, &t1r);
+
+    // Actually get MSB first
+    uint8_t alpha_i = get_bit_lsb(p.alpha.bytes, p.alpha.bitlen - i - 1);
+    uint8_t *cw = k.cws + i * kDpfCwLen;
+
+    uint8_t *s_cw = cw;
+    memcpy(s_cw, alpha_i ? s0l : s0r, kLambda);
+    xor_bytes(s_cw, alpha_i ? s1l : s1r, kLambda);
+
+    uint8_t tl_cw, tr_cw;
+    tl_cw = t0l ^ t1l ^ alpha_i ^ 1;
+    tr_cw = t0r ^ t1r ^ alpha_i;
+    set_cwt(cw, tl_cw, tr_cw);
+
+    uint8_t *s0_keep = alpha_i ? s0r : s0l;
+    uint8_t *s1_keep = alpha_i ? s1r : s1l;
+    uint8_t t0_keep = alpha_i ? t0r : t0l;
+    uint8_t t1_keep = alpha_i ? t1r : t1l;
+    uint8_t t_cw_keep = alpha_i ? tr_cw : tl_cw;
+
+    memcpy(s0, s0_keep, kLambda);
+    if (t0) xor_bytes(s0, s_cw, kLambda);
+    memcpy(s1, s1_keep, kLambda);
+    if (t1) xor_bytes(s1, s_cw, kLambda);
+
+    if (t0) t0 = t0_keep ^ t_cw_keep;
+    else t0 = t0_keep;
+    if (t1) t1 = t1_keep ^ t_cw_keep;
+    else t1 = t1_keep;
+  }
+
+  // cw_np1 = (-1) ^ t1 * (beta - s0 + s1)
+  uint8_t *cw_np1 = k.cw_np1;
+  memcpy(cw_np1, p.beta, kLambda);
+  set_bit_lsb(cw_np1, kLambda * 8 - 1, 0);
+  group_neg(s0);
+  group_add(cw_np1, s0);
+  group_add(cw_np1, s1);
+  if (t1) group_neg(cw_np1);
+}
+
+// | s | sl | sr |
+// |   | ss      |
+FSS_CUDA_HOST_DEVICE void dpf_eval(uint8_t *sbuf, uint8_t b, Key k, Bits x) {
+  uint8_t *s = sbuf;
+  uint8_t t;
+  load_st(s, &t);
+  t = b;
+
+  uint8_t *ss = sbuf + kLambda;
+  uint8_t *sl = ss;
+  uint8_t *sr = ss + kLambda;
+  uint8_t tl, tr;
+
+  for (int i = 0; i < x.bitlen; i++) {
+    const uint8_t *cw = k.cws + i * kDpfCwLen;
+    uint8_t tl_cw, tr_cw;
+    get_cwt(cw, &tl_cw, &tr_cw);
+
+    prg(ss, 2 * kLambda, s);
+    load_sst(ss, &tl, &tr);
+
+    // Actually get MSB first
+    uint8_t x_i = get_bit_lsb(x.bytes, x.bitlen - i - 1);
+
+    memcpy(s, x_i ? sr : sl, kLambda);
+    if (t) xor_bytes(s, cw, kLambda);
+    if (t) t = (x_i ? tr : tl) ^ (x_i ? tr_cw : tl_cw);
+    else t = x_i ? tr : tl;
+  }
+
+  // Convert s to a group element
+  group_zero(sl);
+  group_add(sl, s);
+  if (t) group_add(sl, k.cw_np1);
+  if (b) group_neg(sl);
+  memcpy(s, sl, kLambda);
+}
+
+// Expand the node at `sbufl`, whose `s` with `t` in MSB is at first lambda bytes, to its children at `sbufl` and `sbufr`.
+// Inner nodes do not depend on the party bit `b`, which is only for the signature of FullDomainNodeFn.
+static void dpf_eval_full_domain_node(int depth, uint8_t *sbufl, uint8_t *sbufr, uint8_t b, Key k) {
+  (void)b;
+  uint8_t t;
+  load_st(sbufl, &t);
+
+  uint8_t ss[kLambda * 2];
+  uint8_t *sl = ss;
+  uint8_t *sr = ss + kLambda;
+  uint8_t tl, tr;
+
+  const uint8_t *cw = k.cws + depth * kDpfCwLen;
+  uint8_t tl_cw, tr_cw;
+  get_cwt(cw, &tl_cw, &tr_cw);
+
+  prg(ss, 2 * kLambda, sbufl);
+  load_sst(ss, &tl, &tr);
+  if (t) {
+    xor_bytes(sl, cw, kLambda);
+    xor_bytes(sr, cw, kLambda);
+    tl ^= tl_cw;
+    tr ^= tr_cw;
+  }
+
+  memcpy(sbufl, sl, kLambda);
+  set_st(sbufl, tl);
+  memcpy(sbufr, sr, kLambda);
+  set_st(sbufr, tr);
+}
+
+// Height of subtrees evaluated breadth-first with prg_n(), i.e., up to 2 ^ this leaves per batch
+#define kFullDomainBlockDepth 5
+
+// Eval all leaves of the subtree whose root is at `sbuf`, breadth-first so that each level is 1 prg_n() call.
+// Unlike DCF, nodes only have `s` and `t`, so the level is expanded in place backward.
+static void dpf_eval_full_domain_block(int depth, uint8_t *sbuf, uint8_t b, Key k, int height) {
+  uint8_t ss[kLambda << kFullDomainBlockDepth];
+  uint8_t ts[1 << kFullDomainBlockDepth];
+  assert(height <= kFullDomainBlockDepth);
+
+  memcpy(ss, sbuf, kLambda);
+  load_st(ss, &ts[0]);
+
+  for (int h = 0; h < height; h++) {
+    int width = 1 << h;
+    const uint8_t *cw = k.cws + (depth + h) * kDpfCwLen;
+    uint8_t tl_cw, tr_cw;
+    get_cwt(cw, &tl_cw, &tr_cw);
+
+    // Output of seed j is at 2j * lambda, which is where its children are
+    uint8_t seeds[kLambda << (kFullDomainBlockDepth - 1)];
+    memcpy(seeds, ss, width * kLambda);
+    prg_n(ss, 2 * kLambda, seeds, width);
+
+    for (int j = width - 1; j >= 0; j--) {
+      uint8_t *sl = ss + 2 * j * kLambda;
+      uint8_t *sr = sl + kLambda;
+      uint8_t tl, tr;
+      uint8_t t = ts[j];
+      load_sst(sl, &tl, &tr);
+      if (t) {
+        xor_bytes(sl, cw, kLambda);
+        xor_bytes(sr, cw, kLambda);
+        tl ^= tl_cw;
+        tr ^= tr_cw;
+      }
+      ts[2 * j] = tl;
+      ts[2 * j + 1] = tr;
+    }
+  }
+
+  for (int j = 0; j < (1 << height); j++) {
+    uint8_t *s = ss + j * kLambda;
+    uint8_t *y = sbuf + j * kLambda;
+    group_zero(y);
+    group_add(y, s);
+    if (ts[j]) group_add(y, k.cw_np1);
+    if (b) group_neg(y);
+  }
+}
+
+static void dpf_eval_full_domain_subtree(int depth, uint8_t *sbuf, size_t l, size_t r, uint8_t b, Key k, int x_bitlen) {
+  assert(kLambda * (1ULL << (x_bitlen - depth)) == r - l);
+
+  if (x_bitlen - depth <= kFullDomainBlockDepth) {
+    dpf_eval_full_domain_block(depth, sbuf + l, b, k, x_bitlen - depth);
+    return;
+  }
+
+  size_t mid = (l + r) / 2;
+  dpf_eval_full_domain_node(depth, sbuf + l, sbuf + mid, b, k);
+  dpf_eval_full_domain_subtree(depth + 1, sbuf, l, mid, b, k, x_bitlen);
+  dpf_eval_full_domain_subtree(depth + 1, sbuf, mid, r, b, k, x_bitlen);
+}
+
+static const FullDomainTree kDpfFullDomainTree = {
+  dpf_eval_full_domain_node, dpf_eval_full_domain_subtree, kFullDomainBlockDepth};
+
+void dpf_eval_full_domain(uint8_t *sbuf, uint8_t b, Key k, int x_bitlen) {
+  set_st(sbuf, b);
+  full_domain_eval(&kDpfFullDomainTree, sbuf, b, k, x_bitlen);
+}
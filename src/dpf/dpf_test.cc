@@ -0,0 +1,156 @@
+#include <algorithm>
+#include <random>
+#include <cstdlib>
+#include <cstring>
+#include <climits>
+#include <cassert>
+#include <gtest/gtest.h>
+#include <fss/dpf.h>
+#include <fss/dcf.h>
+
+using random_bytes_engine = std::independent_bits_engine<std::default_random_engine, CHAR_BIT, uint8_t>;
+
+class DpfTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    std::random_device rd;
+    random_bytes_engine rbe(rd());
+    uint8_t keys[4 * kLambda];
+    std::generate(std::begin(keys), std::end(keys), std::ref(rbe));
+    prg_init((uint8_t *)keys, 4 * kLambda);
+
+    kS0s = (uint8_t *)malloc(kLambda * 2);
+    assert(kS0s != NULL);
+    std::generate(kS0s, kS0s + kLambda * 2, std::ref(rbe));
+
+    sbuf = (uint8_t *)malloc(kLambda * 6);
+    assert(sbuf != NULL);
+    key.cw_np1 = (uint8_t *)malloc(kLambda);
+    assert(key.cw_np1 != NULL);
+    key.cws = (uint8_t *)malloc(kDpfCwLen * kAlphaBitlen);
+    assert(key.cws != NULL);
+
+    alpha_int = kAlpha;
+    Bits alpha_bits = {(uint8_t *)&alpha_int, kAlphaBitlen};
+    memset(beta, 0, kLambda);
+    memcpy(beta, &kBeta, 8);
+    PointFunc pf = {{alpha_bits, beta}};
+    memcpy(sbuf, kS0s, kLambda * 2);
+    dpf_gen(key, pf, sbuf);
+  }
+
+  void TearDown() override {
+    prg_free();
+    free(kS0s);
+    free(sbuf);
+    free(key.cw_np1);
+    free(key.cws);
+  }
+
+  // Eval of party `b` at `x`
+  void Eval(uint8_t *y, uint8_t b, uint16_t x) {
+    Bits x_bits = {(uint8_t *)&x, kAlphaBitlen};
+    memcpy(sbuf, kS0s + b * kLambda, kLambda);
+    dpf_eval(sbuf, b, key, x_bits);
+    memcpy(y, sbuf, kLambda);
+  }
+
+  static constexpr uint16_t kAlpha = 107;
+  static constexpr int kAlphaBitlen = 16;
+  static constexpr uint64_t kBeta = 604;
+
+  uint8_t *kS0s;
+  uint8_t *sbuf;
+  Key key;
+  uint16_t alpha_int;
+  uint8_t beta[kLambda];
+};
+
+TEST_F(DpfTest, EvalAtRandPoints) {
+  std::random_device rd;
+  std::mt19937 gen(rd());
+  std::uniform_int_distribution<uint16_t> dis(0, UINT16_MAX);
+
+  constexpr int kNumTrials = 100;
+
+  for (int i = 0; i < kNumTrials; i++) {
+    uint16_t x = i == 0 ? kAlpha : dis(gen);
+    uint8_t y0[kLambda], y1[kLambda];
+    Eval(y0, 0, x);
+    Eval(y1, 1, x);
+    group_add(y0, y1);
+
+    uint8_t expected[kLambda];
+    memset(expected, 0, kLambda);
+    if (x == kAlpha) memcpy(expected, beta, kLambda);
+    EXPECT_EQ(memcmp(y0, expected, kLambda), 0) << "Result differ at x = " << x;
+  }
+}
+
+TEST_F(DpfTest, EvalFullDomainEqEvalPoints) {
+  uint8_t *ys0_full = (uint8_t *)malloc(kLambda * (1 << kAlphaBitlen));
+  uint8_t *ys1_full = (uint8_t *)malloc(kLambda * (1 << kAlphaBitlen));
+  assert(ys0_full != NULL && ys1_full != NULL);
+
+  memcpy(ys0_full, kS0s, kLambda);
+  dpf_eval_full_domain(ys0_full, 0, key, kAlphaBitlen);
+  memcpy(ys1_full, kS0s + kLambda, kLambda);
+  dpf_eval_full_domain(ys1_full, 1, key, kAlphaBitlen);
+
+  std::random_device rd;
+  std::mt19937 gen(rd());
+  std::uniform_int_distribution<uint16_t> dis(0, UINT16_MAX);
+
+  constexpr int kNumTrials = 100;
+
+  for (int i = 0; i < kNumTrials; i++) {
+    uint16_t x = i == 0 ? kAlpha : dis(gen);
+    uint8_t y0[kLambda], y1[kLambda];
+    Eval(y0, 0, x);
+    Eval(y1, 1, x);
+
+    EXPECT_EQ(memcmp(y0, ys0_full + (int)x * kLambda, kLambda), 0) << "Party 0 shares differ at x = " << x;
+    EXPECT_EQ(memcmp(y1, ys1_full + (int)x * kLambda, kLambda), 0) << "Party 1 shares differ at x = " << x;
+  }
+
+  // Only alpha is non-zero
+  for (int x = 0; x < (1 << kAlphaBitlen); x++) {
+    uint8_t *y = ys0_full + x * kLambda;
+    group_add(y, ys1_full + x * kLambda);
+    if (x == kAlpha) {
+      EXPECT_EQ(memcmp(y, beta, kLambda), 0) << "Result differ at x = " << x;
+    } else {
+      uint8_t zero[kLambda];
+      memset(zero, 0, kLambda);
+      ASSERT_EQ(memcmp(y, zero, kLambda), 0) << "Result differ at x = " << x;
+    }
+  }
+
+  free(ys0_full);
+  free(ys1_full);
+}
+
+TEST_F(DpfTest, EvalFullDomainIndependentOfGrain) {
+  size_t len = kLambda * (1 << kAlphaBitlen);
+  uint8_t *ys_ref = (uint8_t *)malloc(len);
+  uint8_t *ys = (uint8_t *)malloc(len);
+  assert(ys_ref != NULL && ys != NULL);
+
+  for (uint8_t b = 0; b < 2; b++) {
+    dcf_full_domain_set_grain(kAlphaBitlen);
+    memcpy(ys_ref, kS0s + b * kLambda, kLambda);
+    dpf_eval_full_domain(ys_ref, b, key, kAlphaBitlen);
+
+    // Below the block height, the block height, and heights that split the top levels into tasks
+    for (int grain_bitlen : {1, 5, 6, 12}) {
+      dcf_full_domain_set_grain(grain_bitlen);
+      memcpy(ys, kS0s + b * kLambda, kLambda);
+      dpf_eval_full_domain(ys, b, key, kAlphaBitlen);
+      EXPECT_EQ(memcmp(ys, ys_ref, len), 0) << "b = " << (int)b << ", grain_bitlen = " << grain_bitlen;
+    }
+  }
+  dcf_full_domain_set_grain(12);
+
+  free(ys_ref);
+  free(ys);
+}
@@ -0,0 +1,30 @@
+// SPDX-License-Identifier: Apache-2.0
+
+#include "fixed.h"
+#include <assert.h>
+
+void fixed_quantize(uint64_t *out, const float *v, int dim, int bitlen) {
+  assert(bitlen >= kFixedMinBitlen && bitlen <= kFixedMaxBitlen);
+  double scale = (double)(1ULL << fixed_frac_bits(bitlen));
+  for (int i = 0; i < dim; i++) {
+    // The cast truncates toward 0, which keeps the norm <= the scale
+    out[i] = (uint64_t)(int64_t)(v[i] * scale);
+  }
+}
+
+uint64_t fixed_dot_share(
+  int b, const uint64_t *e, const uint64_t *f, const uint64_t *x_b, const uint64_t *y_b, uint64_t z_b, int dim, int bitlen) {
+  uint64_t sum = z_b;
+  for (int i = 0; i < dim; i++) {
+    sum += e[i] * y_b[i] + x_b[i] * f[i];
+  }
+  // Both e . f and the offset are public, so 1 party adds each
+  if (b) {
+    for (int i = 0; i < dim; i++) {
+      sum += e[i] * f[i];
+    }
+  } else {
+    sum += 1ULL << (bitlen - 1);
+  }
+  return sum & fixed_mask(bitlen);
+}
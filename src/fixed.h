@@ -0,0 +1,47 @@
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @file fixed.h
+ *
+ * Fixed-point scores of `bitlen` bits, so that retrieval compares with `bitlen`-bit DCF keys instead of 64-bit field elements.
+ *
+ * Embeddings are unit vectors. Each component is scaled by 2^q with q = @ref fixed_frac_bits() and truncated toward 0,
+ * so a quantized vector has norm <= 2^q and a score, i.e., an inner product, is in [-2^(2q), 2^(2q)] within [-2^(bitlen - 2), 2^(bitlen - 2)].
+ * Shares are over Z_2^64, where the dot product of @ref fixed_dot_share() wraps, and 2^bitlen divides 2^64,
+ * so reducing a share mod 2^bitlen gives a share of the score mod 2^bitlen, which is exact as the score fits.
+ * Party 0 adds the offset 2^(bitlen - 1), so the encoded score is unsigned in [0, 2^bitlen) in the same order,
+ * and is masked, opened and compared by @ref ic_gen_ge() with modulus 2^bitlen and bitlen `bitlen`.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#define kFixedMinBitlen 8
+// So that the modulus 2^bitlen of ic_gen_ge() fits in 64 bits
+#define kFixedMaxBitlen 63
+
+static inline uint64_t fixed_mask(int bitlen) {
+  return (1ULL << bitlen) - 1;
+}
+
+/**
+ * Bits of the fraction of a quantized component, i.e., q
+ */
+static inline int fixed_frac_bits(int bitlen) {
+  return (bitlen - 2) / 2;
+}
+
+/**
+ * Quantize a unit vector to Z_2^64, where negative components are in two's complement
+ */
+void fixed_quantize(uint64_t *out, const float *v, int dim, int bitlen);
+
+/**
+ * Party `b`'s share mod 2^`bitlen` of the encoded score of 1 query and 1 doc, with a Beaver triple over Z_2^64,
+ * i.e., z_b + e . y_b + x_b . f + b * e . f + (1 - b) * 2^(`bitlen` - 1).
+ * @param e Opened query - x
+ * @param f Opened doc - y
+ */
+uint64_t fixed_dot_share(
+  int b, const uint64_t *e, const uint64_t *f, const uint64_t *x_b, const uint64_t *y_b, uint64_t z_b, int dim, int bitlen);
@@ -0,0 +1,92 @@
+#include <cmath>
+#include <random>
+#include <vector>
+#include <gtest/gtest.h>
+
+extern "C" {
+#include "fixed.h"
+}
+
+class FixedTest : public ::testing::TestWithParam<int> {
+ protected:
+  // Unit vectors with negative components and components of exactly +-1.0
+  static std::vector<std::vector<float>> vectors(int dim) {
+    std::vector<std::vector<float>> vs;
+    for (int i = 0; i < 2; i++) {
+      std::vector<float> v(dim, 0.0f);
+      v[i] = i ? -1.0f : 1.0f;
+      vs.push_back(v);
+    }
+    std::mt19937 gen(5);
+    std::normal_distribution<float> dist;
+    for (int i = 0; i < 6; i++) {
+      std::vector<float> v(dim);
+      double norm = 0;
+      for (auto &c : v) {
+        c = dist(gen);
+        norm += (double)c * c;
+      }
+      for (auto &c : v) c = (float)(c / std::sqrt(norm));
+      vs.push_back(v);
+    }
+    return vs;
+  }
+};
+
+TEST_P(FixedTest, Quantize) {
+  int bitlen = GetParam();
+  int q = fixed_frac_bits(bitlen);
+  const float v[] = {1.0f, -1.0f, 0.0f, 0.5f, -0.5f, 0.3f, -0.3f};
+  int dim = sizeof(v) / sizeof(v[0]);
+  std::vector<uint64_t> out(dim);
+  fixed_quantize(out.data(), v, dim, bitlen);
+  EXPECT_EQ(out[0], 1ULL << q);
+  EXPECT_EQ(out[1], (uint64_t)-(1LL << q));
+  EXPECT_EQ(out[2], 0ULL);
+  EXPECT_EQ(out[3], 1ULL << (q - 1));
+  EXPECT_EQ(out[4], (uint64_t)-(1LL << (q - 1)));
+  // Truncated toward 0, so negatives are the negation of the positives
+  EXPECT_EQ(out[5], (uint64_t)(int64_t)std::trunc((double)0.3f * std::ldexp(1.0, q)));
+  EXPECT_EQ(out[6], -out[5]);
+}
+
+TEST_P(FixedTest, DotShareReconstructs) {
+  int bitlen = GetParam();
+  constexpr int kDim = 16;
+  auto vs = vectors(kDim);
+  std::mt19937_64 gen(7);
+  for (auto &query : vs) {
+    for (auto &doc : vs) {
+      std::vector<uint64_t> qv(kDim), dv(kDim);
+      fixed_quantize(qv.data(), query.data(), kDim, bitlen);
+      fixed_quantize(dv.data(), doc.data(), kDim, bitlen);
+
+      // A Beaver triple over Z_2^64, shared additively
+      std::vector<uint64_t> x0(kDim), x1(kDim), y0(kDim), y1(kDim), e(kDim), f(kDim);
+      uint64_t z = 0, want = 0;
+      for (int i = 0; i < kDim; i++) {
+        x0[i] = gen(), x1[i] = gen(), y0[i] = gen(), y1[i] = gen();
+        uint64_t x = x0[i] + x1[i], y = y0[i] + y1[i];
+        z += x * y;
+        e[i] = qv[i] - x;
+        f[i] = dv[i] - y;
+        want += qv[i] * dv[i];
+      }
+      uint64_t z0 = gen(), z1 = z - z0;
+
+      uint64_t s0 = fixed_dot_share(0, e.data(), f.data(), x0.data(), y0.data(), z0, kDim, bitlen);
+      uint64_t s1 = fixed_dot_share(1, e.data(), f.data(), x1.data(), y1.data(), z1, kDim, bitlen);
+      ASSERT_LE(s0, fixed_mask(bitlen));
+      ASSERT_LE(s1, fixed_mask(bitlen));
+      uint64_t got = (s0 + s1) & fixed_mask(bitlen);
+      ASSERT_EQ(got, (want + (1ULL << (bitlen - 1))) & fixed_mask(bitlen));
+
+      // The score fits, so the encoding keeps the order of the signed score
+      int64_t score = (int64_t)want;
+      ASSERT_LE(std::llabs(score), 1LL << (bitlen - 2));
+      ASSERT_EQ((int64_t)got - (1LL << (bitlen - 1)), score);
+    }
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(Bitlens, FixedTest, ::testing::Values(kFixedMinBitlen, 16, 32, kFixedMaxBitlen));
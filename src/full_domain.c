@@ -0,0 +1,119 @@
+// For real-time extensions
+#define _POSIX_C_SOURCE 199309L
+
+// Scaling of dcf_eval_full_domain across thread counts and domain sizes, with dcf_eval_full_domain_u64 for its 8-byte outputs.
+// Usage: full_domain_benchmark [grain_bitlen]
+
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <fss/dcf.h>
+#include <omp.h>
+
+#define kSeed 114514
+#define kMinBitlen 16
+#define kMaxBitlen 24
+#define kBitlenStep 4
+#define kIterNum 5
+
+static inline double get_time() {
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1.0e-9;
+}
+
+static void gen_rand_bytes(uint8_t *buf, size_t len) {
+  for (size_t i = 0; i < len; i++) {
+    buf[i] = rand() & 0xFF;
+  }
+}
+
+int main(int argc, char **argv) {
+  srand(kSeed);
+  int max_threads = omp_get_max_threads();
+  printf("Max thread num: %d\n", max_threads);
+  printf("Lambda (B): %d\n", kLambda);
+  if (argc > 1) {
+    int grain_bitlen = atoi(argv[1]);
+    dcf_full_domain_set_grain(grain_bitlen);
+    printf("Grain bitlen: %d\n", grain_bitlen);
+  }
+
+  // Init PRG
+  uint8_t *keys = (uint8_t *)malloc(4 * kLambda);
+  assert(keys != NULL);
+  gen_rand_bytes(keys, 4 * kLambda);
+  prg_init(keys, 4 * kLambda);
+  free(keys);
+  printf("PRG kernel: %s\n", prg_name());
+  printf("Group: %s\n", group_name());
+
+  uint8_t *s0s = (uint8_t *)malloc(kLambda * 2);
+  assert(s0s != NULL);
+  gen_rand_bytes(s0s, kLambda * 2);
+  uint8_t *beta = (uint8_t *)malloc(kLambda);
+  assert(beta != NULL);
+  memset(beta, 0, kLambda);
+  gen_rand_bytes(beta, 8);
+
+  uint8_t *sbuf = (uint8_t *)malloc(kLambda * ((size_t)1 << kMaxBitlen));
+  assert(sbuf != NULL);
+  uint64_t *ys = (uint64_t *)malloc(sizeof(uint64_t) * ((size_t)1 << kMaxBitlen));
+  assert(ys != NULL);
+  Key k;
+  k.cw_np1 = (uint8_t *)malloc(kLambda);
+  assert(k.cw_np1 != NULL);
+  k.cws = (uint8_t *)malloc(kDcfCwLen * kMaxBitlen);
+  assert(k.cws != NULL);
+
+  printf("bitlen,threads,ms,ns_per_leaf,speedup,u64_ms\n");
+  for (int bitlen = kMinBitlen; bitlen <= kMaxBitlen; bitlen += kBitlenStep) {
+    uint8_t alpha[4];
+    gen_rand_bytes(alpha, sizeof(alpha));
+    Bits alpha_bits = {alpha, bitlen};
+    CmpFunc cf = {{alpha_bits, beta}, kLtAlpha};
+    memcpy(sbuf, s0s, kLambda * 2);
+    dcf_gen(k, cf, sbuf);
+
+    double t_single = 0;
+    // Powers of 2 then the max if it is not one
+    for (int threads = 1; threads <= max_threads; threads = threads * 2 > max_threads && threads != max_threads ? max_threads : threads * 2) {
+      omp_set_num_threads(threads);
+      // Warm up, which also (re)creates the pool
+      memcpy(sbuf, s0s, kLambda);
+      dcf_eval_full_domain(sbuf, 0, k, bitlen);
+
+      double t = get_time();
+      for (int i = 0; i < kIterNum; i++) {
+        memcpy(sbuf, s0s, kLambda);
+        dcf_eval_full_domain(sbuf, 0, k, bitlen);
+      }
+      double t_elapsed = (get_time() - t) / kIterNum;
+      if (threads == 1) t_single = t_elapsed;
+
+      // Scratch of the 8-byte output mode is small, so reuse sbuf
+      assert(dcf_full_domain_u64_sbuf_len(bitlen) <= kLambda * ((size_t)1 << bitlen));
+      t = get_time();
+      for (int i = 0; i < kIterNum; i++) {
+        memcpy(sbuf, s0s, kLambda);
+        dcf_eval_full_domain_u64(ys, sbuf, 0, k, bitlen);
+      }
+      double t_u64 = (get_time() - t) / kIterNum;
+      printf("%d,%d,%lf,%lf,%.2lf,%lf\n", bitlen, threads, t_elapsed * 1e3,
+        t_elapsed / ((size_t)1 << bitlen) * 1e9, t_single / t_elapsed, t_u64 * 1e3);
+      if (threads == max_threads) break;
+    }
+  }
+  omp_set_num_threads(max_threads);
+
+  prg_free();
+  free(s0s);
+  free(beta);
+  free(sbuf);
+  free(ys);
+  free(k.cw_np1);
+  free(k.cws);
+  return 0;
+}
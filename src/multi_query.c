@@ -0,0 +1,88 @@
+// For real-time extensions
+#define _POSIX_C_SOURCE 199309L
+
+// Concurrent retrieval queries served 1 at a time vs with co-scheduled rounds. See sched.h.
+// Usage: multi_query_benchmark [clients] [queries] [chunk]
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <omp.h>
+#include <fss/dcf.h>
+#include <fss/prg.h>
+#include "rand.h"
+#include "sched.h"
+
+#define kSeed 114514
+#define kN 4096  // Number of documents
+#define kStep 13  // Number of binary search steps
+
+static int cmp_double(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+// Nearest-rank percentile of sorted `xs`
+static double percentile(const double *xs, int n, int p) {
+  int rank = (n * p + 99) / 100;
+  return xs[rank > 0 ? rank - 1 : 0];
+}
+
+static void report(const char *name, double t_all, double *latencies, int query_num) {
+  qsort(latencies, query_num, sizeof(double), cmp_double);
+  printf("%s,%lf,%lf,%lf,%lf,%lf\n", name, query_num / t_all, percentile(latencies, query_num, 50) * 1e3,
+    percentile(latencies, query_num, 95) * 1e3, percentile(latencies, query_num, 99) * 1e3,
+    latencies[query_num - 1] * 1e3);
+}
+
+int main(int argc, char **argv) {
+  int client_num = argc > 1 ? atoi(argv[1]) : 8;
+  int query_num = argc > 2 ? atoi(argv[2]) : 32;
+  int chunk = argc > 3 ? atoi(argv[3]) : 256;
+  assert(client_num > 0 && query_num > 0 && chunk > 0);
+
+  uint64_t seed[2] = {kSeed, 0};
+  Rng rng;
+  rng_init(&rng, (uint8_t *)seed, 0);
+  uint8_t keys[4 * kLambda];
+  rng_fill_bytes(&rng, keys, sizeof(keys));
+  prg_init(keys, sizeof(keys));
+
+  printf("OpenMP thread num: %d\n", omp_get_max_threads());
+  printf("PRG kernel: %s\n", prg_name());
+  printf("N (Docs): %d\n", kN);
+  printf("Steps: %d\n", kStep);
+  printf("Clients: %d, queries: %d, chunk: %d docs\n", client_num, query_num, chunk);
+
+  // Dummy masked inputs
+  uint64_t *xs = (uint64_t *)malloc(kN * sizeof(uint64_t));
+  assert(xs != NULL);
+  rng_fill_field(&rng, xs, kN);
+
+  Sched s;
+  sched_init(&s, xs, kN, kStep, chunk, client_num);
+  double *latencies = (double *)malloc(query_num * sizeof(double));
+  uint64_t *results = (uint64_t *)malloc(query_num * sizeof(uint64_t));
+  uint64_t *results_serial = (uint64_t *)malloc(query_num * sizeof(uint64_t));
+  assert(latencies != NULL && results != NULL && results_serial != NULL);
+
+  printf("mode,queries_s,p50_ms,p95_ms,p99_ms,max_ms\n");
+  double t_all = sched_run_serial(&s, query_num, latencies, results_serial);
+  report("serial", t_all, latencies, query_num);
+  t_all = sched_run(&s, query_num, latencies, results);
+  report("cosched", t_all, latencies, query_num);
+  // Same keys per query in both schedules
+  assert(memcmp(results, results_serial, query_num * sizeof(uint64_t)) == 0);
+  // And the right counts, not only equal ones
+  int ok = sched_check(&s, 0, results[0]) && sched_check(&s, query_num - 1, results[query_num - 1]);
+  assert(ok);
+  (void)ok;
+
+  sched_free(&s);
+  free(xs);
+  free(latencies);
+  free(results);
+  free(results_serial);
+  return 0;
+}
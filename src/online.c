@@ -0,0 +1,214 @@
+// For real-time extensions
+#define _POSIX_C_SOURCE 199309L
+
+// Online phase consuming fresh correlated randomness per query from a preprocessing pool file vs reusing 1 inline key.
+// A query is 1 DCF eval at its masked input plus expanding its dot-product triples.
+// The pool fires its refill hook, which deals the next pool file, when a quarter is left.
+// Once drained, the pools rotate onto that file and a 2nd pass consumes it, firing the re-armed hook again.
+// Usage: online_benchmark [dir]
+
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <fss/dcf.h>
+#include <omp.h>
+#include "preproc.h"
+#include "preproc_pool.h"
+#include "workspace.h"
+
+#define kSeed 114514
+#define kAlphaBitlen 64
+#define kDim 1024
+#define kRecordNum 8192
+// Records per reservation
+#define kSlice 16
+
+typedef unsigned __int128 uint128_t;
+
+static inline double get_time() {
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1.0e-9;
+}
+
+static void gen_rand_bytes(uint8_t *buf, size_t len) {
+  for (size_t i = 0; i < len; i++) {
+    buf[i] = rand() & 0xFF;
+  }
+}
+
+typedef struct {
+  char path0[256];
+  char path1[256];
+  double t;
+  int num;
+} Refill;
+
+static void refill(void *arg) {
+  Refill *r = (Refill *)arg;
+  double t = get_time();
+  int ret = pp_deal(r->path0, r->path1, kAlphaBitlen, kDim, kRecordNum);
+  assert(ret == 0);
+  (void)ret;
+  r->t += get_time() - t;
+  r->num++;
+}
+
+// 1 query: the DCF eval at `x` and the triples, with | sbuf | x_0 | y_0 | z_0 | in `scratch`
+static inline uint64_t query(uint8_t *scratch, const uint8_t *s0, Key k, const uint8_t *triple_seed, uint64_t x) {
+  uint64_t *xyz = (uint64_t *)(scratch + kLambda * 10);
+  memcpy(scratch, s0, kLambda);
+  Bits x_bits = {(uint8_t *)&x, kAlphaBitlen};
+  dcf_eval(scratch, 0, k, x_bits);
+  preproc_expand(xyz, xyz + kDim, xyz + kDim * 2, triple_seed, 0, kDim);
+  uint64_t y;
+  memcpy(&y, scratch, 8);
+  return y ^ xyz[0];
+}
+
+// Both parties' shares of a few records open to [x < r] and to valid triples
+static void check_records(const PreprocPool *pools, const uint64_t *xs) {
+  for (uint64_t i = 0; i < kRecordNum; i += kRecordNum / 8) {
+    PpRecord r0 = pp_record(&pools[0], i), r1 = pp_record(&pools[1], i);
+    uint8_t sbufs[2][kLambda * 6];
+    Bits x_bits = {(uint8_t *)&xs[i], kAlphaBitlen};
+    memcpy(sbufs[0], r0.s0, kLambda);
+    dcf_eval(sbufs[0], 0, r0.k, x_bits);
+    memcpy(sbufs[1], r1.s0, kLambda);
+    dcf_eval(sbufs[1], 1, r1.k, x_bits);
+    group_add(sbufs[0], sbufs[1]);
+    uint64_t y, mask = r0.mask + r1.mask;
+    if (mask < r0.mask || mask >= kPreprocPrime) mask -= kPreprocPrime;
+    memcpy(&y, sbufs[0], 8);
+    assert(y == (xs[i] < mask));
+
+    uint64_t x0, y0, z0;
+    preproc_expand(&x0, &y0, &z0, r0.triple_seed, kDim - 1, 1);
+    uint128_t xk = ((uint128_t)x0 + r1.x1[kDim - 1]) % kPreprocPrime;
+    uint128_t yk = ((uint128_t)y0 + r1.y1[kDim - 1]) % kPreprocPrime;
+    assert((uint64_t)(xk * yk % kPreprocPrime) == (uint64_t)(((uint128_t)z0 + r1.z1[kDim - 1]) % kPreprocPrime));
+    (void)y;
+    (void)xk;
+    (void)yk;
+  }
+}
+
+// Fresh records reserved kSlice at a time until the pool is drained, so each is used once
+static double pool_pass(PreprocPool *pool, Workspace *ws, const uint64_t *xs, double *t_reserve, uint64_t *sink) {
+  uint64_t acc = 0;
+  double tr_sum = 0;
+  double t = get_time();
+#pragma omp parallel reduction(^ : acc) reduction(+ : tr_sum)
+  {
+    uint8_t *scratch = ws_get(ws, omp_get_thread_num());
+    for (;;) {
+      double tr = get_time();
+      int64_t first = pp_reserve(pool, kSlice);
+      tr_sum += get_time() - tr;
+      if (first < 0) break;
+      for (int64_t i = first; i < first + kSlice; i++) {
+        PpRecord r = pp_record(pool, i);
+        acc ^= query(scratch, r.s0, r.k, r.triple_seed, xs[i]);
+      }
+    }
+  }
+  t = get_time() - t;
+  assert(pp_remaining(pool) == 0);
+  *t_reserve += tr_sum;
+  *sink ^= acc;
+  return t;
+}
+
+int main(int argc, char **argv) {
+  srand(kSeed);
+  const char *dir = argc > 1 ? argv[1] : "/tmp";
+  printf("OpenMP thread num: %d\n", omp_get_max_threads());
+  printf("Lambda (B): %d\n", kLambda);
+
+  // Init PRG
+  uint8_t *keys = (uint8_t *)malloc(4 * kLambda);
+  assert(keys != NULL);
+  gen_rand_bytes(keys, 4 * kLambda);
+  prg_init(keys, 4 * kLambda);
+  free(keys);
+  printf("PRG kernel: %s\n", prg_name());
+  printf("Preproc kernel: %s\n", preproc_kernel_name());
+
+  char path0[256], path1[256];
+  snprintf(path0, sizeof(path0), "%s/fss_pp_0", dir);
+  snprintf(path1, sizeof(path1), "%s/fss_pp_1", dir);
+  Refill next;
+  snprintf(next.path0, sizeof(next.path0), "%s/fss_pp_0.next", dir);
+  snprintf(next.path1, sizeof(next.path1), "%s/fss_pp_1.next", dir);
+  next.t = 0;
+  next.num = 0;
+
+  double t = get_time();
+  int ret = pp_deal(path0, path1, kAlphaBitlen, kDim, kRecordNum);
+  assert(ret == 0);
+  printf("Deal %d records (us/record): %lf\n", kRecordNum, (get_time() - t) / kRecordNum * 1e6);
+  printf("Record len (B): party 0 %zu, party 1 %zu\n", pp_record_len(0, kAlphaBitlen, kDim),
+    pp_record_len(1, kAlphaBitlen, kDim));
+
+  PreprocPool pools[2];
+  ret = pp_open(&pools[0], path0);
+  assert(ret == 0);
+  ret = pp_open(&pools[1], path1);
+  assert(ret == 0);
+  (void)ret;
+
+  // Masked inputs, i.e., x + r of each query
+  uint64_t *xs = (uint64_t *)malloc(kRecordNum * sizeof(uint64_t));
+  assert(xs != NULL);
+  gen_rand_bytes((uint8_t *)xs, kRecordNum * sizeof(uint64_t));
+
+  check_records(pools, xs);
+
+  Workspace ws;
+  ws_open(&ws, kLambda * 10 + kDim * 3 * sizeof(uint64_t));
+  uint64_t sink = 0;
+
+  // Baseline: 1 key and 1 triple seed reused by all queries, as the other benchmarks do
+  PpRecord fixed = pp_record(&pools[0], 0);
+  t = get_time();
+#pragma omp parallel for reduction(^ : sink)
+  for (int i = 0; i < kRecordNum; i++) {
+    sink ^= query(ws_get(&ws, omp_get_thread_num()), fixed.s0, fixed.k, fixed.triple_seed, xs[i]);
+  }
+  double t_fixed = (get_time() - t) / kRecordNum;
+
+  // 2 passes over fresh records: the dealt pool, then the refilled one it rotates onto
+  pp_set_refill(&pools[0], kRecordNum / 4, refill, &next);
+  double t_reserve = 0;
+  double t_pool = pool_pass(&pools[0], &ws, xs, &t_reserve, &sink);
+  ret = pp_rotate(&pools[0], next.path0, path0);
+  assert(ret == 0);
+  ret = pp_rotate(&pools[1], next.path1, path1);
+  assert(ret == 0);
+  check_records(pools, xs);
+  t_pool += pool_pass(&pools[0], &ws, xs, &t_reserve, &sink);
+  t_pool /= 2 * kRecordNum;
+
+  printf("kind,query_us\n");
+  printf("fixed,%lf\n", t_fixed * 1e6);
+  printf("pool,%lf\n", t_pool * 1e6);
+  printf("Reserve (ns/record): %lf\n", t_reserve / (2 * kRecordNum) * 1e9);
+
+  pp_close(&pools[0]);
+  pp_close(&pools[1]);
+  // Once per pass, and the 2nd has left its file behind
+  assert(next.num == 2);
+  printf("Refill deal (ms): %lf\n", next.t / next.num * 1e3);
+  printf("Sink: %llu\n", (unsigned long long)sink);
+
+  ws_close(&ws);
+  prg_free();
+  free(xs);
+  remove(path0);
+  remove(path1);
+  remove(next.path0);
+  remove(next.path1);
+  return 0;
+}
@@ -0,0 +1,189 @@
+// SPDX-License-Identifier: Apache-2.0
+
+// For syscall()
+#define _GNU_SOURCE
+
+#include "perf.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+
+#ifdef __linux__
+  #include <errno.h>
+  #include <unistd.h>
+  #include <sys/ioctl.h>
+  #include <sys/syscall.h>
+  #include <linux/perf_event.h>
+
+static const char *kPerfEventNames[kPerfEventNum] = {
+  "cycles",
+  "instructions",
+  "L1d misses",
+  "LLC misses",
+  "branch misses",
+};
+
+static void perf_event_attr_init(struct perf_event_attr *attr, enum PerfEvent e) {
+  memset(attr, 0, sizeof(*attr));
+  attr->size = sizeof(*attr);
+  attr->disabled = 1;
+  // Count user space only so that perf_event_paranoid <= 2 suffices
+  attr->exclude_kernel = 1;
+  attr->exclude_hv = 1;
+  attr->read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  switch (e) {
+    case kPerfCycles:
+      attr->type = PERF_TYPE_HARDWARE;
+      attr->config = PERF_COUNT_HW_CPU_CYCLES;
+      break;
+    case kPerfInstructions:
+      attr->type = PERF_TYPE_HARDWARE;
+      attr->config = PERF_COUNT_HW_INSTRUCTIONS;
+      break;
+    case kPerfL1dMisses:
+      attr->type = PERF_TYPE_HW_CACHE;
+      attr->config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+        (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+      break;
+    case kPerfLlcMisses:
+      attr->type = PERF_TYPE_HARDWARE;
+      attr->config = PERF_COUNT_HW_CACHE_MISSES;
+      break;
+    case kPerfBranchMisses:
+      attr->type = PERF_TYPE_HARDWARE;
+      attr->config = PERF_COUNT_HW_BRANCH_MISSES;
+      break;
+    default: break;
+  }
+}
+
+void perf_open(PerfCounters *pc) {
+  pc->fds = NULL;
+  pc->thread_num = 0;
+  pc->enabled = 0;
+  const char *env = getenv("FSS_PERF");
+  if (env == NULL || strcmp(env, "0") == 0) return;
+
+  pc->thread_num = omp_get_max_threads();
+  pc->fds = (int *)malloc(sizeof(int) * pc->thread_num * kPerfEventNum);
+  if (pc->fds == NULL) return;
+  int opened = 0;
+  int err = 0;
+  // pid = 0 and cpu = -1 counts the calling thread on any CPU, so open in the threads to be measured
+#pragma omp parallel reduction(+ : opened) reduction(max : err)
+  {
+    int tid = omp_get_thread_num();
+    for (int e = 0; e < kPerfEventNum; e++) {
+      struct perf_event_attr attr;
+      perf_event_attr_init(&attr, (enum PerfEvent)e);
+      int fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+      pc->fds[tid * kPerfEventNum + e] = fd;
+      if (fd >= 0) opened++;
+      else err = errno;
+    }
+  }
+  if (opened == 0) {
+    printf("Perf counters unavailable: %s\n", strerror(err));
+    return;
+  }
+  pc->enabled = 1;
+}
+
+static void perf_ioctl_all(PerfCounters *pc, unsigned long req) {
+  if (!pc->enabled) return;
+  for (int i = 0; i < pc->thread_num * kPerfEventNum; i++) {
+    if (pc->fds[i] >= 0) ioctl(pc->fds[i], req, 0);
+  }
+}
+
+void perf_reset(PerfCounters *pc) {
+  perf_ioctl_all(pc, PERF_EVENT_IOC_RESET);
+}
+
+void perf_start(PerfCounters *pc) {
+  perf_ioctl_all(pc, PERF_EVENT_IOC_ENABLE);
+}
+
+void perf_stop(PerfCounters *pc) {
+  perf_ioctl_all(pc, PERF_EVENT_IOC_DISABLE);
+}
+
+// Return -1 if no thread has the event
+static double perf_read_sum(const PerfCounters *pc, enum PerfEvent e) {
+  double sum = 0;
+  int found = 0;
+  for (int tid = 0; tid < pc->thread_num; tid++) {
+    int fd = pc->fds[tid * kPerfEventNum + e];
+    if (fd < 0) continue;
+    // value, time_enabled, time_running
+    uint64_t buf[3];
+    if (read(fd, buf, sizeof(buf)) != sizeof(buf)) continue;
+    found = 1;
+    // Scale when the PMU is multiplexed
+    if (buf[2] > 0 && buf[2] < buf[1]) sum += (double)buf[0] * buf[1] / buf[2];
+    else sum += (double)buf[0];
+  }
+  return found ? sum : -1;
+}
+
+void perf_report(const PerfCounters *pc, const char *name, double ops) {
+  if (!pc->enabled) return;
+  double vals[kPerfEventNum];
+  for (int e = 0; e < kPerfEventNum; e++) {
+    vals[e] = perf_read_sum(pc, (enum PerfEvent)e);
+  }
+  printf("%s perf (per op):", name);
+  for (int e = 0; e < kPerfEventNum; e++) {
+    if (vals[e] < 0) printf(" %s n/a,", kPerfEventNames[e]);
+    else printf(" %s %.2lf,", kPerfEventNames[e], vals[e] / ops);
+  }
+  if (vals[kPerfCycles] > 0 && vals[kPerfInstructions] >= 0) {
+    printf(" IPC %.2lf\n", vals[kPerfInstructions] / vals[kPerfCycles]);
+  } else {
+    printf(" IPC n/a\n");
+  }
+}
+
+void perf_close(PerfCounters *pc) {
+  if (pc->fds != NULL) {
+    for (int i = 0; i < pc->thread_num * kPerfEventNum; i++) {
+      if (pc->fds[i] >= 0) close(pc->fds[i]);
+    }
+  }
+  free(pc->fds);
+  pc->fds = NULL;
+  pc->enabled = 0;
+}
+
+#else
+
+void perf_open(PerfCounters *pc) {
+  pc->fds = NULL;
+  pc->thread_num = 0;
+  pc->enabled = 0;
+}
+
+void perf_reset(PerfCounters *pc) {
+  (void)pc;
+}
+
+void perf_start(PerfCounters *pc) {
+  (void)pc;
+}
+
+void perf_stop(PerfCounters *pc) {
+  (void)pc;
+}
+
+void perf_report(const PerfCounters *pc, const char *name, double ops) {
+  (void)pc;
+  (void)name;
+  (void)ops;
+}
+
+void perf_close(PerfCounters *pc) {
+  (void)pc;
+}
+
+#endif
@@ -0,0 +1,60 @@
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @file perf.h
+ *
+ * Hardware performance counters for benchmarks via Linux `perf_event_open`.
+ * Counters are opened per OpenMP thread and summed when reported.
+ * They are only opened when env `FSS_PERF` is set and not `0`.
+ * When perf is unavailable (non-Linux, `perf_event_paranoid`, VMs without PMU), all functions are no-ops.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+enum PerfEvent {
+  kPerfCycles,
+  kPerfInstructions,
+  kPerfL1dMisses,
+  kPerfLlcMisses,
+  kPerfBranchMisses,
+  kPerfEventNum,
+};
+
+typedef struct {
+  /**
+   * Len = `thread_num` * @ref kPerfEventNum. -1 for events that cannot be opened.
+   */
+  int *fds;
+  int thread_num;
+  /**
+   * 0 if disabled by env or no event can be opened
+   */
+  int enabled;
+} PerfCounters;
+
+/**
+ * Open counters for each thread of the following OpenMP parallel regions.
+ * Counters are opened disabled.
+ */
+void perf_open(PerfCounters *pc);
+
+/**
+ * Reset counts of all threads to 0
+ */
+void perf_reset(PerfCounters *pc);
+
+/**
+ * Start counting. Counts accumulate across start/stop pairs until @ref perf_reset().
+ */
+void perf_start(PerfCounters *pc);
+
+void perf_stop(PerfCounters *pc);
+
+/**
+ * Print counts summed over threads and divided by `ops`
+ */
+void perf_report(const PerfCounters *pc, const char *name, double ops);
+
+void perf_close(PerfCounters *pc);
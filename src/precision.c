@@ -0,0 +1,395 @@
+// SPDX-License-Identifier: Apache-2.0
+
+// For real-time extensions
+#define _POSIX_C_SOURCE 199309L
+
+// Accuracy/performance sweep of the score bitlen of retrieval. See fixed.h.
+// Per bitlen, each query scores random unit-vector docs with fixed-point shares, then finds its top k' docs by a binary search
+// of the threshold with 1 IC key per step, and opens the docs above the threshold. Both parties run in this process.
+// Recall is against the top k' by float scores. Time is party 0's per query and k': scoring, base eval, search steps and result rounds.
+// Usage: precision_sweep [out_dir] [n] [queries] [dim]
+// Writes <out_dir>/recall_bitlen.csv, whose columns are those of accuracy/recall.csv plus bitlen,
+// and <out_dir>/time_bitlen.csv, whose columns are those of performance/akprag.csv plus bitlen and steps.
+
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <math.h>
+#include <omp.h>
+#include <fss/dcf.h>
+#include <fss/ic.h>
+#include <fss/group.h>
+#include "fixed.h"
+#include "rand.h"
+#include "workspace.h"
+
+#define kSeed 114514
+#define kPi 3.14159265358979323846
+
+static const int kBitlens[] = {16, 20, 24, 28, 32, 36, 40, 48};
+static const int kKs[] = {16, 32, 64, 128};
+
+#define kLen(a) ((int)(sizeof(a) / sizeof((a)[0])))
+
+static inline double get_time() {
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1.0e-9;
+}
+
+static Rng gRng;
+
+// Uniform in (0, 1]
+static double rand_unit() {
+  return ((rng_u64(&gRng) >> 11) + 1) * 0x1.0p-53;
+}
+
+// Normalized Gaussian vector, i.e., uniform on the sphere
+static void rand_unit_vector(float *v, int dim) {
+  double norm = 0;
+  for (int i = 0; i < dim; i++) {
+    double g = sqrt(-2 * log(rand_unit())) * cos(2 * kPi * rand_unit());
+    v[i] = (float)g;
+    norm += g * g;
+  }
+  norm = sqrt(norm);
+  for (int i = 0; i < dim; i++) {
+    v[i] = (float)(v[i] / norm);
+  }
+}
+
+static const double *gSortScores;
+
+// Descending by score
+static int cmp_score_desc(const void *a, const void *b) {
+  double x = gSortScores[*(const int *)a], y = gSortScores[*(const int *)b];
+  return (x < y) - (x > y);
+}
+
+static uint64_t group_open(const uint8_t *y0, const uint8_t *y1) {
+  uint8_t y[kLambda];
+  memcpy(y, y0, kLambda);
+  group_add(y, y1);
+  uint64_t v;
+  memcpy(&v, y, sizeof(v));
+  return v;
+}
+
+// Additive shares of group element `v`
+static void group_share(uint8_t shares[2][kLambda], const uint8_t *v) {
+  group_zero(shares[0]);
+  uint64_t v0 = rng_field(&gRng);
+  memcpy(shares[0], &v0, sizeof(v0));
+  memcpy(shares[1], shares[0], kLambda);
+  group_neg(shares[1]);
+  group_add(shares[1], v);
+}
+
+typedef struct {
+  int n;
+  int bitlen;
+  // Opened masked scores
+  const uint64_t *xs;
+  Workspace *ws;
+} Round;
+
+static void eval_base(const Round *rd, uint8_t *ys_base, uint8_t b, Key k, const uint8_t *s_b) {
+#pragma omp parallel for
+  for (int j = 0; j < rd->n; j++) {
+    uint8_t *sbuf = ws_get(rd->ws, omp_get_thread_num());
+    Bits x = {(uint8_t *)&rd->xs[j], rd->bitlen};
+    memcpy(sbuf, s_b, kLambda);
+    ic_eval_base(sbuf, b, k, x);
+    memcpy(ys_base + (size_t)j * kLambda, sbuf, kLambda);
+  }
+}
+
+// Party b's share of the count of docs >= the threshold of `k`, and of each doc's comparison into `ys` if not NULL
+static void eval_ge(const Round *rd, uint8_t *count, uint8_t *ys, uint8_t b, Key k, const uint8_t *s_b, const uint8_t *w_b,
+  const uint8_t *ys_base) {
+  group_zero(count);
+#pragma omp parallel
+  {
+    uint8_t *sbuf = ws_get(rd->ws, omp_get_thread_num());
+    uint8_t local_count[kLambda];
+    group_zero(local_count);
+#pragma omp for
+    for (int j = 0; j < rd->n; j++) {
+      Bits x = {(uint8_t *)&rd->xs[j], rd->bitlen};
+      memcpy(sbuf, s_b, kLambda);
+      ic_eval_ge(sbuf, b, k, x, ys_base + (size_t)j * kLambda, w_b);
+      group_add(local_count, sbuf);
+      if (ys != NULL) memcpy(ys + (size_t)j * kLambda, sbuf, kLambda);
+    }
+#pragma omp critical
+    group_add(count, local_count);
+  }
+}
+
+// Dealer: key of [x >= c] with both parties' seeds and shares of w
+static void deal_ge(Key k, uint8_t s[2 * kLambda], uint8_t w_shares[2][kLambda], uint64_t r, uint64_t c, int bitlen) {
+  uint8_t sbuf[kLambda * 10];
+  rng_fill_bytes(&gRng, sbuf, 2 * kLambda);
+  memcpy(s, sbuf, 2 * kLambda);
+  uint8_t w[kLambda];
+  ic_gen_ge(k, w, r, c, 1ULL << bitlen, bitlen, sbuf);
+  group_share(w_shares, w);
+}
+
+int main(int argc, char **argv) {
+  const char *out_dir = argc > 1 ? argv[1] : ".";
+  int n = argc > 2 ? atoi(argv[2]) : 1024;
+  int query_num = argc > 3 ? atoi(argv[3]) : 8;
+  int dim = argc > 4 ? atoi(argv[4]) : 128;
+  assert(n >= kKs[kLen(kKs) - 1] && query_num > 0 && dim > 0);
+
+  uint64_t seed[2] = {kSeed, 0};
+  rng_init(&gRng, (uint8_t *)seed, 0);
+  uint8_t keys[4 * kLambda];
+  rng_fill_bytes(&gRng, keys, sizeof(keys));
+  prg_init(keys, sizeof(keys));
+
+  printf("Score Precision Sweep\n");
+  printf("OpenMP thread num: %d\n", omp_get_max_threads());
+  printf("PRG kernel: %s\n", prg_name());
+  printf("N (Docs): %d, queries: %d, dim: %d\n", n, query_num, dim);
+
+  char path[4096];
+  snprintf(path, sizeof(path), "%s/recall_bitlen.csv", out_dir);
+  FILE *f_recall = fopen(path, "w");
+  snprintf(path, sizeof(path), "%s/time_bitlen.csv", out_dir);
+  FILE *f_time = fopen(path, "w");
+  if (f_recall == NULL || f_time == NULL) {
+    perror("Open CSV failed");
+    return 1;
+  }
+  fprintf(f_recall, "query_id,k,recall,bitlen\n");
+  fprintf(f_time, "n_pow2,k_pow2,time_ms,bitlen,steps\n");
+  int n_pow2 = 0;
+  while ((2 << n_pow2) <= n) n_pow2++;
+
+  // Plaintext docs and queries, and the true top docs by float scores
+  float *docs = (float *)malloc(sizeof(float) * n * dim);
+  float *queries = (float *)malloc(sizeof(float) * query_num * dim);
+  double *scores = (double *)malloc(sizeof(double) * n);
+  int *top = (int *)malloc(sizeof(int) * query_num * n);
+  assert(docs != NULL && queries != NULL && scores != NULL && top != NULL);
+  for (int j = 0; j < n; j++) {
+    rand_unit_vector(docs + (size_t)j * dim, dim);
+  }
+  for (int q = 0; q < query_num; q++) {
+    rand_unit_vector(queries + (size_t)q * dim, dim);
+    for (int j = 0; j < n; j++) {
+      double s = 0;
+      for (int i = 0; i < dim; i++) {
+        s += (double)queries[(size_t)q * dim + i] * docs[(size_t)j * dim + i];
+      }
+      scores[j] = s;
+      top[(size_t)q * n + j] = j;
+    }
+    gSortScores = scores;
+    qsort(top + (size_t)q * n, n, sizeof(int), cmp_score_desc);
+  }
+
+  // Quantized values, triple shares and opened values. Doc rows are `dim` contiguous.
+  uint64_t *doc_q = (uint64_t *)malloc(sizeof(uint64_t) * n * dim);
+  uint64_t *query_q = (uint64_t *)malloc(sizeof(uint64_t) * dim);
+  uint64_t *x_s[2], *y_s[2], *z_s[2], *score_s[2];
+  for (int b = 0; b < 2; b++) {
+    x_s[b] = (uint64_t *)malloc(sizeof(uint64_t) * dim);
+    y_s[b] = (uint64_t *)malloc(sizeof(uint64_t) * n * dim);
+    z_s[b] = (uint64_t *)malloc(sizeof(uint64_t) * n);
+    score_s[b] = (uint64_t *)malloc(sizeof(uint64_t) * n);
+    assert(x_s[b] != NULL && y_s[b] != NULL && z_s[b] != NULL && score_s[b] != NULL);
+  }
+  uint64_t *e = (uint64_t *)malloc(sizeof(uint64_t) * dim);
+  uint64_t *f = (uint64_t *)malloc(sizeof(uint64_t) * n * dim);
+  uint64_t *xs = (uint64_t *)malloc(sizeof(uint64_t) * n);
+  assert(doc_q != NULL && query_q != NULL && e != NULL && f != NULL && xs != NULL);
+
+  // Per party: base evals, and per-doc comparisons of the 2 result rounds
+  uint8_t *ys_base[2], *ys_above[2], *ys_at[2];
+  for (int b = 0; b < 2; b++) {
+    ys_base[b] = (uint8_t *)malloc(kLambda * (size_t)n);
+    ys_above[b] = (uint8_t *)malloc(kLambda * (size_t)n);
+    ys_at[b] = (uint8_t *)malloc(kLambda * (size_t)n);
+    assert(ys_base[b] != NULL && ys_above[b] != NULL && ys_at[b] != NULL);
+  }
+  uint8_t *selected = (uint8_t *)malloc(n);
+  assert(selected != NULL);
+
+  Key key_base, key_ge;
+  key_base.cw_np1 = (uint8_t *)malloc(kLambda);
+  key_base.cws = (uint8_t *)malloc(kDcfCwLen * kFixedMaxBitlen);
+  key_ge.cw_np1 = (uint8_t *)malloc(kLambda);
+  key_ge.cws = (uint8_t *)malloc(kDcfCwLen * kFixedMaxBitlen);
+  Workspace ws;
+  ws_open(&ws, kLambda * 10);
+
+  printf("bitlen,k,recall,time_ms\n");
+  for (int bi = 0; bi < kLen(kBitlens); bi++) {
+    int bitlen = kBitlens[bi];
+    uint64_t mask = fixed_mask(bitlen);
+    for (int j = 0; j < n; j++) {
+      fixed_quantize(doc_q + (size_t)j * dim, docs + (size_t)j * dim, dim, bitlen);
+    }
+    double recall_sums[kLen(kKs)] = {0}, time_sums[kLen(kKs)] = {0};
+
+    for (int q = 0; q < query_num; q++) {
+      fixed_quantize(query_q, queries + (size_t)q * dim, dim, bitlen);
+
+      // Dealer: triples over Z_2^64, where only the shares are kept, and the opened e and f
+      for (int i = 0; i < dim; i++) {
+        x_s[0][i] = rng_u64(&gRng);
+        x_s[1][i] = rng_u64(&gRng);
+        e[i] = query_q[i] - x_s[0][i] - x_s[1][i];
+      }
+      for (int j = 0; j < n; j++) {
+        uint64_t z = 0;
+        for (int i = 0; i < dim; i++) {
+          size_t idx = (size_t)j * dim + i;
+          y_s[0][idx] = rng_u64(&gRng);
+          y_s[1][idx] = rng_u64(&gRng);
+          z += (x_s[0][i] + x_s[1][i]) * (y_s[0][idx] + y_s[1][idx]);
+          f[idx] = doc_q[idx] - y_s[0][idx] - y_s[1][idx];
+        }
+        z_s[0][j] = rng_u64(&gRng);
+        z_s[1][j] = z - z_s[0][j];
+      }
+
+      // Scoring
+      double t_score = 0;
+      for (int b = 0; b < 2; b++) {
+        double t = get_time();
+#pragma omp parallel for
+        for (int j = 0; j < n; j++) {
+          score_s[b][j] = fixed_dot_share(
+            b, e, f + (size_t)j * dim, x_s[b], y_s[b] + (size_t)j * dim, z_s[b][j], dim, bitlen);
+        }
+        if (b == 0) t_score = get_time() - t;
+      }
+
+      // Masked open with the dealer's shares of r
+      uint64_t r = rng_u64(&gRng) & mask;
+      uint64_t r0 = rng_u64(&gRng) & mask;
+      uint64_t r1 = (r - r0) & mask;
+      for (int j = 0; j < n; j++) {
+        xs[j] = (score_s[0][j] + r0 + score_s[1][j] + r1) & mask;
+        // The opened score is exact, as the quantized score fits
+        uint64_t plain = 1ULL << (bitlen - 1);
+        for (int i = 0; i < dim; i++) {
+          plain += query_q[i] * doc_q[(size_t)j * dim + i];
+        }
+        assert(((xs[j] - r) & mask) == (plain & mask));
+      }
+      Round rd = {n, bitlen, xs, &ws};
+
+      // Base key of the mask, evaluated once per query
+      uint8_t s_base[kLambda * 10];
+      rng_fill_bytes(&gRng, s_base, 2 * kLambda);
+      uint8_t s_base_parties[2 * kLambda];
+      memcpy(s_base_parties, s_base, 2 * kLambda);
+      Bits r_bits = {(uint8_t *)&r, bitlen};
+      ic_gen_base(key_base, r_bits, s_base);
+      double t = get_time();
+      eval_base(&rd, ys_base[0], 0, key_base, s_base_parties);
+      double t_base = get_time() - t;
+      eval_base(&rd, ys_base[1], 1, key_base, s_base_parties + kLambda);
+
+      for (int ki = 0; ki < kLen(kKs); ki++) {
+        int k = kKs[ki];
+        uint8_t s[2 * kLambda], w_shares[2][kLambda], counts[2][kLambda];
+        double t_eval = 0;
+
+        // Largest threshold c in [lo, hi] with count of [x >= c] >= k, where the count at 0 is n
+        uint64_t lo = 0, hi = mask;
+        int steps = 0;
+        while (lo < hi) {
+          uint64_t mid = lo + (hi - lo) / 2 + 1;
+          deal_ge(key_ge, s, w_shares, r, mid, bitlen);
+          for (int b = 0; b < 2; b++) {
+            t = get_time();
+            eval_ge(&rd, counts[b], NULL, b, key_ge, s + b * kLambda, w_shares[b], ys_base[b]);
+            if (b == 0) t_eval += get_time() - t;
+          }
+          steps++;
+          if (group_open(counts[0], counts[1]) >= (uint64_t)k) {
+            lo = mid;
+          } else {
+            hi = mid - 1;
+          }
+        }
+
+        // Result: docs above lo, then ties at lo by index
+        memset(selected, 0, n);
+        int selected_num = 0;
+        for (int round = 0; round < 2; round++) {
+          uint64_t c = round == 0 ? lo + 1 : lo;
+          if (round == 0 && lo == mask) continue;
+          uint8_t **ys = round == 0 ? ys_above : ys_at;
+          deal_ge(key_ge, s, w_shares, r, c, bitlen);
+          for (int b = 0; b < 2; b++) {
+            t = get_time();
+            eval_ge(&rd, counts[b], ys[b], b, key_ge, s + b * kLambda, w_shares[b], ys_base[b]);
+            if (b == 0) t_eval += get_time() - t;
+          }
+          for (int j = 0; j < n && selected_num < k; j++) {
+            if (!selected[j] && group_open(ys[0] + (size_t)j * kLambda, ys[1] + (size_t)j * kLambda) == 1) {
+              selected[j] = 1;
+              selected_num++;
+            }
+          }
+        }
+        assert(selected_num == k);
+
+        int hit = 0;
+        for (int i = 0; i < k; i++) {
+          hit += selected[top[(size_t)q * n + i]];
+        }
+        double recall = (double)hit / k;
+        double time_ms = (t_score + t_base + t_eval) * 1e3;
+        int k_pow2 = 0;
+        while ((2 << k_pow2) <= k) k_pow2++;
+        fprintf(f_recall, "%d,%d,%lf,%d\n", q, k, recall, bitlen);
+        fprintf(f_time, "%d,%d,%lf,%d,%d\n", n_pow2, k_pow2, time_ms, bitlen, steps);
+        recall_sums[ki] += recall;
+        time_sums[ki] += time_ms;
+      }
+    }
+    for (int ki = 0; ki < kLen(kKs); ki++) {
+      printf("%d,%d,%lf,%lf\n", bitlen, kKs[ki], recall_sums[ki] / query_num, time_sums[ki] / query_num);
+    }
+    fflush(stdout);
+  }
+
+  fclose(f_recall);
+  fclose(f_time);
+  prg_free();
+  ws_close(&ws);
+  free(key_base.cw_np1);
+  free(key_base.cws);
+  free(key_ge.cw_np1);
+  free(key_ge.cws);
+  for (int b = 0; b < 2; b++) {
+    free(x_s[b]);
+    free(y_s[b]);
+    free(z_s[b]);
+    free(score_s[b]);
+    free(ys_base[b]);
+    free(ys_above[b]);
+    free(ys_at[b]);
+  }
+  free(selected);
+  free(docs);
+  free(queries);
+  free(scores);
+  free(top);
+  free(doc_q);
+  free(query_q);
+  free(e);
+  free(f);
+  free(xs);
+  return 0;
+}
@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: Apache-2.0
+
+#include "preproc.h"
+#include "rand.h"
+
+#define kChunkLen 256
+
+typedef unsigned __int128 uint128_t;
+
+enum { kStreamX, kStreamY, kStreamZ };
+// Streams of the Z_2^64 triples are after those of the field ones, so 1 seed can back both
+#define kStreamRing 3
+
+const char *preproc_kernel_name() {
+  return rng_kernel_name();
+}
+
+// Elements [offset, offset + n) of a stream, where element i is word i % 2 of block i / 2, reduced mod p if `reduce`
+static void expand_stream(uint64_t *out, const uint8_t *seed, int stream, size_t offset, size_t n, int reduce) {
+  uint64_t tmp[2];
+  size_t i = 0;
+  if (offset % 2) {
+    rng_keystream((uint8_t *)tmp, seed, stream, offset / 2, 1, reduce);
+    out[0] = tmp[1];
+    i = 1;
+  }
+  size_t block_num = (n - i) / 2;
+  rng_keystream((uint8_t *)(out + i), seed, stream, (offset + i) / 2, block_num, reduce);
+  i += block_num * 2;
+  if (i < n) {
+    rng_keystream((uint8_t *)tmp, seed, stream, (offset + i) / 2, 1, reduce);
+    out[i] = tmp[0];
+  }
+}
+
+static void expand(uint64_t *x0, uint64_t *y0, uint64_t *z0, const uint8_t *seed, size_t offset, size_t n, int ring) {
+  if (n == 0) return;
+  int stream = ring ? kStreamRing : 0;
+  if (x0) expand_stream(x0, seed, stream + kStreamX, offset, n, !ring);
+  if (y0) expand_stream(y0, seed, stream + kStreamY, offset, n, !ring);
+  if (z0) expand_stream(z0, seed, stream + kStreamZ, offset, n, !ring);
+}
+
+void preproc_expand(uint64_t *x0, uint64_t *y0, uint64_t *z0, const uint8_t *seed, size_t offset, size_t n) {
+  expand(x0, y0, z0, seed, offset, n, 0);
+}
+
+void preproc_expand_ring(uint64_t *x0, uint64_t *y0, uint64_t *z0, const uint8_t *seed, size_t offset, size_t n) {
+  expand(x0, y0, z0, seed, offset, n, 1);
+}
+
+static inline uint64_t sub_mod_p(uint64_t a, uint64_t b) {
+  return a >= b ? a - b : a + (kPreprocPrime - b);
+}
+
+static inline uint64_t mul_mod_p(uint64_t a, uint64_t b) {
+  return (uint64_t)(((uint128_t)a * b) % kPreprocPrime);
+}
+
+static void deal(uint64_t *x1, uint64_t *y1, uint64_t *z1, const uint8_t *seed, const uint8_t *seed_xy, size_t offset,
+  size_t n, int ring) {
+  if (n == 0) return;
+  expand(x1, y1, NULL, seed_xy, offset, n, ring);
+  for (size_t i = 0; i < n; i++) {
+    z1[i] = ring ? x1[i] * y1[i] : mul_mod_p(x1[i], y1[i]);
+  }
+
+  uint64_t x0[kChunkLen], y0[kChunkLen], z0[kChunkLen];
+  for (size_t i = 0; i < n; i += kChunkLen) {
+    size_t m = n - i < kChunkLen ? n - i : kChunkLen;
+    expand(x0, y0, z0, seed, offset + i, m, ring);
+    if (ring) {
+      // Z_2^64 wraps by itself
+      for (size_t j = 0; j < m; j++) {
+        x1[i + j] -= x0[j];
+        y1[i + j] -= y0[j];
+        z1[i + j] -= z0[j];
+      }
+      continue;
+    }
+    for (size_t j = 0; j < m; j++) {
+      x1[i + j] = sub_mod_p(x1[i + j], x0[j]);
+      y1[i + j] = sub_mod_p(y1[i + j], y0[j]);
+      z1[i + j] = sub_mod_p(z1[i + j], z0[j]);
+    }
+  }
+}
+
+void preproc_deal(uint64_t *x1, uint64_t *y1, uint64_t *z1, const uint8_t *seed, const uint8_t *seed_xy, size_t offset,
+  size_t n) {
+  deal(x1, y1, z1, seed, seed_xy, offset, n, 0);
+}
+
+void preproc_deal_ring(uint64_t *x1, uint64_t *y1, uint64_t *z1, const uint8_t *seed, const uint8_t *seed_xy,
+  size_t offset, size_t n) {
+  deal(x1, y1, z1, seed, seed_xy, offset, n, 1);
+}
@@ -0,0 +1,56 @@
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @file preproc.h
+ *
+ * Seed-compressed Beaver triples over the prime field of the dot product, i.e., mod @ref kPreprocPrime.
+ * Party 0's shares of x, y and z are expanded on demand from a @ref kPreprocSeedLen bytes seed with AES-128-CTR,
+ * i.e., streams 0, 1 and 2 of @ref rng_keystream(),
+ * and only party 1 gets explicit arrays, the corrections x - x_0, y - y_0 and x * y - z_0.
+ * The dealer then stores and sends 3 field elements per triple instead of 6.
+ *
+ * Each of x_0, y_0 and z_0 is a stream of field elements indexed from 0, e.g., doc `j` of dim `n` uses `[j * n, (j + 1) * n)`.
+ * An element is the reduction of a 64-bit word of the keystream, whose bias is 59 / 2^64.
+ *
+ * The `_ring` variants are the same triples over Z_2^64 instead, e.g., for the fixed-point scores of fixed.h,
+ * where an element is a 64-bit word as is, of streams 3, 4 and 5 so that 1 seed can back both.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "rand.h"
+
+#define kPreprocPrime kRngFieldPrime
+#define kPreprocSeedLen kRngSeedLen
+
+/**
+ * Name of the expansion kernel, that of @ref rng_kernel_name(). All kernels output the same stream.
+ */
+const char *preproc_kernel_name();
+
+/**
+ * Expand elements `[offset, offset + n)` of party 0's x, y and z shares.
+ * Any of `x0`, `y0` and `z0` can be NULL to skip it.
+ */
+void preproc_expand(uint64_t *x0, uint64_t *y0, uint64_t *z0, const uint8_t *seed, size_t offset, size_t n);
+
+/**
+ * Dealer: output party 1's corrections for elements `[offset, offset + n)`.
+ * @param seed Party 0's seed
+ * @param seed_xy Dealer's private seed that x and y are expanded from
+ */
+void preproc_deal(uint64_t *x1, uint64_t *y1, uint64_t *z1, const uint8_t *seed, const uint8_t *seed_xy, size_t offset,
+  size_t n);
+
+/**
+ * @ref preproc_expand() of the triples over Z_2^64
+ */
+void preproc_expand_ring(uint64_t *x0, uint64_t *y0, uint64_t *z0, const uint8_t *seed, size_t offset, size_t n);
+
+/**
+ * @ref preproc_deal() of the triples over Z_2^64
+ */
+void preproc_deal_ring(uint64_t *x1, uint64_t *y1, uint64_t *z1, const uint8_t *seed, const uint8_t *seed_xy,
+  size_t offset, size_t n);
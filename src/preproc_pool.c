@@ -0,0 +1,229 @@
+// SPDX-License-Identifier: Apache-2.0
+
+// For MAP_SHARED and madvise()
+#define _GNU_SOURCE
+
+#include "preproc_pool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <omp.h>
+
+// Offsets in a record
+static inline size_t cws_off() {
+  return kLambda * 2;
+}
+
+static inline size_t mask_off(int bitlen) {
+  return (cws_off() + (size_t)kDcfCwLen * bitlen + 7) / 8 * 8;
+}
+
+static inline size_t triples_off(int bitlen) {
+  return mask_off(bitlen) + 8;
+}
+
+size_t pp_record_len(int party, int bitlen, int dim) {
+  size_t triples_len = party == 0 ? kPreprocSeedLen : 3 * (size_t)dim * sizeof(uint64_t);
+  return (triples_off(bitlen) + triples_len + 63) / 64 * 64;
+}
+
+static uint8_t *map_new(const char *path, size_t len) {
+  int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+  if (fd < 0) {
+    perror("Preproc pool open failed");
+    return NULL;
+  }
+  if (ftruncate(fd, len) != 0) {
+    perror("Preproc pool truncate failed");
+    close(fd);
+    return NULL;
+  }
+  void *p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (p == MAP_FAILED) {
+    perror("Preproc pool mmap failed");
+    return NULL;
+  }
+  return (uint8_t *)p;
+}
+
+int pp_deal(const char *path0, const char *path1, int bitlen, int dim, uint64_t record_num) {
+  uint8_t *maps[2];
+  size_t map_lens[2];
+  for (int b = 0; b < 2; b++) {
+    size_t record_len = pp_record_len(b, bitlen, dim);
+    map_lens[b] = kPpHeaderLen + record_len * record_num;
+    maps[b] = map_new(b == 0 ? path0 : path1, map_lens[b]);
+    if (maps[b] == NULL) {
+      if (b == 1) munmap(maps[0], map_lens[0]);
+      return -1;
+    }
+    PpHeader hdr = {{0}, kLambda, b, bitlen, dim, record_num, record_len};
+    memcpy(hdr.magic, kPpMagic, sizeof(hdr.magic));
+    memcpy(maps[b], &hdr, sizeof(hdr));
+  }
+
+  uint8_t beta[kLambda];
+  group_zero(beta);
+  beta[0] = 1;
+  // 1 OS seed, and each thread its own stream of it
+  Rng os_rng;
+  rng_init(&os_rng, NULL, 0);
+#pragma omp parallel
+  {
+    Rng rng;
+    rng_init(&rng, os_rng.seed, omp_get_thread_num());
+#pragma omp for
+    for (uint64_t i = 0; i < record_num; i++) {
+      uint8_t *rec0 = maps[0] + kPpHeaderLen + pp_record_len(0, bitlen, dim) * i;
+      uint8_t *rec1 = maps[1] + kPpHeaderLen + pp_record_len(1, bitlen, dim) * i;
+
+      uint64_t r = rng_field(&rng);
+      if (bitlen < 64) r &= (1ULL << bitlen) - 1;
+      Bits r_bits = {(uint8_t *)&r, bitlen};
+      CmpFunc cf = {{r_bits, beta}, kLtAlpha};
+      uint8_t sbuf[kLambda * 10];
+      rng_fill_bytes(&rng, sbuf, kLambda * 2);
+      memcpy(rec0, sbuf, kLambda);
+      memcpy(rec1, sbuf + kLambda, kLambda);
+      Key k = {rec0 + cws_off(), rec0 + kLambda};
+      dcf_gen(k, cf, sbuf);
+      memcpy(rec1 + kLambda, rec0 + kLambda, kLambda + (size_t)kDcfCwLen * bitlen);
+
+      uint64_t r0 = rng_field(&rng);
+      uint64_t r1 = r >= r0 ? r - r0 : r + (kPreprocPrime - r0);
+      memcpy(rec0 + mask_off(bitlen), &r0, 8);
+      memcpy(rec1 + mask_off(bitlen), &r1, 8);
+
+      uint8_t seed_xy[kPreprocSeedLen];
+      rng_fill_bytes(&rng, rec0 + triples_off(bitlen), kPreprocSeedLen);
+      rng_fill_bytes(&rng, seed_xy, kPreprocSeedLen);
+      uint64_t *x1 = (uint64_t *)(rec1 + triples_off(bitlen));
+      preproc_deal(x1, x1 + dim, x1 + 2 * dim, rec0 + triples_off(bitlen), seed_xy, 0, dim);
+    }
+  }
+
+  munmap(maps[0], map_lens[0]);
+  munmap(maps[1], map_lens[1]);
+  return 0;
+}
+
+int pp_open(PreprocPool *pool, const char *path) {
+  memset(pool, 0, sizeof(*pool));
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    perror("Preproc pool open failed");
+    return -1;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < kPpHeaderLen) {
+    fprintf(stderr, "Preproc pool %s too short\n", path);
+    close(fd);
+    return -1;
+  }
+  void *p = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (p == MAP_FAILED) {
+    perror("Preproc pool mmap failed");
+    return -1;
+  }
+  pool->base = (const uint8_t *)p;
+  pool->map_len = st.st_size;
+  memcpy(&pool->hdr, p, sizeof(pool->hdr));
+
+  const PpHeader *hdr = &pool->hdr;
+  if (memcmp(hdr->magic, kPpMagic, sizeof(hdr->magic)) != 0 || hdr->lambda != kLambda || hdr->party > 1 ||
+      hdr->record_len != pp_record_len(hdr->party, hdr->bitlen, hdr->dim) ||
+      pool->map_len < kPpHeaderLen + hdr->record_len * hdr->record_num) {
+    fprintf(stderr, "Preproc pool %s has a bad header\n", path);
+    munmap(p, pool->map_len);
+    pool->base = NULL;
+    return -1;
+  }
+  return 0;
+}
+
+void pp_set_refill(PreprocPool *pool, uint64_t low_water, PpRefillFn refill, void *arg) {
+  pool->low_water = low_water;
+  pool->refill = refill;
+  pool->refill_arg = arg;
+}
+
+static void *refill_main(void *arg) {
+  PreprocPool *pool = (PreprocPool *)arg;
+  pool->refill(pool->refill_arg);
+  return NULL;
+}
+
+// Ask the kernel to read records [i, i + n) ahead without waiting
+static void prefetch_records(const PreprocPool *pool, uint64_t i, uint64_t n) {
+  size_t page_len = sysconf(_SC_PAGESIZE);
+  uintptr_t start = (uintptr_t)(pool->base + kPpHeaderLen + pool->hdr.record_len * i);
+  uintptr_t end = start + pool->hdr.record_len * n;
+  start = start / page_len * page_len;
+  madvise((void *)start, end - start, MADV_WILLNEED);
+}
+
+int64_t pp_reserve(PreprocPool *pool, uint64_t count) {
+  uint64_t num = pool->hdr.record_num;
+  uint64_t cur = __atomic_load_n(&pool->cursor, __ATOMIC_RELAXED);
+  do {
+    if (num - cur < count) return -1;
+  } while (!__atomic_compare_exchange_n(&pool->cursor, &cur, cur + count, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+  uint64_t left = num - cur - count;
+  if (left > 0) prefetch_records(pool, cur + count, left < count ? left : count);
+  if (pool->refill != NULL && left <= pool->low_water && !__atomic_exchange_n(&pool->refill_fired, 1, __ATOMIC_ACQ_REL)) {
+    if (pthread_create(&pool->refill_thread, NULL, refill_main, pool) != 0) {
+      perror("Preproc pool refill thread failed");
+      __atomic_store_n(&pool->refill_fired, 0, __ATOMIC_RELEASE);
+    }
+  }
+  return (int64_t)cur;
+}
+
+PpRecord pp_record(const PreprocPool *pool, uint64_t i) {
+  const PpHeader *hdr = &pool->hdr;
+  uint8_t *rec = (uint8_t *)pool->base + kPpHeaderLen + hdr->record_len * i;
+  PpRecord r;
+  r.s0 = rec;
+  r.k.cw_np1 = rec + kLambda;
+  r.k.cws = rec + cws_off();
+  memcpy(&r.mask, rec + mask_off(hdr->bitlen), 8);
+  const uint8_t *triples = rec + triples_off(hdr->bitlen);
+  if (hdr->party == 0) {
+    r.triple_seed = triples;
+    r.x1 = r.y1 = r.z1 = NULL;
+  } else {
+    r.triple_seed = NULL;
+    r.x1 = (const uint64_t *)triples;
+    r.y1 = r.x1 + hdr->dim;
+    r.z1 = r.x1 + 2 * hdr->dim;
+  }
+  return r;
+}
+
+int pp_rotate(PreprocPool *pool, const char *next, const char *path) {
+  PpRefillFn refill = pool->refill;
+  void *refill_arg = pool->refill_arg;
+  uint64_t low_water = pool->low_water;
+  pp_close(pool);
+  if (rename(next, path) != 0) {
+    perror("Preproc pool rename failed");
+    return -1;
+  }
+  if (pp_open(pool, path) != 0) return -1;
+  // pp_open() has reset the cursor and the trigger
+  pp_set_refill(pool, low_water, refill, refill_arg);
+  return 0;
+}
+
+void pp_close(PreprocPool *pool) {
+  if (__atomic_load_n(&pool->refill_fired, __ATOMIC_ACQUIRE)) pthread_join(pool->refill_thread, NULL);
+  if (pool->base != NULL) munmap((void *)pool->base, pool->map_len);
+  pool->base = NULL;
+}
@@ -0,0 +1,132 @@
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @file preproc_pool.h
+ *
+ * File of 1 party's correlated randomness for many queries, which the evaluation server maps and consumes without locks.
+ *
+ * The file is a page of @ref PpHeader followed by `record_num` records of `record_len` bytes each, a multiple of 64.
+ * A record is what 1 query consumes:
+ *
+ *     | s0 | cw_np1 | cws | mask share | triples |
+ *
+ * where `s0`, `cw_np1` and `cws` are the party's DCF key for `[x < r]` with beta = 1 and `alpha_bitlen` = `bitlen`,
+ * the mask share is the party's additive share of r mod @ref kPreprocPrime as a u64,
+ * and the triples are `dim` Beaver triples of preproc.h: the seed for party 0, or the corrections x_1 | y_1 | z_1 for party 1.
+ *
+ * Workers reserve disjoint runs of records with 1 CAS on a shared cursor.
+ * Each reservation asks the kernel to read the next run ahead, and the 1 that drops the remaining records to the low-water mark
+ * runs the refill hook on a background thread, so neither blocks the online phase.
+ * The hook deals a new file, and once the pool is drained its owner switches onto that file with @ref pp_rotate(),
+ * which also re-arms the hook for the new file.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <fss/dcf.h>
+#include "preproc.h"
+
+#define kPpMagic "FSSPPOL1"
+#define kPpHeaderLen 4096
+
+typedef struct {
+  char magic[8];
+  uint32_t lambda;
+  uint32_t party;
+  uint32_t bitlen;
+  uint32_t dim;
+  uint64_t record_num;
+  uint64_t record_len;
+} PpHeader;
+
+/**
+ * View of a record in the mapping
+ */
+typedef struct {
+  /**
+   * Key for @ref dcf_eval(), read-only
+   */
+  Key k;
+  const uint8_t *s0;
+  uint64_t mask;
+  /**
+   * Party 0: seed of @ref preproc_expand(). NULL for party 1.
+   */
+  const uint8_t *triple_seed;
+  /**
+   * Party 1: corrections of @ref preproc_deal(), `dim` each. NULL for party 0.
+   */
+  const uint64_t *x1, *y1, *z1;
+} PpRecord;
+
+typedef void (*PpRefillFn)(void *arg);
+
+typedef struct {
+  const uint8_t *base;
+  size_t map_len;
+  PpHeader hdr;
+  /**
+   * Next record not reserved yet. Only moved by CAS.
+   */
+  uint64_t cursor;
+  uint64_t low_water;
+  PpRefillFn refill;
+  void *refill_arg;
+  int refill_fired;
+  pthread_t refill_thread;
+} PreprocPool;
+
+/**
+ * Record len of a party for a bitlen and dim
+ */
+size_t pp_record_len(int party, int bitlen, int dim);
+
+/**
+ * Dealer: write the files of both parties for `record_num` queries.
+ * Randomness is from an OS-seeded @ref Rng with 1 stream per thread. @ref prg_init() must be called already.
+ * @return 0, or -1 if a file cannot be written
+ */
+int pp_deal(const char *path0, const char *path1, int bitlen, int dim, uint64_t record_num);
+
+/**
+ * Map a file read-only.
+ * @return 0, or -1 if the file cannot be mapped or its header does not match this build
+ */
+int pp_open(PreprocPool *pool, const char *path);
+
+/**
+ * Run `refill(arg)` on a background thread once the remaining records drop to `low_water`, once per file.
+ * Set it before any reservation.
+ */
+void pp_set_refill(PreprocPool *pool, uint64_t low_water, PpRefillFn refill, void *arg);
+
+/**
+ * Reserve `count` consecutive records for the caller only. Thread-safe and lock-free.
+ * @return Index of the first one, or -1 if fewer than `count` are left
+ */
+int64_t pp_reserve(PreprocPool *pool, uint64_t count);
+
+/**
+ * Records not reserved yet
+ */
+static inline uint64_t pp_remaining(const PreprocPool *pool) {
+  return pool->hdr.record_num - __atomic_load_n(&pool->cursor, __ATOMIC_RELAXED);
+}
+
+PpRecord pp_record(const PreprocPool *pool, uint64_t i);
+
+/**
+ * Switch onto the file dealt by the refill hook: wait for the hook, rename `next` to `path`, map it
+ * and re-arm the hook with the same `low_water`.
+ * Not thread-safe. Call it only when no worker reserves or reads records of the current file.
+ * @return 0, or -1 if the file cannot be renamed or mapped
+ */
+int pp_rotate(PreprocPool *pool, const char *next, const char *path);
+
+/**
+ * Wait for the refill hook if it was fired and unmap the file
+ */
+void pp_close(PreprocPool *pool);
@@ -0,0 +1,93 @@
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <gtest/gtest.h>
+
+extern "C" {
+#include "preproc.h"
+}
+
+typedef unsigned __int128 uint128_t;
+
+class PreprocTest : public ::testing::TestWithParam<const char *> {
+ protected:
+  void TearDown() override {
+    unsetenv("FSS_PRG_KERNEL");
+    rng_select_kernel();
+  }
+
+  // Pick the kernel of env FSS_PRG_KERNEL = `kernel`, and whether the CPU supports it
+  static bool select(const char *kernel) {
+    setenv("FSS_PRG_KERNEL", kernel, 1);
+    rng_select_kernel();
+    return strcmp(preproc_kernel_name(), kernel) == 0;
+  }
+
+  static constexpr size_t kLen = 1024;
+  static constexpr uint8_t kSeed[kPreprocSeedLen] = {7, 1, 7, 2, 7, 3, 7, 4, 7, 5, 7, 6, 7, 7, 7, 8};
+  static constexpr uint8_t kSeedXy[kPreprocSeedLen] = {9, 8, 7, 6, 5, 4, 3, 2, 1, 0, 1, 2, 3, 4, 5, 6};
+};
+
+TEST_P(PreprocTest, ExpandEqOpenssl) {
+  std::vector<uint64_t> x_want(kLen), y_want(kLen), z_want(kLen);
+  ASSERT_TRUE(select("openssl"));
+  preproc_expand(x_want.data(), y_want.data(), z_want.data(), kSeed, 0, kLen);
+  if (!select(GetParam())) GTEST_SKIP() << GetParam() << " is not supported by the CPU";
+
+  // Odd offsets and lens, and offsets off the 4-block, i.e., 8-element, steps of the vector kernels
+  const std::pair<size_t, size_t> ranges[] = {
+    {0, kLen}, {0, 1}, {1, 1}, {1, 2}, {3, 5}, {7, 31}, {9, 100}, {19, 17}, {6, 200}, {13, 64}, {1, kLen - 1}};
+  for (auto [offset, n] : ranges) {
+    std::vector<uint64_t> x(n), y(n), z(n);
+    preproc_expand(x.data(), y.data(), z.data(), kSeed, offset, n);
+    auto want = [&](const std::vector<uint64_t> &full) {
+      return std::vector<uint64_t>(full.begin() + offset, full.begin() + offset + n);
+    };
+    EXPECT_EQ(x, want(x_want)) << "offset = " << offset << ", n = " << n;
+    EXPECT_EQ(y, want(y_want)) << "offset = " << offset << ", n = " << n;
+    EXPECT_EQ(z, want(z_want)) << "offset = " << offset << ", n = " << n;
+    for (size_t i = 0; i < n; i++) {
+      ASSERT_LT(x[i], kPreprocPrime);
+      ASSERT_LT(y[i], kPreprocPrime);
+      ASSERT_LT(z[i], kPreprocPrime);
+    }
+  }
+
+  // A NULL output skips its stream but not the others
+  std::vector<uint64_t> y(5);
+  preproc_expand(NULL, y.data(), NULL, kSeed, 3, 5);
+  EXPECT_EQ(y, std::vector<uint64_t>(y_want.begin() + 3, y_want.begin() + 8));
+}
+
+TEST_P(PreprocTest, DealReconstructsTriples) {
+  if (!select(GetParam())) GTEST_SKIP() << GetParam() << " is not supported by the CPU";
+  // Over 1 chunk of the dealer, from an odd offset
+  size_t offset = 5, n = 300;
+  std::vector<uint64_t> x0(n), y0(n), z0(n), x1(n), y1(n), z1(n);
+  preproc_expand(x0.data(), y0.data(), z0.data(), kSeed, offset, n);
+  preproc_deal(x1.data(), y1.data(), z1.data(), kSeed, kSeedXy, offset, n);
+  for (size_t i = 0; i < n; i++) {
+    uint64_t x = (uint64_t)(((uint128_t)x0[i] + x1[i]) % kPreprocPrime);
+    uint64_t y = (uint64_t)(((uint128_t)y0[i] + y1[i]) % kPreprocPrime);
+    uint64_t z = (uint64_t)(((uint128_t)z0[i] + z1[i]) % kPreprocPrime);
+    ASSERT_EQ(z, (uint64_t)(((uint128_t)x * y) % kPreprocPrime)) << "i = " << i;
+  }
+}
+
+TEST_P(PreprocTest, DealReconstructsRingTriples) {
+  if (!select(GetParam())) GTEST_SKIP() << GetParam() << " is not supported by the CPU";
+  size_t offset = 5, n = 300;
+  std::vector<uint64_t> x0(n), y0(n), z0(n), x1(n), y1(n), z1(n);
+  preproc_expand_ring(x0.data(), y0.data(), z0.data(), kSeed, offset, n);
+  preproc_deal_ring(x1.data(), y1.data(), z1.data(), kSeed, kSeedXy, offset, n);
+  for (size_t i = 0; i < n; i++) {
+    ASSERT_EQ(z0[i] + z1[i], (x0[i] + x1[i]) * (y0[i] + y1[i])) << "i = " << i;
+  }
+
+  // Not the words of the field triples of the same seed
+  std::vector<uint64_t> x0_field(n);
+  preproc_expand(x0_field.data(), NULL, NULL, kSeed, offset, n);
+  EXPECT_NE(x0, x0_field);
+}
+
+INSTANTIATE_TEST_SUITE_P(Kernels, PreprocTest, ::testing::Values("openssl", "aesni", "vaes512"));
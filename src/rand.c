@@ -0,0 +1,301 @@
+// SPDX-License-Identifier: Apache-2.0
+
+#include "rand.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+  #define FSS_X86_DISPATCH 1
+  #include <immintrin.h>
+  #include "dcf/prg/aes128_key.h"
+#endif
+
+// Max bytes per EVP call, whose len is an int
+#define kEvpChunkLen (1 << 28)
+
+typedef void (*KeystreamKernel)(
+  uint8_t *out, const uint8_t *seed, uint64_t stream, uint64_t block, size_t block_num, int reduce);
+
+typedef size_t (*FieldCompactKernel)(uint64_t *words, size_t n);
+
+static inline uint64_t reduce_u64(uint64_t v) {
+  return v >= kRngFieldPrime ? v - kRngFieldPrime : v;
+}
+
+static inline void store_be64(uint8_t *buf, uint64_t v) {
+  for (int i = 0; i < 8; i++) {
+    buf[i] = v >> (56 - i * 8);
+  }
+}
+
+static void keystream_openssl(
+  uint8_t *out, const uint8_t *seed, uint64_t stream, uint64_t block, size_t block_num, int reduce) {
+  uint8_t iv[16];
+  store_be64(iv, stream);
+  store_be64(iv + 8, block);
+  EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
+  assert(ctx != NULL);
+  int ret = EVP_EncryptInit_ex2(ctx, EVP_aes_128_ctr(), seed, iv, NULL);
+  assert(ret == 1);
+  // The keystream is encrypted zeros
+  size_t len = block_num * 16;
+  memset(out, 0, len);
+  for (size_t i = 0; i < len; i += kEvpChunkLen) {
+    int out_len;
+    ret = EVP_EncryptUpdate(ctx, out + i, &out_len, out + i, len - i < kEvpChunkLen ? len - i : kEvpChunkLen);
+    assert(ret == 1);
+  }
+  (void)ret;
+  EVP_CIPHER_CTX_free(ctx);
+  if (reduce) {
+    for (size_t i = 0; i < block_num * 2; i++) {
+      uint64_t v;
+      memcpy(&v, out + i * 8, 8);
+      v = reduce_u64(v);
+      memcpy(out + i * 8, &v, 8);
+    }
+  }
+}
+
+// Branchless, so that the rare rejections do not cost mispredictions
+static size_t field_compact_scalar(uint64_t *words, size_t n) {
+  size_t j = 0;
+  for (size_t i = 0; i < n; i++) {
+    words[j] = words[i];
+    j += words[i] < kRngFieldPrime;
+  }
+  return j;
+}
+
+#ifdef FSS_X86_DISPATCH
+
+// 8 words per compare, and until the first rejection the words are already in place, so there is nothing to store
+__attribute__((target("avx512f"))) static size_t field_compact_avx512(uint64_t *words, size_t n) {
+  const __m512i p = _mm512_set1_epi64(kRngFieldPrime);
+  size_t i = 0, j = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m512i v = _mm512_loadu_si512(words + i);
+    __mmask8 ok = _mm512_cmplt_epu64_mask(v, p);
+    if (ok != 0xff || j != i) _mm512_mask_compressstoreu_epi64(words + j, ok, v);
+    j += __builtin_popcount(ok);
+  }
+  for (; i < n; i++) {
+    words[j] = words[i];
+    j += words[i] < kRngFieldPrime;
+  }
+  return j;
+}
+
+static inline void store_block(uint8_t *out, __m128i x, int reduce) {
+  uint64_t v[2];
+  _mm_storeu_si128((__m128i *)v, x);
+  if (reduce) {
+    v[0] = reduce_u64(v[0]);
+    v[1] = reduce_u64(v[1]);
+  }
+  memcpy(out, v, 16);
+}
+
+__attribute__((target("aes"))) static void ctr_block(
+  uint8_t *out, const __m128i *rk, uint64_t stream, uint64_t idx, int reduce) {
+  __m128i x = _mm_set_epi64x(__builtin_bswap64(idx), __builtin_bswap64(stream));
+  x = _mm_xor_si128(x, rk[0]);
+  for (int r = 1; r < 10; r++) {
+    x = _mm_aesenc_si128(x, rk[r]);
+  }
+  x = _mm_aesenclast_si128(x, rk[10]);
+  store_block(out, x, reduce);
+}
+
+  #define kAesniWays 8
+
+// 8 blocks in flight, to cover the latency of AESENC
+__attribute__((target("aes"))) static void keystream_aesni(
+  uint8_t *out, const uint8_t *seed, uint64_t stream, uint64_t block, size_t block_num, int reduce) {
+  __m128i rk[11];
+  aes128_expand_key(rk, seed);
+  uint64_t s = __builtin_bswap64(stream);
+  size_t i = 0;
+  for (; i + kAesniWays <= block_num; i += kAesniWays) {
+    __m128i x[kAesniWays];
+    for (int w = 0; w < kAesniWays; w++) {
+      x[w] = _mm_xor_si128(_mm_set_epi64x(__builtin_bswap64(block + i + w), s), rk[0]);
+    }
+    for (int r = 1; r < 10; r++) {
+      for (int w = 0; w < kAesniWays; w++) {
+        x[w] = _mm_aesenc_si128(x[w], rk[r]);
+      }
+    }
+    for (int w = 0; w < kAesniWays; w++) {
+      store_block(out + (i + w) * 16, _mm_aesenclast_si128(x[w], rk[10]), reduce);
+    }
+  }
+  for (; i < block_num; i++) {
+    ctr_block(out + i * 16, rk, stream, block + i, reduce);
+  }
+}
+
+  #define kVaes512Ways 4
+
+// 4 ZMM of 4 blocks each are in flight. Counters are kept as native u64 in the high half of each lane
+// and byte-swapped into the big-endian IV layout right before encryption.
+// The reduction is fused in, so the output is written once.
+__attribute__((target("aes,vaes,avx512f,avx512bw"))) static void keystream_vaes512(
+  uint8_t *out, const uint8_t *seed, uint64_t stream, uint64_t block, size_t block_num, int reduce) {
+  __m128i rk[11];
+  aes128_expand_key(rk, seed);
+  __m512i rk512[11];
+  for (int r = 0; r < 11; r++) {
+    rk512[r] = _mm512_broadcast_i32x4(rk[r]);
+  }
+  // Bytes 0-7 of a lane as is, bytes 8-15 reversed
+  const __m512i bswap_hi = _mm512_broadcast_i32x4(_mm_set_epi8(8, 9, 10, 11, 12, 13, 14, 15, 7, 6, 5, 4, 3, 2, 1, 0));
+  const __m512i p = _mm512_set1_epi64(kRngFieldPrime);
+  const __m512i step = _mm512_set_epi64(4 * kVaes512Ways, 0, 4 * kVaes512Ways, 0, 4 * kVaes512Ways, 0, 4 * kVaes512Ways, 0);
+  uint64_t s = __builtin_bswap64(stream);
+  __m512i ctr[kVaes512Ways];
+  for (int w = 0; w < kVaes512Ways; w++) {
+    uint64_t b = block + w * 4;
+    ctr[w] = _mm512_set_epi64(b + 3, s, b + 2, s, b + 1, s, b, s);
+  }
+
+  size_t i = 0;
+  for (; i + 4 * kVaes512Ways <= block_num; i += 4 * kVaes512Ways) {
+    __m512i x[kVaes512Ways];
+    for (int w = 0; w < kVaes512Ways; w++) {
+      x[w] = _mm512_xor_si512(_mm512_shuffle_epi8(ctr[w], bswap_hi), rk512[0]);
+      ctr[w] = _mm512_add_epi64(ctr[w], step);
+    }
+    for (int r = 1; r < 10; r++) {
+      for (int w = 0; w < kVaes512Ways; w++) {
+        x[w] = _mm512_aesenc_epi128(x[w], rk512[r]);
+      }
+    }
+    for (int w = 0; w < kVaes512Ways; w++) {
+      x[w] = _mm512_aesenclast_epi128(x[w], rk512[10]);
+      if (reduce) x[w] = _mm512_mask_sub_epi64(x[w], _mm512_cmpge_epu64_mask(x[w], p), x[w], p);
+      _mm512_storeu_si512(out + (i + w * 4) * 16, x[w]);
+    }
+  }
+  for (; i < block_num; i++) {
+    ctr_block(out + i * 16, rk, stream, block + i, reduce);
+  }
+}
+
+#endif
+
+static KeystreamKernel gKeystreamKernel;
+static FieldCompactKernel gFieldCompactKernel = field_compact_scalar;
+
+// Pick the widest kernel supported by the CPU.
+// Env FSS_PRG_KERNEL = openssl/aesni/vaes256/vaes512 caps it as for the PRG, where there is no vaes256 kernel.
+void rng_select_kernel() {
+  KeystreamKernel kernel = keystream_openssl;
+  FieldCompactKernel compact = field_compact_scalar;
+#ifdef FSS_X86_DISPATCH
+  __builtin_cpu_init();
+  int has_aesni = __builtin_cpu_supports("aes");
+  int has_vaes512 = has_aesni && __builtin_cpu_supports("vaes") && __builtin_cpu_supports("avx512f") &&
+    __builtin_cpu_supports("avx512bw");
+
+  const char *want = getenv("FSS_PRG_KERNEL");
+  if (want != NULL && strcmp(want, "openssl") == 0) has_aesni = 0;
+  if (want != NULL && (!has_aesni || strcmp(want, "aesni") == 0 || strcmp(want, "vaes256") == 0)) has_vaes512 = 0;
+
+  if (has_vaes512) {
+    kernel = keystream_vaes512;
+    compact = field_compact_avx512;
+  } else if (has_aesni) {
+    kernel = keystream_aesni;
+  }
+#endif
+  // Either compaction is correct, so a thread that still sees the old one is only slower
+  __atomic_store_n(&gFieldCompactKernel, compact, __ATOMIC_RELAXED);
+  __atomic_store_n(&gKeystreamKernel, kernel, __ATOMIC_RELAXED);
+}
+
+static KeystreamKernel get_keystream_kernel() {
+  KeystreamKernel kernel = __atomic_load_n(&gKeystreamKernel, __ATOMIC_RELAXED);
+  if (kernel != NULL) return kernel;
+  rng_select_kernel();
+  return __atomic_load_n(&gKeystreamKernel, __ATOMIC_RELAXED);
+}
+
+const char *rng_kernel_name() {
+  KeystreamKernel kernel = get_keystream_kernel();
+#ifdef FSS_X86_DISPATCH
+  if (kernel == keystream_vaes512) return "vaes512";
+  if (kernel == keystream_aesni) return "aesni";
+#endif
+  return "openssl";
+}
+
+void rng_keystream(uint8_t *out, const uint8_t *seed, uint64_t stream, uint64_t block, size_t block_num, int reduce) {
+  if (block_num == 0) return;
+  get_keystream_kernel()(out, seed, stream, block, block_num, reduce);
+}
+
+void rng_init(Rng *rng, const uint8_t *seed, uint64_t stream) {
+  if (seed != NULL) {
+    memcpy(rng->seed, seed, kRngSeedLen);
+  } else {
+    int ret = RAND_bytes(rng->seed, kRngSeedLen);
+    assert(ret == 1);
+    (void)ret;
+  }
+  rng->stream = stream;
+  rng->block = 0;
+  rng->pos = kRngBufLen;
+}
+
+static void refill(Rng *rng) {
+  rng_keystream(rng->buf, rng->seed, rng->stream, rng->block, kRngBufLen / 16, 0);
+  rng->block += kRngBufLen / 16;
+  rng->pos = 0;
+}
+
+void rng_fill_bytes(Rng *rng, uint8_t *out, size_t len) {
+  size_t m = kRngBufLen - rng->pos < len ? kRngBufLen - rng->pos : len;
+  memcpy(out, rng->buf + rng->pos, m);
+  rng->pos += m;
+  out += m;
+  len -= m;
+  if (len == 0) return;
+
+  // Whole blocks go straight to `out`
+  size_t block_num = len / 16;
+  rng_keystream(out, rng->seed, rng->stream, rng->block, block_num, 0);
+  rng->block += block_num;
+  out += block_num * 16;
+  len -= block_num * 16;
+  if (len == 0) return;
+
+  refill(rng);
+  memcpy(out, rng->buf, len);
+  rng->pos = len;
+}
+
+size_t rng_field_compact(uint64_t *words, size_t n) {
+  get_keystream_kernel();
+  return __atomic_load_n(&gFieldCompactKernel, __ATOMIC_RELAXED)(words, n);
+}
+
+// Words per keystream call of rng_fill_field(), so that the compaction reads them back from L1
+#define kRngFieldChunk 2048
+
+void rng_fill_field(Rng *rng, uint64_t *out, size_t n) {
+  // A word is rejected with probability 59 / 2^64
+  size_t j = 0;
+  for (size_t i = 0; i < n; i += kRngFieldChunk) {
+    size_t m = n - i < kRngFieldChunk ? n - i : kRngFieldChunk;
+    rng_fill_bytes(rng, (uint8_t *)(out + j), m * sizeof(uint64_t));
+    j += rng_field_compact(out + j, m);
+  }
+  while (j < n) {
+    uint64_t v = rng_u64(rng);
+    if (v < kRngFieldPrime) out[j++] = v;
+  }
+}
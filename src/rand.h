@@ -0,0 +1,95 @@
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @file rand.h
+ *
+ * Buffered AES-128-CTR generator for dealer seeds, masks and field samples.
+ *
+ * The keystream of a @ref kRngSeedLen bytes seed is split into 2^64 streams by the IV,
+ * which is | stream | block index |, each 8 bytes big-endian.
+ * Give each thread its own stream of 1 seed, e.g., `omp_get_thread_num()`, so they never overlap.
+ *
+ * The keystream is generated by a VAES-512 kernel with 16 blocks in flight when the CPU supports it,
+ * otherwise by an AES-NI kernel with 8 blocks in flight, otherwise by OpenSSL.
+ * Env `FSS_PRG_KERNEL` = `openssl`/`aesni`/`vaes256`/`vaes512` caps the kernel as for @ref prg.h. All output the same stream.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define kRngSeedLen 16
+#define kRngBufLen 4096
+/**
+ * 2^64 - 59, the field of the dot product and of the u64 group
+ */
+#define kRngFieldPrime 18446744073709551557ull
+
+typedef struct {
+  uint8_t seed[kRngSeedLen];
+  uint64_t stream;
+  /**
+   * Next block index of the keystream
+   */
+  uint64_t block;
+  /**
+   * Bytes of `buf` already consumed
+   */
+  size_t pos;
+  uint8_t buf[kRngBufLen] __attribute__((aligned(64)));
+} Rng;
+
+/**
+ * Name of the keystream kernel, `vaes512`, `aesni` or `openssl`
+ */
+const char *rng_kernel_name();
+
+/**
+ * Pick the keystream kernel again from the CPU and `FSS_PRG_KERNEL`, e.g., to compare kernels.
+ * The first use picks it otherwise. Not to call concurrently with other rng functions.
+ */
+void rng_select_kernel();
+
+/**
+ * Blocks `[block, block + block_num)` of stream `stream` of `seed`, 16 bytes each.
+ * With `reduce`, each 8 bytes as a u64 is reduced mod @ref kRngFieldPrime, whose bias is 59 / 2^64.
+ */
+void rng_keystream(uint8_t *out, const uint8_t *seed, uint64_t stream, uint64_t block, size_t block_num, int reduce);
+
+/**
+ * @param seed NULL to seed from the OS with OpenSSL `RAND_bytes()`
+ */
+void rng_init(Rng *rng, const uint8_t *seed, uint64_t stream);
+
+void rng_fill_bytes(Rng *rng, uint8_t *out, size_t len);
+
+/**
+ * Move the words < @ref kRngFieldPrime of `words` to its front in order, with AVX-512 compress stores along with the `vaes512` kernel.
+ * @return Num of such words
+ */
+size_t rng_field_compact(uint64_t *words, size_t n);
+
+/**
+ * Uniform elements mod @ref kRngFieldPrime by rejection sampling
+ */
+void rng_fill_field(Rng *rng, uint64_t *out, size_t n);
+
+static inline uint64_t rng_u64(Rng *rng) {
+  uint64_t v;
+  if (rng->pos + sizeof(v) <= kRngBufLen) {
+    memcpy(&v, rng->buf + rng->pos, sizeof(v));
+    rng->pos += sizeof(v);
+  } else {
+    rng_fill_bytes(rng, (uint8_t *)&v, sizeof(v));
+  }
+  return v;
+}
+
+static inline uint64_t rng_field(Rng *rng) {
+  for (;;) {
+    uint64_t v = rng_u64(rng);
+    if (v < kRngFieldPrime) return v;
+  }
+}
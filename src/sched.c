@@ -0,0 +1,247 @@
+// SPDX-License-Identifier: Apache-2.0
+
+// For real-time extensions
+#define _POSIX_C_SOURCE 199309L
+
+#include "sched.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <omp.h>
+#include <fss/ic.h>
+#include <fss/group.h>
+#include "dcf/pool.h"
+
+static inline double get_time() {
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1.0e-9;
+}
+
+static void *alloc_or_die(size_t len) {
+  void *p = malloc(len);
+  assert(p != NULL);
+  return p;
+}
+
+void sched_init(Sched *s, const uint64_t *xs, size_t n, int step_num, size_t chunk, int slot_num) {
+  s->xs = xs;
+  s->n = n;
+  s->step_num = step_num;
+  s->chunk = chunk;
+  s->chunk_num = (n + chunk - 1) / chunk;
+  s->slot_num = slot_num;
+  s->slots = (SchedQuery *)alloc_or_die(sizeof(SchedQuery) * slot_num);
+  s->active = (int *)alloc_or_die(sizeof(int) * slot_num);
+  s->active_num = 0;
+  for (int i = 0; i < slot_num; i++) {
+    SchedQuery *q = &s->slots[i];
+    q->key_base.cw_np1 = (uint8_t *)alloc_or_die(kLambda);
+    q->key_base.cws = (uint8_t *)alloc_or_die(kDcfCwLen * kSchedBitlen);
+    q->key_ge.cw_np1 = (uint8_t *)alloc_or_die(kLambda);
+    q->key_ge.cws = (uint8_t *)alloc_or_die(kDcfCwLen * kSchedBitlen);
+    q->ys_base = (uint8_t *)alloc_or_die(kLambda * n);
+    q->sums = (uint8_t *)alloc_or_die(kLambda * s->chunk_num);
+  }
+  Rng rng;
+  rng_init(&rng, NULL, 0);
+  rng_fill_bytes(&rng, s->seed, kRngSeedLen);
+  ws_open(&s->ws, kLambda * 10);
+  s->sbuf_gen = (uint8_t *)alloc_or_die(kLambda * 10);
+}
+
+void sched_free(Sched *s) {
+  for (int i = 0; i < s->slot_num; i++) {
+    SchedQuery *q = &s->slots[i];
+    free(q->key_base.cw_np1);
+    free(q->key_base.cws);
+    free(q->key_ge.cw_np1);
+    free(q->key_ge.cws);
+    free(q->ys_base);
+    free(q->sums);
+  }
+  free(s->slots);
+  free(s->active);
+  ws_close(&s->ws);
+  free(s->sbuf_gen);
+}
+
+// User: the key of the next round, with a random threshold as in retrieval.c
+static void gen_ge(SchedQuery *q, uint8_t *sbuf) {
+  uint8_t w[kLambda];
+  q->c = rng_field(&q->rng);
+  rng_fill_bytes(&q->rng, q->s_ge, 2 * kLambda);
+  memcpy(sbuf, q->s_ge, 2 * kLambda);
+  ic_gen_ge(q->key_ge, w, q->r, q->c, kRngFieldPrime, kSchedBitlen, sbuf);
+  // Share w, where party 0 gets w0
+  group_zero(q->w0);
+  uint64_t w0 = rng_field(&q->rng);
+  memcpy(q->w0, &w0, sizeof(w0));
+  memcpy(q->w1, q->w0, kLambda);
+  group_neg(q->w1);
+  group_add(q->w1, w);
+}
+
+static void submit(Sched *s, SchedQuery *q, int id, double t, uint8_t *sbuf) {
+  q->id = id;
+  q->t_submit = t;
+  q->round = 0;
+  q->idle = 0;
+  rng_init(&q->rng, s->seed, id);
+  q->r = rng_field(&q->rng);
+  Bits r_bits = {(uint8_t *)&q->r, kSchedBitlen};
+  rng_fill_bytes(&q->rng, q->s_base, 2 * kLambda);
+  memcpy(sbuf, q->s_base, 2 * kLambda);
+  ic_gen_base(q->key_base, r_bits, sbuf);
+}
+
+// Docs of chunk `ci` in the current round of `q`
+static void eval_chunk(const Sched *s, SchedQuery *q, size_t ci, uint8_t *sbuf) {
+  size_t begin = ci * s->chunk;
+  size_t end = begin + s->chunk < s->n ? begin + s->chunk : s->n;
+  uint8_t *sum = q->sums + ci * kLambda;
+  group_zero(sum);
+  for (size_t i = begin; i < end; i++) {
+    Bits x = {(uint8_t *)&s->xs[i], kSchedBitlen};
+    uint8_t *y_base = q->ys_base + i * kLambda;
+    if (q->round == 0) {
+      memcpy(sbuf, q->s_base, kLambda);
+      ic_eval_base(sbuf, 0, q->key_base, x);
+      memcpy(y_base, sbuf, kLambda);
+    } else {
+      memcpy(sbuf, q->s_ge, kLambda);
+      ic_eval_ge(sbuf, 0, q->key_ge, x, y_base, q->w0);
+      group_add(sum, sbuf);
+    }
+  }
+}
+
+// Sum the round just run and move to the next one.
+// @return 1 if it was the last round
+static int finish_round(Sched *s, SchedQuery *q, double t, double *latencies, uint64_t *results, uint8_t *sbuf) {
+  if (q->round > 0) {
+    uint8_t sum[kLambda];
+    group_zero(sum);
+    for (size_t ci = 0; ci < s->chunk_num; ci++) {
+      group_add(sum, q->sums + ci * kLambda);
+    }
+    // Servers return [c] to the user
+    if (q->round == s->step_num) {
+      memcpy(&results[q->id], sum, sizeof(uint64_t));
+      latencies[q->id] = t - q->t_submit;
+      return 1;
+    }
+  }
+  q->round++;
+  gen_ge(q, sbuf);
+  return 0;
+}
+
+static void sched_task(void *ctx, size_t i) {
+  Sched *s = (Sched *)ctx;
+  SchedQuery *q = &s->slots[s->active[i / s->chunk_num]];
+  uint8_t *sbuf = ws_get(&s->ws, pool_worker_id());
+  eval_chunk(s, q, i % s->chunk_num, sbuf);
+  // The last chunk of the round, after which all sums are visible
+  if (atomic_fetch_sub(&q->chunks_left, 1) != 1) return;
+
+  double t = get_time();
+  if (finish_round(s, q, t, s->latencies, s->results, sbuf)) {
+    // The client of the finished query submits its next one
+    int id = atomic_fetch_add(&s->next_id, 1);
+    if (id < s->query_num) {
+      submit(s, q, id, t, sbuf);
+    } else {
+      q->idle = 1;
+    }
+  }
+}
+
+double sched_run(Sched *s, int query_num, double *latencies, uint64_t *results) {
+  Pool *pool = pool_get();
+  assert(pool_thread_num(pool) <= s->ws.thread_num);
+
+  s->query_num = query_num;
+  s->latencies = latencies;
+  s->results = results;
+  double t_start = get_time();
+  int next_id = 0;
+  s->active_num = 0;
+  for (int i = 0; i < s->slot_num && next_id < query_num; i++) {
+    submit(s, &s->slots[i], next_id++, t_start, s->sbuf_gen);
+    s->active[s->active_num++] = i;
+  }
+  atomic_store(&s->next_id, next_id);
+
+  while (s->active_num > 0) {
+    for (int j = 0; j < s->active_num; j++) {
+      atomic_store(&s->slots[s->active[j]].chunks_left, s->chunk_num);
+    }
+    // Sums, gens and submits are done by the tasks
+    pool_for(pool, s->active_num * s->chunk_num, 1, sched_task, s);
+
+    int still_active = 0;
+    for (int j = 0; j < s->active_num; j++) {
+      int slot = s->active[j];
+      if (!s->slots[slot].idle) s->active[still_active++] = slot;
+    }
+    s->active_num = still_active;
+  }
+  return get_time() - t_start;
+}
+
+double sched_run_serial(Sched *s, int query_num, double *latencies, uint64_t *results) {
+  SchedQuery *q = &s->slots[0];
+  // Query `id` is submitted when query `id - slot_num` finishes, as its client only waits for that
+  double *t_submits = (double *)alloc_or_die(sizeof(double) * query_num);
+
+  double t_start = get_time();
+  for (int id = 0; id < query_num; id++) {
+    submit(s, q, id, id < s->slot_num ? t_start : t_submits[id], s->sbuf_gen);
+    for (;;) {
+#pragma omp parallel for
+      for (size_t ci = 0; ci < s->chunk_num; ci++) {
+        eval_chunk(s, q, ci, ws_get(&s->ws, omp_get_thread_num()));
+      }
+      double t = get_time();
+      if (finish_round(s, q, t, latencies, results, s->sbuf_gen)) {
+        if (id + s->slot_num < query_num) t_submits[id + s->slot_num] = t;
+        break;
+      }
+    }
+  }
+  double t_all = get_time() - t_start;
+
+  free(t_submits);
+  return t_all;
+}
+
+int sched_check(Sched *s, int id, uint64_t result) {
+  SchedQuery *q = &s->slots[0];
+  // The same RNG draws as the run, up to the key of the last round
+  submit(s, q, id, 0, s->sbuf_gen);
+  for (q->round = 1; q->round <= s->step_num; q->round++) {
+    gen_ge(q, s->sbuf_gen);
+  }
+
+  uint8_t count[kLambda], y_base[kLambda];
+  group_zero(count);
+  memcpy(count, &result, sizeof(result));
+  uint64_t plain = 0;
+  for (size_t i = 0; i < s->n; i++) {
+    Bits x = {(uint8_t *)&s->xs[i], kSchedBitlen};
+    memcpy(s->sbuf_gen, q->s_base + kLambda, kLambda);
+    ic_eval_base(s->sbuf_gen, 1, q->key_base, x);
+    memcpy(y_base, s->sbuf_gen, kLambda);
+    memcpy(s->sbuf_gen, q->s_ge + kLambda, kLambda);
+    ic_eval_ge(s->sbuf_gen, 1, q->key_ge, x, y_base, q->w1);
+    group_add(count, s->sbuf_gen);
+
+    uint64_t v = s->xs[i] >= q->r ? s->xs[i] - q->r : s->xs[i] + (kRngFieldPrime - q->r);
+    plain += v >= q->c;
+  }
+  uint64_t opened;
+  memcpy(&opened, count, sizeof(opened));
+  return opened == plain;
+}
@@ -0,0 +1,136 @@
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @file sched.h
+ *
+ * Scheduler of the comparison rounds of concurrent retrieval queries, as party 0 of retrieval.c.
+ *
+ * A query is a base round, i.e., @ref ic_eval_base() of its mask at all N docs,
+ * then `step_num` rounds of @ref ic_eval_ge() at all N docs, 1 per binary search step, each summed to the share of [c].
+ * The user gens the key of a round only after the previous round is summed, so the rounds of 1 query are serial.
+ *
+ * Serving the queries 1 by 1 with a fork-join pass per round leaves cores idle at every join and during every gen.
+ * Instead, each dispatch gathers the current round of all in-flight queries, cuts it into tasks of `chunk` docs
+ * and runs them all with 1 @ref pool_for() on the persistent work-stealing pool of dcf/pool.h.
+ * The task that finishes the last chunk of a query's round sums the round and gens the next key, or submits the client's
+ * next query when the query is done, so gens run in the pool alongside the other tasks of the dispatch,
+ * and only dropping the idle clients is left between dispatches.
+ *
+ * The load is closed-loop: `slot_num` clients each submit their next query when the previous one finishes.
+ * The keys of a query are gen from stream `id` of a fixed seed, so every query has the same result in any schedule.
+ */
+
+#pragma once
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <fss/dcf.h>
+#include "rand.h"
+#include "workspace.h"
+
+/**
+ * Bitlen of the inputs, which are elements mod @ref kRngFieldPrime
+ */
+#define kSchedBitlen 64
+
+typedef struct {
+  Key key_base, key_ge;
+  /**
+   * s0 and s1 of @ref key_base and @ref key_ge before gen, which overwrites its seeds
+   */
+  uint8_t s_base[2 * kLambda], s_ge[2 * kLambda];
+  /**
+   * Shares of `w` of @ref ic_gen_ge(), where party 1's is only for @ref sched_check()
+   */
+  uint8_t w0[kLambda], w1[kLambda];
+  uint64_t r;
+  /**
+   * Threshold of @ref key_ge
+   */
+  uint64_t c;
+  /**
+   * Evals of @ref key_base per doc, reused by all rounds
+   */
+  uint8_t *ys_base;
+  /**
+   * Sum of each chunk of the current round
+   */
+  uint8_t *sums;
+  /**
+   * 0 for the base round, then 1..`step_num`
+   */
+  int round;
+  /**
+   * Chunks of the current round yet to run in this dispatch
+   */
+  _Atomic size_t chunks_left;
+  /**
+   * Whether the client has no more queries to submit
+   */
+  int idle;
+  int id;
+  double t_submit;
+  Rng rng;
+} SchedQuery;
+
+typedef struct {
+  /**
+   * Masked inputs of docs
+   */
+  const uint64_t *xs;
+  size_t n;
+  int step_num;
+  size_t chunk;
+  size_t chunk_num;
+  int slot_num;
+  SchedQuery *slots;
+  /**
+   * Slots of the in-flight queries of the current dispatch
+   */
+  int *active;
+  int active_num;
+  uint8_t seed[kRngSeedLen];
+  /**
+   * `sbuf` of evals and gens per thread
+   */
+  Workspace ws;
+  uint8_t *sbuf_gen;
+  /**
+   * Queries of the current @ref sched_run(), whose next id is taken by the finishing tasks
+   */
+  int query_num;
+  _Atomic int next_id;
+  double *latencies;
+  uint64_t *results;
+} Sched;
+
+/**
+ * @ref prg_init() must be called already.
+ * @param slot_num Max in-flight queries, i.e., clients
+ */
+void sched_init(Sched *s, const uint64_t *xs, size_t n, int step_num, size_t chunk, int slot_num);
+
+/**
+ * Serve `query_num` queries with co-scheduled rounds.
+ * @param latencies Output seconds from submit to finish of each query
+ * @param results Output share of [c] of the last round of each query, as the low 8 bytes of the group element
+ * @return Seconds of all queries
+ */
+double sched_run(Sched *s, int query_num, double *latencies, uint64_t *results);
+
+/**
+ * Serve the same load 1 query at a time with 1 `#pragma omp parallel for` per round, for comparison.
+ * Same as @ref sched_run().
+ */
+double sched_run_serial(Sched *s, int query_num, double *latencies, uint64_t *results);
+
+/**
+ * Check the result of query `id` of a run: regen its keys, eval its last round as party 1 at all docs,
+ * and compare the opened count with the plain count of docs whose unmasked input is >= the threshold.
+ * Uses slot 0, so call it between runs.
+ * @return 1 if they are equal
+ */
+int sched_check(Sched *s, int id, uint64_t result);
+
+void sched_free(Sched *s);
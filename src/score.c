@@ -0,0 +1,99 @@
+// SPDX-License-Identifier: Apache-2.0
+
+#include "score.h"
+
+typedef unsigned __int128 uint128_t;
+
+// 2^64 mod p
+#define kFold 59
+
+// acc += a * b with the high half folded, which adds < 2^70, so 2^58 terms never overflow
+static inline void mac(uint128_t *acc, uint64_t a, uint64_t b) {
+  uint128_t p = (uint128_t)a * b;
+  *acc += (uint128_t)(uint64_t)(p >> 64) * kFold + (uint64_t)p;
+}
+
+static inline uint64_t reduce128(uint128_t v) {
+  v = (uint128_t)(uint64_t)(v >> 64) * kFold + (uint64_t)v;
+  v = (uint128_t)(uint64_t)(v >> 64) * kFold + (uint64_t)v;
+  uint64_t r = (uint64_t)(v >> 64) * kFold + (uint64_t)v;
+  return r >= kRngFieldPrime ? r - kRngFieldPrime : r;
+}
+
+static inline uint64_t add_mod_p(uint64_t a, uint64_t b) {
+  uint64_t c = a + b;
+  if (c < a || c >= kRngFieldPrime) c -= kRngFieldPrime;
+  return c;
+}
+
+// Scores of queries [q, q + tq) and docs [j, j + tn). Constant `b`, `tq` and `tn` are unrolled when inlined.
+static inline void score_tile(uint64_t *out, int b, const uint64_t *e, const uint64_t *f, const uint64_t *x_b,
+  const uint64_t *y_b, const uint64_t *z_b, size_t n, int dim, int q, size_t j, int tq, int tn) {
+  uint128_t acc[kScoreTileQ][kScoreTileN] = {{0}};
+  const uint64_t *es[kScoreTileQ], *xs[kScoreTileQ], *fs[kScoreTileN], *ys[kScoreTileN];
+  for (int qi = 0; qi < tq; qi++) {
+    es[qi] = e + (size_t)(q + qi) * dim;
+    xs[qi] = x_b + (size_t)(q + qi) * dim;
+  }
+  for (int ji = 0; ji < tn; ji++) {
+    fs[ji] = f + (j + ji) * dim;
+    ys[ji] = y_b + (j + ji) * dim;
+  }
+
+  for (int k = 0; k < dim; k++) {
+    for (int qi = 0; qi < tq; qi++) {
+      for (int ji = 0; ji < tn; ji++) {
+        mac(&acc[qi][ji], es[qi][k], ys[ji][k]);
+        mac(&acc[qi][ji], xs[qi][k], fs[ji][k]);
+        if (b) mac(&acc[qi][ji], es[qi][k], fs[ji][k]);
+      }
+    }
+  }
+
+  for (int qi = 0; qi < tq; qi++) {
+    for (int ji = 0; ji < tn; ji++) {
+      size_t i = (size_t)(q + qi) * n + j + ji;
+      out[i] = add_mod_p(reduce128(acc[qi][ji]), z_b[i]);
+    }
+  }
+}
+
+#define SCORE_TILE(b, tq, tn) score_tile(out, b, e, f, x_b, y_b, z_b, n, dim, q, j, tq, tn)
+
+static inline void score_block(uint64_t *out, int b, const uint64_t *e, const uint64_t *f, const uint64_t *x_b,
+  const uint64_t *y_b, const uint64_t *z_b, int q_num, size_t n, int dim, size_t j_begin, size_t j_end) {
+  // The query tile stays in L1 while the docs of the block are streamed from L2
+  for (int q = 0; q < q_num; q += kScoreTileQ) {
+    int tq = q_num - q < kScoreTileQ ? q_num - q : kScoreTileQ;
+    for (size_t j = j_begin; j < j_end; j += kScoreTileN) {
+      int tn = j_end - j < kScoreTileN ? j_end - j : kScoreTileN;
+      if (tq == kScoreTileQ && tn == kScoreTileN) {
+        if (b) {
+          SCORE_TILE(1, kScoreTileQ, kScoreTileN);
+        } else {
+          SCORE_TILE(0, kScoreTileQ, kScoreTileN);
+        }
+      } else if (tq == 1 && tn == kScoreTileN) {
+        // A single query, e.g., scoring 1 at a time
+        if (b) {
+          SCORE_TILE(1, 1, kScoreTileN);
+        } else {
+          SCORE_TILE(0, 1, kScoreTileN);
+        }
+      } else {
+        SCORE_TILE(b, tq, tn);
+      }
+    }
+  }
+}
+
+void score_batch(uint64_t *out, int b, const uint64_t *e, const uint64_t *f, const uint64_t *x_b, const uint64_t *y_b,
+  const uint64_t *z_b, int q_num, size_t n, int dim) {
+  size_t block_num = (n + kScoreBlockN - 1) / kScoreBlockN;
+#pragma omp parallel for schedule(dynamic)
+  for (size_t blk = 0; blk < block_num; blk++) {
+    size_t j_begin = blk * kScoreBlockN;
+    size_t j_end = j_begin + kScoreBlockN < n ? j_begin + kScoreBlockN : n;
+    score_block(out, b, e, f, x_b, y_b, z_b, q_num, n, dim, j_begin, j_end);
+  }
+}
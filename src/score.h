@@ -0,0 +1,53 @@
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @file score.h
+ *
+ * Batched scoring: shares of all Q x N inner products of Q secret-shared queries and N secret-shared docs,
+ * with a matrix Beaver triple, i.e., X (Q x dim), Y (N x dim) and Z = X Y^T (Q x N) mod @ref kRngFieldPrime.
+ * After opening E = A - X and F = B - Y, party b's share of the scores A B^T is
+ *
+ *     Z_b + E Y_b^T + X_b F^T + b * E F^T
+ *
+ * which @ref score_batch() computes as 1 fused GEMM.
+ * All matrices are row-major with `dim` contiguous per query/doc, so a doc row is streamed once per batch
+ * and reused from cache by all Q queries instead of being re-read from memory per query.
+ *
+ * Docs are processed in blocks of @ref kScoreBlockN that stay in L2, each by 1 OpenMP thread,
+ * and within a block in register tiles of @ref kScoreTileQ queries by @ref kScoreTileN docs.
+ * Products are accumulated in `unsigned __int128` with their high half folded by 2^64 = 59 mod p,
+ * so each score is reduced once at the end.
+ *
+ * Batching does not beat repeated single-query calls (whose tile is 1 x @ref kScoreTileN) here: the kernel is
+ * bound by the 64 x 64 -> 128-bit multiplies, not by streaming the docs, so reusing a doc row across queries
+ * saves little. With 1 thread, N = 16384 and dim = 1024, 3 runs of batch_score_benchmark gave batched vs
+ * repeated 5686 / 6122 / 6759 ms vs 6636 / 5390 / 7427 ms at Q = 64, and the same mixed order at Q = 2..32,
+ * i.e., parity within the box's noise of about 20%. The previous 2 x 2 tile was 10-25% slower than repeated,
+ * and 1 x 4 and 2 x 1 were no better than 2 x 4. Override the tile with -DkScoreTileQ / -DkScoreTileN to measure.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "rand.h"
+
+#define kScoreBlockN 32
+#ifndef kScoreTileQ
+#define kScoreTileQ 2
+#endif
+#ifndef kScoreTileN
+#define kScoreTileN 4
+#endif
+
+/**
+ * Party `b`'s shares of the Q x N scores.
+ * @param out Q x N, row-major
+ * @param e Opened A - X, Q x dim
+ * @param f Opened B - Y, N x dim
+ * @param x_b Q x dim
+ * @param y_b N x dim
+ * @param z_b Q x N
+ */
+void score_batch(uint64_t *out, int b, const uint64_t *e, const uint64_t *f, const uint64_t *x_b, const uint64_t *y_b,
+  const uint64_t *z_b, int q_num, size_t n, int dim);
@@ -0,0 +1,132 @@
+// For real-time extensions
+#define _POSIX_C_SOURCE 199309L
+
+// Per-thread scratch layouts: packed in 1 malloc() buffer by the main thread vs @ref Workspace.
+// Packed slices of adjacent threads share cache lines and are all placed on the NUMA node of the main thread.
+// Run with threads spread over sockets (e.g., `OMP_PLACES=cores OMP_PROC_BIND=spread`) to see the NUMA part.
+// Usage: scratch_benchmark
+
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <fss/dcf.h>
+#include <omp.h>
+#include "workspace.h"
+
+#define kSeed 114514
+#define kAlphaBitlen 64
+#define kN 100000
+#define kCounterIterNum 100000000
+
+static inline double get_time() {
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1.0e-9;
+}
+
+static void gen_rand_bytes(uint8_t *buf, size_t len) {
+  for (size_t i = 0; i < len; i++) {
+    buf[i] = rand() & 0xFF;
+  }
+}
+
+// Time dcf_eval() with the slice of thread `tid` at `sbufs + tid * stride`
+static double time_eval(uint8_t *sbufs, size_t stride, Key k, const uint8_t *s0, const uint64_t *xs) {
+  double t = get_time();
+#pragma omp parallel for
+  for (int i = 0; i < kN; i++) {
+    uint8_t *sbuf = sbufs + omp_get_thread_num() * stride;
+    memcpy(sbuf, s0, kLambda);
+    Bits x_bits = {(uint8_t *)&xs[i], kAlphaBitlen};
+    dcf_eval(sbuf, 0, k, x_bits);
+  }
+  return (get_time() - t) / kN;
+}
+
+// Time each thread bumping its own counter at `counters + tid * stride`
+static double time_counters(uint8_t *counters, size_t stride) {
+  double t = get_time();
+#pragma omp parallel
+  {
+    volatile uint64_t *c = (volatile uint64_t *)(counters + omp_get_thread_num() * stride);
+    for (int i = 0; i < kCounterIterNum; i++) {
+      *c += 1;
+    }
+  }
+  return (get_time() - t) / kCounterIterNum;
+}
+
+int main() {
+  srand(kSeed);
+  int thread_num = omp_get_max_threads();
+  printf("OpenMP thread num: %d\n", thread_num);
+  printf("Lambda (B): %d\n", kLambda);
+
+  // Init PRG
+  uint8_t *keys = (uint8_t *)malloc(4 * kLambda);
+  assert(keys != NULL);
+  gen_rand_bytes(keys, 4 * kLambda);
+  prg_init(keys, 4 * kLambda);
+  free(keys);
+  printf("PRG kernel: %s\n", prg_name());
+  printf("Workspace huge pages: %s\n", getenv("FSS_WS_HUGE") != NULL ? getenv("FSS_WS_HUGE") : "0");
+
+  uint8_t *s0s = (uint8_t *)malloc(kLambda * 2);
+  assert(s0s != NULL);
+  gen_rand_bytes(s0s, kLambda * 2);
+  uint8_t *beta = (uint8_t *)malloc(kLambda);
+  assert(beta != NULL);
+  memset(beta, 0, kLambda);
+  gen_rand_bytes(beta, 8);
+  uint8_t alpha[8];
+  gen_rand_bytes(alpha, sizeof(alpha));
+  Bits alpha_bits = {alpha, kAlphaBitlen};
+  CmpFunc cf = {{alpha_bits, beta}, kLtAlpha};
+
+  Key k;
+  k.cw_np1 = (uint8_t *)malloc(kLambda);
+  assert(k.cw_np1 != NULL);
+  k.cws = (uint8_t *)malloc(kDcfCwLen * kAlphaBitlen);
+  assert(k.cws != NULL);
+  uint8_t *sbuf = (uint8_t *)malloc(kLambda * 10);
+  assert(sbuf != NULL);
+  memcpy(sbuf, s0s, kLambda * 2);
+  dcf_gen(k, cf, sbuf);
+
+  uint64_t *xs = (uint64_t *)malloc(kN * sizeof(uint64_t));
+  assert(xs != NULL);
+  gen_rand_bytes((uint8_t *)xs, kN * sizeof(uint64_t));
+
+  // Both are first touched by the main thread, as the benchmarks did
+  uint8_t *packed = (uint8_t *)malloc(kLambda * 6 * thread_num);
+  assert(packed != NULL);
+  memset(packed, 0, kLambda * 6 * thread_num);
+  uint8_t *packed_counters = (uint8_t *)malloc(sizeof(uint64_t) * thread_num);
+  assert(packed_counters != NULL);
+  memset(packed_counters, 0, sizeof(uint64_t) * thread_num);
+
+  Workspace ws;
+  ws_open(&ws, kLambda * 6);
+
+  printf("kind,packed_ns,workspace_ns\n");
+  double t_packed = time_eval(packed, kLambda * 6, k, s0s, xs);
+  double t_ws = time_eval(ws.base, ws.stride, k, s0s, xs);
+  printf("dcf_eval,%lf,%lf\n", t_packed * 1e9, t_ws * 1e9);
+  t_packed = time_counters(packed_counters, sizeof(uint64_t));
+  t_ws = time_counters(ws.base, ws.stride);
+  printf("counter,%lf,%lf\n", t_packed * 1e9, t_ws * 1e9);
+
+  ws_close(&ws);
+  prg_free();
+  free(s0s);
+  free(beta);
+  free(xs);
+  free(sbuf);
+  free(packed);
+  free(packed_counters);
+  free(k.cw_np1);
+  free(k.cws);
+  return 0;
+}
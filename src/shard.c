@@ -0,0 +1,392 @@
+// SPDX-License-Identifier: Apache-2.0
+
+// For MSG_NOSIGNAL
+#define _GNU_SOURCE
+
+#include "shard.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <omp.h>
+#include <fss/ic.h>
+#include <fss/group.h>
+
+typedef unsigned __int128 uint128_t;
+
+// Streams of the seed: the plain embeddings, party 0's shares of them, and the seeds of the triples
+enum { kStreamEmb, kStreamEmb0, kStreamTripleSeeds };
+
+static inline size_t key_len() {
+  return kLambda + kDcfCwLen * kShardBitlen;
+}
+
+// Send all of `buf`, without SIGPIPE if the peer is gone
+static int send_all(int fd, const void *buf, size_t len) {
+  const uint8_t *p = (const uint8_t *)buf;
+  while (len > 0) {
+    ssize_t sent = send(fd, p, len, MSG_NOSIGNAL);
+    if (sent < 0 && errno == EINTR) continue;
+    if (sent <= 0) return -1;
+    p += sent;
+    len -= sent;
+  }
+  return 0;
+}
+
+static int recv_all(int fd, void *buf, size_t len) {
+  uint8_t *p = (uint8_t *)buf;
+  while (len > 0) {
+    ssize_t got = recv(fd, p, len, 0);
+    if (got < 0 && errno == EINTR) continue;
+    if (got <= 0) return -1;
+    p += got;
+    len -= got;
+  }
+  return 0;
+}
+
+void shard_range(size_t n, int shard_num, int i, size_t *begin, size_t *end) {
+  *begin = n * i / shard_num / 2 * 2;
+  *end = i + 1 == shard_num ? n : n * (i + 1) / shard_num / 2 * 2;
+}
+
+static inline uint64_t add_mod_p(uint64_t a, uint64_t b) {
+  return (uint64_t)(((uint128_t)a + b) % kRngFieldPrime);
+}
+
+static inline uint64_t sub_mod_p(uint64_t a, uint64_t b) {
+  return a >= b ? a - b : a + (kRngFieldPrime - b);
+}
+
+static inline uint64_t mul_mod_p(uint64_t a, uint64_t b) {
+  return (uint64_t)(((uint128_t)a * b) % kRngFieldPrime);
+}
+
+// Embedding `i` of `stream`, where the query is 0 and doc `j` is `j + 1`
+static void emb_expand(uint64_t *out, const uint8_t *seed, int stream, size_t i) {
+  rng_keystream((uint8_t *)out, seed, stream, i * kShardDim / 2, kShardDim / 2, 1);
+}
+
+// Plain score of doc `j`
+static uint64_t plain_score(const uint8_t *seed, size_t j) {
+  uint64_t query[kShardDim], doc[kShardDim];
+  emb_expand(query, seed, kStreamEmb, 0);
+  emb_expand(doc, seed, kStreamEmb, j + 1);
+  uint64_t score = 0;
+  for (int k = 0; k < kShardDim; k++) {
+    score = add_mod_p(score, mul_mod_p(query[k], doc[k]));
+  }
+  return score;
+}
+
+// Dealer of doc `j` for the worker, which keeps party 0's share of it and party 1's side
+static void deal_doc(ShardState *st, const uint8_t *seed, const uint8_t *seed_xy, const uint64_t *query_1, size_t i) {
+  size_t j = st->begin + i;
+  uint64_t doc[kShardDim], x_0[kShardDim], y_0[kShardDim], x_1[kShardDim], y_1[kShardDim], z_1[kShardDim];
+  uint64_t *doc_0 = st->docs_0 + i * kShardDim, *d_1 = st->ds_1 + i * kShardDim, *e_1 = st->es_1 + i * kShardDim;
+  emb_expand(doc, seed, kStreamEmb, j + 1);
+  emb_expand(doc_0, seed, kStreamEmb0, j + 1);
+  preproc_expand(x_0, y_0, NULL, st->triple_seed, j * kShardDim, kShardDim);
+  preproc_deal(x_1, y_1, z_1, st->triple_seed, seed_xy, j * kShardDim, kShardDim);
+
+  // Party 1 also adds the public (query - x) * (doc - y)
+  uint64_t score_1 = 0;
+  for (int k = 0; k < kShardDim; k++) {
+    d_1[k] = sub_mod_p(query_1[k], x_1[k]);
+    e_1[k] = sub_mod_p(sub_mod_p(doc[k], doc_0[k]), y_1[k]);
+    uint64_t dk = add_mod_p(sub_mod_p(st->query_0[k], x_0[k]), d_1[k]);
+    uint64_t ek = add_mod_p(sub_mod_p(doc_0[k], y_0[k]), e_1[k]);
+    uint64_t ck = add_mod_p(z_1[k], mul_mod_p(ek, x_1[k]));
+    ck = add_mod_p(ck, mul_mod_p(dk, y_1[k]));
+    ck = add_mod_p(ck, mul_mod_p(dk, ek));
+    score_1 = add_mod_p(score_1, ck);
+  }
+  st->scores_1[i] = score_1;
+}
+
+int shard_load(ShardState *st, const uint8_t *seed, size_t begin, size_t end) {
+  size_t doc_num = end - begin;
+  st->begin = begin;
+  st->doc_num = doc_num;
+  st->docs_0 = (uint64_t *)malloc(doc_num * kShardDim * sizeof(uint64_t));
+  st->ds_1 = (uint64_t *)malloc(doc_num * kShardDim * sizeof(uint64_t));
+  st->es_1 = (uint64_t *)malloc(doc_num * kShardDim * sizeof(uint64_t));
+  st->scores_1 = (uint64_t *)malloc(doc_num * sizeof(uint64_t));
+  st->xs = (uint64_t *)malloc(doc_num * sizeof(uint64_t));
+  st->ys_base = (uint8_t *)malloc(kLambda * doc_num);
+  // | s0 | cw_np1 | cws | w |
+  st->msg = (uint8_t *)malloc(kLambda + key_len() + kLambda);
+  if (st->docs_0 == NULL || st->ds_1 == NULL || st->es_1 == NULL || st->scores_1 == NULL || st->xs == NULL ||
+    st->ys_base == NULL || st->msg == NULL) {
+    fprintf(stderr, "Shard alloc failed\n");
+    free(st->docs_0);
+    free(st->ds_1);
+    free(st->es_1);
+    free(st->scores_1);
+    free(st->xs);
+    free(st->ys_base);
+    free(st->msg);
+    return -1;
+  }
+
+  uint8_t seed_xy[kPreprocSeedLen];
+  Rng rng;
+  rng_init(&rng, seed, kStreamTripleSeeds);
+  rng_fill_bytes(&rng, st->triple_seed, kPreprocSeedLen);
+  rng_fill_bytes(&rng, seed_xy, kPreprocSeedLen);
+  uint64_t query[kShardDim], query_1[kShardDim];
+  emb_expand(query, seed, kStreamEmb, 0);
+  emb_expand(st->query_0, seed, kStreamEmb0, 0);
+  for (int k = 0; k < kShardDim; k++) {
+    query_1[k] = sub_mod_p(query[k], st->query_0[k]);
+  }
+#pragma omp parallel for
+  for (size_t i = 0; i < doc_num; i++) {
+    deal_doc(st, seed, seed_xy, query_1, i);
+  }
+
+  ws_open(&st->ws, kLambda * 10);
+  st->has_scores = 0;
+  st->has_base = 0;
+  return 0;
+}
+
+void shard_count_1(uint8_t *count, const uint8_t *seed, size_t n, uint64_t r, Key key_base, const uint8_t *s_base,
+  Key key_ge, const uint8_t *s_ge, const uint8_t *w1) {
+  uint8_t sbuf[kLambda * 10], y_base[kLambda];
+  group_zero(count);
+  for (size_t j = 0; j < n; j++) {
+    uint64_t x_u64 = add_mod_p(plain_score(seed, j), r);
+    Bits x = {(uint8_t *)&x_u64, kShardBitlen};
+    memcpy(sbuf, s_base + kLambda, kLambda);
+    ic_eval_base(sbuf, 1, key_base, x);
+    memcpy(y_base, sbuf, kLambda);
+    memcpy(sbuf, s_ge + kLambda, kLambda);
+    ic_eval_ge(sbuf, 1, key_ge, x, y_base, w1);
+    group_add(count, sbuf);
+  }
+}
+
+uint64_t shard_plain_count(const uint8_t *seed, size_t n, uint64_t c) {
+  uint64_t count = 0;
+  for (size_t j = 0; j < n; j++) {
+    count += plain_score(seed, j) >= c;
+  }
+  return count;
+}
+
+void shard_unload(ShardState *st) {
+  ws_close(&st->ws);
+  free(st->docs_0);
+  free(st->ds_1);
+  free(st->es_1);
+  free(st->scores_1);
+  free(st->xs);
+  free(st->ys_base);
+  free(st->msg);
+}
+
+void shard_score(ShardState *st, uint64_t r_0, uint64_t r_1) {
+  uint64_t r = add_mod_p(r_0, r_1);
+#pragma omp parallel for
+  for (size_t i = 0; i < st->doc_num; i++) {
+    uint64_t x_0[kShardDim], y_0[kShardDim], z_0[kShardDim];
+    const uint64_t *doc_0 = st->docs_0 + i * kShardDim;
+    const uint64_t *d_1 = st->ds_1 + i * kShardDim, *e_1 = st->es_1 + i * kShardDim;
+    preproc_expand(x_0, y_0, z_0, st->triple_seed, (st->begin + i) * kShardDim, kShardDim);
+
+    uint64_t score_0 = 0;
+    for (int k = 0; k < kShardDim; k++) {
+      uint64_t dk = add_mod_p(sub_mod_p(st->query_0[k], x_0[k]), d_1[k]);
+      uint64_t ek = add_mod_p(sub_mod_p(doc_0[k], y_0[k]), e_1[k]);
+      uint64_t ck = add_mod_p(z_0[k], mul_mod_p(ek, x_0[k]));
+      ck = add_mod_p(ck, mul_mod_p(dk, y_0[k]));
+      score_0 = add_mod_p(score_0, ck);
+    }
+    // Open d_j + r with party 1's share of both
+    st->xs[i] = add_mod_p(add_mod_p(score_0, st->scores_1[i]), r);
+  }
+  st->has_scores = 1;
+  st->has_base = 0;
+}
+
+void shard_eval(ShardState *st, int op, Key k, const uint8_t *s0, const uint8_t *w, uint8_t *sum) {
+  const uint64_t *xs = st->xs;
+  uint8_t *ys_base = st->ys_base;
+  group_zero(sum);
+#pragma omp parallel
+  {
+    uint8_t *sbuf = ws_get(&st->ws, omp_get_thread_num());
+    uint8_t local_sum[kLambda];
+    group_zero(local_sum);
+#pragma omp for
+    for (size_t i = 0; i < st->doc_num; i++) {
+      Bits x = {(uint8_t *)&xs[i], kShardBitlen};
+      memcpy(sbuf, s0, kLambda);
+      if (op == kShardOpBase) {
+        ic_eval_base(sbuf, 0, k, x);
+        memcpy(ys_base + i * kLambda, sbuf, kLambda);
+      } else {
+        ic_eval_ge(sbuf, 0, k, x, ys_base + i * kLambda, w);
+        group_add(local_sum, sbuf);
+      }
+    }
+#pragma omp critical
+    group_add(sum, local_sum);
+  }
+  if (op == kShardOpBase) st->has_base = 1;
+}
+
+int shard_serve_conn(ShardState *st, int fd) {
+  st->has_scores = 0;
+  st->has_base = 0;
+  for (;;) {
+    ShardMsgHeader hdr;
+    // The coordinator hanging up is a quit too
+    if (recv_all(fd, &hdr, sizeof(hdr)) != 0 || hdr.op == kShardOpQuit) return 0;
+    if (hdr.bitlen != kShardBitlen || (hdr.op != kShardOpScore && hdr.op != kShardOpBase && hdr.op != kShardOpGe)) {
+      return -1;
+    }
+    if (hdr.op == kShardOpBase && !st->has_scores) return -1;
+    if (hdr.op == kShardOpGe && !st->has_base) return -1;
+    if (hdr.op == kShardOpScore) {
+      uint64_t r[2];
+      uint8_t zero[kLambda];
+      if (recv_all(fd, r, sizeof(r)) != 0) return -1;
+      shard_score(st, r[0], r[1]);
+      group_zero(zero);
+      if (send_all(fd, zero, kLambda) != 0) return -1;
+      continue;
+    }
+    size_t msg_len = kLambda + key_len() + (hdr.op == kShardOpGe ? kLambda : 0);
+    if (recv_all(fd, st->msg, msg_len) != 0) return -1;
+    Key k = {st->msg + kLambda * 2, st->msg + kLambda};
+
+    uint8_t sum[kLambda];
+    shard_eval(st, hdr.op, k, st->msg, st->msg + kLambda + key_len(), sum);
+    if (send_all(fd, sum, kLambda) != 0) return -1;
+  }
+}
+
+int shard_serve(int fd, const uint8_t *seed, size_t begin, size_t end) {
+  ShardState st;
+  if (shard_load(&st, seed, begin, end) != 0) return -1;
+  int ret = shard_serve_conn(&st, fd);
+  shard_unload(&st);
+  return ret;
+}
+
+int shard_spawn(ShardCluster *c, const uint8_t *seed, size_t n, int shard_num, int thread_num) {
+  c->n = n;
+  c->shard_num = 0;
+  c->conns = (ShardConn *)malloc(sizeof(ShardConn) * shard_num);
+  if (c->conns == NULL) return -1;
+  for (int i = 0; i < shard_num; i++) {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+      perror("Shard socketpair failed");
+      shard_close(c);
+      return -1;
+    }
+    ShardConn *conn = &c->conns[i];
+    shard_range(n, shard_num, i, &conn->begin, &conn->end);
+    pid_t pid = fork();
+    if (pid < 0) {
+      perror("Shard fork failed");
+      close(fds[0]);
+      close(fds[1]);
+      shard_close(c);
+      return -1;
+    }
+    if (pid == 0) {
+      // Worker: keep only its own end
+      for (int j = 0; j < i; j++) {
+        close(c->conns[j].fd);
+      }
+      close(fds[0]);
+      omp_set_num_threads(thread_num);
+      int ret = shard_serve(fds[1], seed, conn->begin, conn->end);
+      close(fds[1]);
+      _exit(ret == 0 ? 0 : 1);
+    }
+    close(fds[1]);
+    conn->fd = fds[0];
+    conn->pid = pid;
+    c->shard_num++;
+  }
+  return 0;
+}
+
+int shard_attach(ShardCluster *c, int fd) {
+  c->n = 0;
+  c->shard_num = 0;
+  c->conns = (ShardConn *)malloc(sizeof(ShardConn));
+  if (c->conns == NULL) return -1;
+  ShardConn conn = {fd, 0, 0, 0};
+  c->conns[0] = conn;
+  c->shard_num = 1;
+  return 0;
+}
+
+int shard_round_score(ShardCluster *c, uint64_t r_0, uint64_t r_1) {
+  ShardMsgHeader hdr = {kShardOpScore, kShardBitlen};
+  uint64_t r[2] = {r_0, r_1};
+  for (int i = 0; i < c->shard_num; i++) {
+    int fd = c->conns[i].fd;
+    if (send_all(fd, &hdr, sizeof(hdr)) != 0 || send_all(fd, r, sizeof(r)) != 0) {
+      fprintf(stderr, "Shard %d send failed\n", i);
+      return -1;
+    }
+  }
+  for (int i = 0; i < c->shard_num; i++) {
+    uint8_t reply[kLambda];
+    if (recv_all(c->conns[i].fd, reply, kLambda) != 0) {
+      fprintf(stderr, "Shard %d recv failed\n", i);
+      return -1;
+    }
+  }
+  return 0;
+}
+
+int shard_round(ShardCluster *c, int op, Key k, const uint8_t *s0, const uint8_t *w, uint8_t *count) {
+  ShardMsgHeader hdr = {(uint32_t)op, kShardBitlen};
+  // Broadcast first, so all shards eval at the same time
+  for (int i = 0; i < c->shard_num; i++) {
+    int fd = c->conns[i].fd;
+    if (send_all(fd, &hdr, sizeof(hdr)) != 0 || send_all(fd, s0, kLambda) != 0 ||
+      send_all(fd, k.cw_np1, kLambda) != 0 || send_all(fd, k.cws, kDcfCwLen * kShardBitlen) != 0 ||
+      (op == kShardOpGe && send_all(fd, w, kLambda) != 0)) {
+      fprintf(stderr, "Shard %d send failed\n", i);
+      return -1;
+    }
+  }
+
+  if (count != NULL) group_zero(count);
+  for (int i = 0; i < c->shard_num; i++) {
+    uint8_t partial[kLambda];
+    if (recv_all(c->conns[i].fd, partial, kLambda) != 0) {
+      fprintf(stderr, "Shard %d recv failed\n", i);
+      return -1;
+    }
+    if (count != NULL) group_add(count, partial);
+  }
+  return 0;
+}
+
+void shard_close(ShardCluster *c) {
+  ShardMsgHeader hdr = {kShardOpQuit, kShardBitlen};
+  for (int i = 0; i < c->shard_num; i++) {
+    send_all(c->conns[i].fd, &hdr, sizeof(hdr));
+    close(c->conns[i].fd);
+  }
+  for (int i = 0; i < c->shard_num; i++) {
+    if (c->conns[i].pid > 0) waitpid(c->conns[i].pid, NULL, 0);
+  }
+  free(c->conns);
+  c->conns = NULL;
+  c->shard_num = 0;
+}
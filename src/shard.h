@@ -0,0 +1,209 @@
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @file shard.h
+ *
+ * Retrieval over docs sharded across worker processes, as party 0 of retrieval.c.
+ *
+ * Shard `i` of `shard_num` holds docs `[n * i / shard_num, n * (i + 1) / shard_num)`, rounded down to even.
+ * Each worker is dealt the data of its own docs from a shared seed, so no doc data crosses the wire
+ * and a shard only needs memory for its docs:
+ * party 0's shares of the @ref kShardDim embeddings over the field mod @ref kRngFieldPrime,
+ * its Beaver triples as a seed of @ref preproc_expand(), where doc `j` uses `[j * kShardDim, (j + 1) * kShardDim)`,
+ * and party 1's side, which is simulated as in retrieval.c: its parts of the opened differences and its score shares.
+ * The plain embeddings are the elements of stream 0 of @ref rng_keystream() reduced mod @ref kRngFieldPrime,
+ * where the query is `[0, kShardDim)` and doc `j` is `[(j + 1) * kShardDim, (j + 2) * kShardDim)`,
+ * and party 0's shares are those of stream 1. There is 1 query per seed.
+ *
+ * Per query, a @ref kShardOpScore round has each worker compute its shares of the scores [d_j] with the triples and open
+ * d_j + r. Then per round, the coordinator broadcasts the key and each worker evals it at its docs and replies its
+ * partial sum, which the coordinator adds to the share of the count. A message is
+ *
+ *     | ShardMsgHeader | s0 | cw_np1 | cws | w |
+ *
+ * where `w` is only for @ref kShardOpGe, or `| ShardMsgHeader | r_0 | r_1 |` for @ref kShardOpScore,
+ * and a reply is 1 group element.
+ * The wire is any stream socket: @ref shard_spawn() forks workers on `AF_UNIX` socket pairs,
+ * while @ref shard_serve() takes a connected fd, e.g., of TCP to a worker on another host.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <fss/dcf.h>
+#include "preproc.h"
+#include "rand.h"
+#include "workspace.h"
+
+/**
+ * Bitlen of the inputs, which are elements mod @ref kRngFieldPrime
+ */
+#define kShardBitlen 64
+
+/**
+ * Dim of the embeddings, lower than that of retrieval.c so that the dealt data of a shard fits in memory. Even.
+ */
+#define kShardDim 64
+
+enum {
+  /**
+   * Score all docs and open the scores masked by the shares `r_0` and `r_1` of the mask `r` of the following keys
+   */
+  kShardOpScore = 1,
+  /**
+   * Eval the base key of @ref ic_gen_base() at all docs and keep the outputs for the following rounds
+   */
+  kShardOpBase = 2,
+  /**
+   * Eval the key of @ref ic_gen_ge() at all docs and reply the sum
+   */
+  kShardOpGe = 3,
+  kShardOpQuit = 4,
+};
+
+typedef struct {
+  uint32_t op;
+  uint32_t bitlen;
+} ShardMsgHeader;
+
+typedef struct {
+  int fd;
+  /**
+   * Pid of the worker, or 0 if it is not a child, e.g., a daemon
+   */
+  pid_t pid;
+  size_t begin, end;
+} ShardConn;
+
+typedef struct {
+  size_t n;
+  int shard_num;
+  ShardConn *conns;
+} ShardCluster;
+
+/**
+ * Docs `[begin, end)` of shard `i`
+ */
+void shard_range(size_t n, int shard_num, int i, size_t *begin, size_t *end);
+
+/**
+ * Worker's docs and the buffers of its rounds, which outlive connections
+ */
+typedef struct {
+  size_t begin, doc_num;
+  /**
+   * Party 0's shares of the query, and of the embeddings of the docs, `kShardDim` per doc
+   */
+  uint64_t query_0[kShardDim];
+  uint64_t *docs_0;
+  /**
+   * Party 1's parts of the opened query - x and doc - y, `kShardDim` per doc
+   */
+  uint64_t *ds_1, *es_1;
+  /**
+   * Party 1's share of the score per doc
+   */
+  uint64_t *scores_1;
+  uint8_t triple_seed[kPreprocSeedLen];
+  /**
+   * Masked scores per doc of the last @ref kShardOpScore
+   */
+  uint64_t *xs;
+  /**
+   * Evals of the last base key per doc
+   */
+  uint8_t *ys_base;
+  uint8_t *msg;
+  /**
+   * `sbuf` of evals per thread
+   */
+  Workspace ws;
+  int has_scores, has_base;
+} ShardState;
+
+/**
+ * Worker: deal the data of docs `[begin, end)`, where `begin` is even, and allocate the buffers
+ * @return 0, or -1 if the allocation fails
+ */
+int shard_load(ShardState *st, const uint8_t *seed, size_t begin, size_t end);
+
+/**
+ * Worker: compute party 0's shares of the scores of all docs with OpenMP threads of this process,
+ * and open them masked by `r_0 + r_1`
+ */
+void shard_score(ShardState *st, uint64_t r_0, uint64_t r_1);
+
+void shard_unload(ShardState *st);
+
+/**
+ * Worker: eval 1 round at all docs with OpenMP threads of this process, after @ref shard_score()
+ * @param sum Output sum of the evals for @ref kShardOpGe, zero for @ref kShardOpBase
+ */
+void shard_eval(ShardState *st, int op, Key k, const uint8_t *s0, const uint8_t *w, uint8_t *sum);
+
+/**
+ * Worker: serve rounds on `fd` until @ref kShardOpQuit or the coordinator hangs up
+ * @return 0, or -1 on a broken message
+ */
+int shard_serve_conn(ShardState *st, int fd);
+
+/**
+ * Worker: serve rounds on `fd` for docs `[begin, end)` until @ref kShardOpQuit or the coordinator hangs up.
+ * The same as @ref shard_load(), @ref shard_serve_conn() and @ref shard_unload().
+ * @return 0, or -1 on failure
+ */
+int shard_serve(int fd, const uint8_t *seed, size_t begin, size_t end);
+
+/**
+ * Coordinator: fork `shard_num` workers on local socket pairs, each with `thread_num` OpenMP threads.
+ * Call it before any OpenMP parallel region of this process, as the OpenMP runtime does not survive a fork.
+ * @ref prg_init() must be called already, which the workers inherit.
+ * @return 0, or -1 if a worker cannot be started
+ */
+int shard_spawn(ShardCluster *c, const uint8_t *seed, size_t n, int shard_num, int thread_num);
+
+/**
+ * Coordinator: a cluster of 1 worker already connected on `fd`, e.g., a daemon, whose docs are unknown.
+ * @ref shard_close() closes `fd`.
+ * @return 0, or -1 if the allocation fails
+ */
+int shard_attach(ShardCluster *c, int fd);
+
+/**
+ * Coordinator: run 1 round on all shards and add their partial sums.
+ * @param s0 Party 0's seed of `k`
+ * @param w Party 0's share of `w` of @ref ic_gen_ge() for @ref kShardOpGe, otherwise NULL
+ * @param count Output share of the count for @ref kShardOpGe
+ * @return 0, or -1 if a worker fails
+ */
+int shard_round(ShardCluster *c, int op, Key k, const uint8_t *s0, const uint8_t *w, uint8_t *count);
+
+/**
+ * Check: party 1's share of the count of 1 @ref kShardOpGe round over docs `[0, n)`, with 1 thread.
+ * Its inputs are the same masked scores d_j + `r` as the workers'.
+ * @param s_base Both parties' seeds of `key_base` before gen, of which party 1's is the 2nd
+ * @param s_ge The same of `key_ge`
+ * @param w1 Party 1's share of `w` of @ref ic_gen_ge()
+ */
+void shard_count_1(uint8_t *count, const uint8_t *seed, size_t n, uint64_t r, Key key_base, const uint8_t *s_base,
+  Key key_ge, const uint8_t *s_ge, const uint8_t *w1);
+
+/**
+ * Check: the plain count of docs `[0, n)` whose score is >= `c`, which the 2 shares of the count open to
+ */
+uint64_t shard_plain_count(const uint8_t *seed, size_t n, uint64_t c);
+
+/**
+ * Coordinator: run the @ref kShardOpScore round of 1 query on all shards.
+ * @param r_0 Party 0's share of the mask
+ * @param r_1 Party 1's share of the mask
+ * @return 0, or -1 if a worker fails
+ */
+int shard_round_score(ShardCluster *c, uint64_t r_0, uint64_t r_1);
+
+/**
+ * Coordinator: tell the workers to quit and wait for them
+ */
+void shard_close(ShardCluster *c);
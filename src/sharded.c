@@ -0,0 +1,140 @@
+// For real-time extensions
+#define _POSIX_C_SOURCE 199309L
+
+// A retrieval query over N docs sharded across 1, 2, 4, ... worker processes on local sockets. See shard.h.
+// Usage: sharded_benchmark [max_shards] [n]
+
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <omp.h>
+#include <fss/dcf.h>
+#include <fss/ic.h>
+#include <fss/group.h>
+#include <fss/prg.h>
+#include "rand.h"
+#include "shard.h"
+
+#define kSeed 114514
+#define kStep 13  // Number of binary search steps
+
+static inline double get_time() {
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1.0e-9;
+}
+
+int main(int argc, char **argv) {
+  int max_shard_num = argc > 1 ? atoi(argv[1]) : 8;
+  size_t n = argc > 2 ? strtoull(argv[2], NULL, 10) : 16384;
+  assert(max_shard_num > 0 && n >= 2 * (size_t)max_shard_num);
+
+  uint64_t seed[2] = {kSeed, 0};
+  Rng rng;
+  rng_init(&rng, (uint8_t *)seed, 0);
+  uint8_t keys[4 * kLambda];
+  rng_fill_bytes(&rng, keys, sizeof(keys));
+  prg_init(keys, sizeof(keys));
+  uint8_t doc_seed[kRngSeedLen];
+  rng_fill_bytes(&rng, doc_seed, kRngSeedLen);
+
+  // Reading the ICV does not start the OpenMP runtime's threads, so forking later is fine
+  int thread_num = omp_get_max_threads();
+  printf("Thread num: %d\n", thread_num);
+  printf("PRG kernel: %s\n", prg_name());
+  printf("N (Docs): %zu\n", n);
+  printf("Steps: %d\n", kStep);
+
+  Key key_base, key_ge;
+  key_base.cw_np1 = (uint8_t *)malloc(kLambda);
+  key_base.cws = (uint8_t *)malloc(kDcfCwLen * kShardBitlen);
+  key_ge.cw_np1 = (uint8_t *)malloc(kLambda);
+  key_ge.cws = (uint8_t *)malloc(kDcfCwLen * kShardBitlen);
+  // Gen overwrites its seeds, so the seeds s0 and s1 of each key are kept aside
+  uint8_t *sbuf_gen = (uint8_t *)malloc(kLambda * 10);
+  uint8_t s_base[2 * kLambda], s_ge[2 * kLambda];
+  assert(key_base.cw_np1 != NULL && key_base.cws != NULL && key_ge.cw_np1 != NULL && key_ge.cws != NULL &&
+    sbuf_gen != NULL);
+
+  // Share of the count of each step of 1 shard, which more shards must match
+  uint64_t counts_1[kStep];
+
+  printf("shards,threads_per_shard,query_ms,round_ms,docs_s\n");
+  for (int shard_num = 1; shard_num <= max_shard_num; shard_num *= 2) {
+    int shard_thread_num = thread_num / shard_num > 0 ? thread_num / shard_num : 1;
+    ShardCluster c;
+    int ret = shard_spawn(&c, doc_seed, n, shard_num, shard_thread_num);
+    assert(ret == 0);
+
+    // The same keys for every shard num
+    Rng rng_user;
+    rng_init(&rng_user, (uint8_t *)seed, 1);
+
+    double t_start = get_time();
+    uint64_t r = rng_field(&rng_user);
+    // Shares of the mask for the 2 parties' opens of the scores
+    uint64_t r_0 = rng_field(&rng_user);
+    uint64_t r_1 = r >= r_0 ? r - r_0 : r + (kRngFieldPrime - r_0);
+    ret = shard_round_score(&c, r_0, r_1);
+    assert(ret == 0);
+    Bits r_bits = {(uint8_t *)&r, kShardBitlen};
+    rng_fill_bytes(&rng_user, s_base, 2 * kLambda);
+    memcpy(sbuf_gen, s_base, 2 * kLambda);
+    ic_gen_base(key_base, r_bits, sbuf_gen);
+    ret = shard_round(&c, kShardOpBase, key_base, s_base, NULL, NULL);
+    assert(ret == 0);
+
+    for (int s = 0; s < kStep; s++) {
+      // User Gen (Simulated), as in retrieval.c
+      uint64_t threshold = rng_field(&rng_user);
+      uint8_t w[kLambda], w0[kLambda], w1[kLambda];
+      rng_fill_bytes(&rng_user, s_ge, 2 * kLambda);
+      memcpy(sbuf_gen, s_ge, 2 * kLambda);
+      ic_gen_ge(key_ge, w, r, threshold, kRngFieldPrime, kShardBitlen, sbuf_gen);
+      group_zero(w0);
+      uint64_t w0_u64 = rng_field(&rng_user);
+      memcpy(w0, &w0_u64, sizeof(w0_u64));
+      // w1 = w - w0
+      memcpy(w1, w0, kLambda);
+      group_neg(w1);
+      group_add(w1, w);
+
+      uint8_t count[kLambda];
+      ret = shard_round(&c, kShardOpGe, key_ge, s_ge, w0, count);
+      assert(ret == 0);
+      uint64_t count_u64;
+      memcpy(&count_u64, count, sizeof(count_u64));
+      if (shard_num == 1) counts_1[s] = count_u64;
+      assert(count_u64 == counts_1[s]);
+      (void)count_u64;
+
+      // Open the 1st step's count with party 1's share, out of the timing, so the shares are not only consistent
+      if (shard_num == 1 && s == 0) {
+        double t_check = get_time();
+        uint8_t count_1[kLambda];
+        shard_count_1(count_1, doc_seed, n, r, key_base, s_base, key_ge, s_ge, w1);
+        group_add(count_1, count);
+        uint64_t opened;
+        memcpy(&opened, count_1, sizeof(opened));
+        uint64_t plain = shard_plain_count(doc_seed, n, threshold);
+        fprintf(stderr, "Check: count %lu of %zu docs, plain %lu\n", (unsigned long)opened, n, (unsigned long)plain);
+        assert(opened == plain);
+        t_start += get_time() - t_check;
+      }
+    }
+    double t_query = get_time() - t_start;
+    shard_close(&c);
+
+    printf("%d,%d,%lf,%lf,%lf\n", shard_num, shard_thread_num, t_query * 1e3, t_query / (kStep + 1) * 1e3,
+      n * (kStep + 1) / t_query);
+  }
+
+  free(key_base.cw_np1);
+  free(key_base.cws);
+  free(key_ge.cw_np1);
+  free(key_ge.cws);
+  free(sbuf_gen);
+  return 0;
+}
@@ -0,0 +1,262 @@
+// SPDX-License-Identifier: Apache-2.0
+
+// For gethostname() and real-time extensions
+#define _POSIX_C_SOURCE 200112L
+
+// Auto-tuner of the eval loops on this host, which writes the configuration of fss/tune.h.
+// Each knob is swept with the best of the previous ones: thread num, then eval batch and chunk, then frontier depth,
+// then the grain of full domain eval.
+// Usage: tune [file] [n] [bitlen] [full_domain_bitlen]
+// The file defaults to $FSS_TUNE_FILE, otherwise fss_tune.conf.
+// Run the benchmarks with FSS_TUNE_FILE set to the file to use it.
+
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <unistd.h>
+#include <omp.h>
+#include <fss/dcf.h>
+#include <fss/tune.h>
+#include "rand.h"
+#include "workspace.h"
+
+#define kSeed 114514
+// Timings are the min of the reps, as the box may be noisy
+#define kRepNum 3
+#define kMaxBatch 128
+
+static const int kBatches[] = {1, 8, 32, kMaxBatch};
+static const int kChunks[] = {0, 64, 512, 4096};
+static const int kFrontierDepths[] = {0, 4, 8, 12, 16};
+static const int kGrains[] = {6, 8, 10, 12, 14, 16};
+
+#define kLen(a) ((int)(sizeof(a) / sizeof((a)[0])))
+
+static inline double get_time() {
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1.0e-9;
+}
+
+typedef struct {
+  Key k;
+  uint8_t s0[kLambda];
+  const uint64_t *xs;
+  int n;
+  int bitlen;
+  Workspace *ws;
+  // Of the max frontier depth
+  uint8_t *frontier;
+} EvalBench;
+
+// Eval at all points as the eval loops of cmp.c and retrieval.c do, in seconds per point
+static double time_eval(const EvalBench *e, const TuneConfig *cfg) {
+  tune_apply(cfg);
+  int depth = cfg->frontier_depth;
+  int batch = depth > 0 ? 1 : cfg->eval_batch;
+  int iter_num = (e->n + batch - 1) / batch;
+  tune_set_schedule(cfg, batch);
+  double best = 1e30;
+  for (int rep = 0; rep < kRepNum; rep++) {
+    double t = get_time();
+    if (depth > 0) {
+      memcpy(e->frontier, e->s0, kLambda);
+      dcf_frontier_build(e->frontier, 0, e->k, depth);
+    }
+#pragma omp parallel for schedule(runtime)
+    for (int j = 0; j < iter_num; j++) {
+      uint8_t *sbuf = ws_get(e->ws, omp_get_thread_num());
+      int lo = j * batch;
+      int hi = lo + batch < e->n ? lo + batch : e->n;
+      if (depth > 0) {
+        Bits x = {(uint8_t *)&e->xs[lo], e->bitlen};
+        dcf_eval_frontier(sbuf, 0, e->k, e->frontier, depth, x);
+      } else if (batch == 1) {
+        Bits x = {(uint8_t *)&e->xs[lo], e->bitlen};
+        memcpy(sbuf, e->s0, kLambda);
+        dcf_eval(sbuf, 0, e->k, x);
+      } else {
+        Bits xs[kMaxBatch];
+        for (int i = lo; i < hi; i++) {
+          xs[i - lo].bytes = (uint8_t *)&e->xs[i];
+          xs[i - lo].bitlen = e->bitlen;
+        }
+        memcpy(sbuf, e->s0, kLambda);
+        dcf_eval_batch(sbuf, 0, e->k, xs, hi - lo);
+      }
+    }
+    double t_elapsed = get_time() - t;
+    if (t_elapsed < best) best = t_elapsed;
+  }
+  return best / e->n;
+}
+
+// Full domain eval, in seconds per leaf
+static double time_full_domain(uint8_t *sbuf, const uint8_t *s0, Key k, int bitlen, const TuneConfig *cfg) {
+  tune_apply(cfg);
+  // Warm up, which also (re)creates the pool
+  memcpy(sbuf, s0, kLambda);
+  dcf_eval_full_domain(sbuf, 0, k, bitlen);
+  double best = 1e30;
+  for (int rep = 0; rep < kRepNum; rep++) {
+    double t = get_time();
+    memcpy(sbuf, s0, kLambda);
+    dcf_eval_full_domain(sbuf, 0, k, bitlen);
+    double t_elapsed = get_time() - t;
+    if (t_elapsed < best) best = t_elapsed;
+  }
+  return best / ((size_t)1 << bitlen);
+}
+
+static void report(const char *knob, const TuneConfig *cfg, double t) {
+  printf("%s,%d,%d,%d,%d,%d,%lf\n", knob, cfg->thread_num, cfg->eval_batch, cfg->chunk, cfg->frontier_depth,
+    cfg->full_domain_grain_bitlen, t * 1e9);
+}
+
+int main(int argc, char **argv) {
+  const char *env_path = getenv(kTuneFileEnv);
+  const char *path = argc > 1 ? argv[1] : env_path != NULL && env_path[0] != '\0' ? env_path : "fss_tune.conf";
+  int n = argc > 2 ? atoi(argv[2]) : 1 << 16;
+  int bitlen = argc > 3 ? atoi(argv[3]) : 64;
+  int fd_bitlen = argc > 4 ? atoi(argv[4]) : 20;
+  assert(n > 0 && bitlen > 0 && bitlen <= 64 && fd_bitlen > 0 && fd_bitlen <= 30);
+
+  uint64_t seed[2] = {kSeed, 0};
+  Rng rng;
+  rng_init(&rng, (uint8_t *)seed, 0);
+  uint8_t keys[4 * kLambda];
+  rng_fill_bytes(&rng, keys, sizeof(keys));
+  prg_init(keys, sizeof(keys));
+
+  int max_threads = omp_get_max_threads();
+  printf("Max thread num: %d\n", max_threads);
+  printf("PRG kernel: %s\n", prg_name());
+  printf("N: %d, bitlen: %d, full domain bitlen: %d\n", n, bitlen, fd_bitlen);
+
+  // 1 key for all timings
+  uint8_t s0s[2 * kLambda];
+  rng_fill_bytes(&rng, s0s, sizeof(s0s));
+  uint64_t alpha = rng_field(&rng);
+  uint8_t beta[kLambda];
+  memset(beta, 0, kLambda);
+  rng_fill_bytes(&rng, beta, 8);
+  Key k;
+  k.cw_np1 = (uint8_t *)malloc(kLambda);
+  k.cws = (uint8_t *)malloc(kDcfCwLen * 64);
+  assert(k.cw_np1 != NULL && k.cws != NULL);
+  uint8_t sbuf_gen[kLambda * 10];
+  memcpy(sbuf_gen, s0s, sizeof(s0s));
+  Bits alpha_bits = {(uint8_t *)&alpha, bitlen};
+  CmpFunc cf = {{alpha_bits, beta}, kLtAlpha};
+  dcf_gen(k, cf, sbuf_gen);
+
+  uint64_t *xs = (uint64_t *)malloc(n * sizeof(uint64_t));
+  assert(xs != NULL);
+  rng_fill_field(&rng, xs, n);
+  // Slices for the max thread num serve any fewer
+  Workspace ws;
+  ws_open(&ws, kMaxBatch * (6 * kLambda + 1));
+  int max_depth = kFrontierDepths[kLen(kFrontierDepths) - 1];
+  uint8_t *frontier = (uint8_t *)malloc((size_t)kDcfFrontierNodeLen << max_depth);
+  assert(frontier != NULL);
+  EvalBench e = {k, {0}, xs, n, bitlen, &ws, frontier};
+  memcpy(e.s0, s0s, kLambda);
+
+  TuneConfig best;
+  tune_default(&best);
+  best.full_domain_grain_bitlen = 12;
+  TuneConfig cfg;
+  printf("knob,thread_num,eval_batch,chunk,frontier_depth,grain_bitlen,ns\n");
+
+  // Powers of 2 then the max if it is not one
+  double t_best = 1e30;
+  for (int threads = 1; threads <= max_threads; threads = threads * 2 > max_threads && threads != max_threads ? max_threads : threads * 2) {
+    cfg = best;
+    cfg.thread_num = threads;
+    double t = time_eval(&e, &cfg);
+    report("thread_num", &cfg, t);
+    if (t < t_best) {
+      t_best = t;
+      best.thread_num = threads;
+    }
+    if (threads == max_threads) break;
+  }
+
+  t_best = 1e30;
+  TuneConfig best_strategy = best;
+  for (int i = 0; i < kLen(kBatches); i++) {
+    for (int j = 0; j < kLen(kChunks); j++) {
+      cfg = best;
+      cfg.eval_batch = kBatches[i];
+      cfg.chunk = kChunks[j];
+      double t = time_eval(&e, &cfg);
+      report("eval_batch/chunk", &cfg, t);
+      if (t < t_best) {
+        t_best = t;
+        best_strategy = cfg;
+      }
+    }
+  }
+  best = best_strategy;
+
+  // Against the best plain eval, as the frontier costs its build per key
+  for (int i = 0; i < kLen(kFrontierDepths); i++) {
+    if (kFrontierDepths[i] == 0 || kFrontierDepths[i] > bitlen) continue;
+    cfg = best;
+    cfg.frontier_depth = kFrontierDepths[i];
+    double t = time_eval(&e, &cfg);
+    report("frontier_depth", &cfg, t);
+    if (t < t_best) {
+      t_best = t;
+      best.frontier_depth = cfg.frontier_depth;
+    }
+  }
+
+  // Full domain eval needs its own key of the domain bitlen
+  uint8_t *sbuf_fd = (uint8_t *)malloc(kLambda * ((size_t)1 << fd_bitlen));
+  assert(sbuf_fd != NULL);
+  Bits alpha_fd = {(uint8_t *)&alpha, fd_bitlen};
+  CmpFunc cf_fd = {{alpha_fd, beta}, kLtAlpha};
+  memcpy(sbuf_gen, s0s, sizeof(s0s));
+  dcf_gen(k, cf_fd, sbuf_gen);
+  t_best = 1e30;
+  int best_grain = best.full_domain_grain_bitlen;
+  for (int i = 0; i < kLen(kGrains); i++) {
+    if (kGrains[i] > fd_bitlen) continue;
+    cfg = best;
+    cfg.full_domain_grain_bitlen = kGrains[i];
+    double t = time_full_domain(sbuf_fd, s0s, k, fd_bitlen, &cfg);
+    report("full_domain_grain_bitlen", &cfg, t);
+    if (t < t_best) {
+      t_best = t;
+      best_grain = kGrains[i];
+    }
+  }
+  best.full_domain_grain_bitlen = best_grain;
+
+  char host[64] = "unknown";
+  gethostname(host, sizeof(host));
+  host[sizeof(host) - 1] = '\0';
+  char comment[256];
+  snprintf(comment, sizeof(comment), "Tuned on %s of %d threads with PRG kernel %s\nN = %d, bitlen = %d, full domain bitlen = %d",
+    host, max_threads, prg_name(), n, bitlen, fd_bitlen);
+  int ret = tune_save(&best, path, comment);
+  if (ret == 0) {
+    printf("Chose thread_num = %d, eval_batch = %d, chunk = %d, frontier_depth = %d, full_domain_grain_bitlen = %d\n",
+      best.thread_num, best.eval_batch, best.chunk, best.frontier_depth, best.full_domain_grain_bitlen);
+    printf("Saved to %s\n", path);
+  } else {
+    perror("Tune save failed");
+  }
+
+  prg_free();
+  ws_close(&ws);
+  free(frontier);
+  free(sbuf_fd);
+  free(xs);
+  free(k.cw_np1);
+  free(k.cws);
+  return ret == 0 ? 0 : 1;
+}
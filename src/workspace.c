@@ -0,0 +1,86 @@
+// SPDX-License-Identifier: Apache-2.0
+
+// For MAP_ANONYMOUS and madvise()
+#define _GNU_SOURCE
+
+#include "workspace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+
+#define kHugePageLen (2 << 20)
+
+#ifdef __linux__
+  #include <unistd.h>
+  #include <sys/mman.h>
+
+static int ws_huge_enabled() {
+  const char *env = getenv("FSS_WS_HUGE");
+  return env != NULL && strcmp(env, "0") != 0;
+}
+
+void ws_open(Workspace *ws, size_t len) {
+  ws->thread_num = omp_get_max_threads();
+  ws->huge = ws_huge_enabled();
+  size_t page_len = ws->huge ? kHugePageLen : (size_t)sysconf(_SC_PAGESIZE);
+  ws->stride = (len + page_len - 1) / page_len * page_len;
+  if (ws->stride == 0) ws->stride = page_len;
+
+  // mmap() only reserves, so no page is placed until the first touch below
+  size_t total = ws->stride * ws->thread_num;
+  void *p = mmap(NULL, total + (ws->huge ? kHugePageLen : 0), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED) {
+    perror("Workspace mmap failed");
+    exit(1);
+  }
+  ws->base = (uint8_t *)p;
+  if (ws->huge) {
+    // Align to a huge page and give the slack back
+    uintptr_t addr = (uintptr_t)p;
+    uintptr_t aligned = (addr + kHugePageLen - 1) / kHugePageLen * kHugePageLen;
+    size_t head = aligned - addr;
+    if (head > 0) munmap(p, head);
+    if (kHugePageLen - head > 0) munmap((void *)(aligned + total), kHugePageLen - head);
+    ws->base = (uint8_t *)aligned;
+    if (madvise(ws->base, total, MADV_HUGEPAGE) != 0) {
+      perror("Workspace huge pages unavailable");
+      ws->huge = 0;
+    }
+  }
+
+#pragma omp parallel num_threads(ws->thread_num)
+  {
+    memset(ws_get(ws, omp_get_thread_num()), 0, ws->stride);
+  }
+}
+
+void ws_close(Workspace *ws) {
+  if (ws->base != NULL) munmap(ws->base, ws->stride * ws->thread_num);
+  ws->base = NULL;
+}
+
+#else
+
+void ws_open(Workspace *ws, size_t len) {
+  ws->thread_num = omp_get_max_threads();
+  ws->huge = 0;
+  ws->stride = (len + 4095) / 4096 * 4096;
+  if (ws->stride == 0) ws->stride = 4096;
+  ws->base = (uint8_t *)aligned_alloc(4096, ws->stride * ws->thread_num);
+  if (ws->base == NULL) {
+    perror("Workspace alloc failed");
+    exit(1);
+  }
+#pragma omp parallel num_threads(ws->thread_num)
+  {
+    memset(ws_get(ws, omp_get_thread_num()), 0, ws->stride);
+  }
+}
+
+void ws_close(Workspace *ws) {
+  free(ws->base);
+  ws->base = NULL;
+}
+
+#endif
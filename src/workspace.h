@@ -0,0 +1,44 @@
+// SPDX-License-Identifier: Apache-2.0
+
+/**
+ * @file workspace.h
+ *
+ * Per-thread scratch for benchmarks, e.g., `sbuf` of @ref dcf_eval() in an OpenMP parallel loop.
+ * Each OpenMP thread gets its own slice starting at a page boundary, so no 2 threads share a cache line or a page.
+ * Each slice is first touched by its thread, so under the default first-touch policy its pages are on the NUMA node of the thread.
+ * Bind threads (e.g., `OMP_PROC_BIND=close`) so that they stay on that node.
+ * With env `FSS_WS_HUGE` set and not `0`, slices are padded to 2 MiB and backed by transparent huge pages when the kernel allows.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+  uint8_t *base;
+  /**
+   * Bytes from a slice to the next, a multiple of the page size
+   */
+  size_t stride;
+  int thread_num;
+  /**
+   * 1 if backed by huge pages
+   */
+  int huge;
+} Workspace;
+
+/**
+ * Allocate a slice of at least `len` bytes for each thread of the following OpenMP parallel regions and zero it in its thread.
+ * Exit if the allocation fails.
+ */
+void ws_open(Workspace *ws, size_t len);
+
+/**
+ * Slice of thread `tid`, i.e., `omp_get_thread_num()`
+ */
+static inline uint8_t *ws_get(const Workspace *ws, int tid) {
+  return ws->base + ws->stride * tid;
+}
+
+void ws_close(Workspace *ws);